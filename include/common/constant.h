@@ -12,6 +12,14 @@ enum class OrderSide {
     SELL = 1
 };
 
+// Side that initiated a trade print
+enum class AggressorSide {
+    UNKNOWN = 0,
+    BUY = 1,        // lifted the offer
+    SELL = 2,       // hit the bid
+    NEUTRAL = 3     // e.g. auction matches
+};
+
 // Order type
 enum class OrderType {
     LIMIT = 0,
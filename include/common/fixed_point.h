@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
+#include <ostream>
+
+// Share / contract count. A distinct type so quantities cannot be mixed up
+// with prices or raw ints on the trading path. Signed: negative = short/sell.
+class Quantity {
+public:
+    constexpr Quantity() = default;
+    constexpr explicit Quantity(int64_t value) : value_(value) {}
+
+    constexpr int64_t value() const { return value_; }
+    constexpr bool isZero() const { return value_ == 0; }
+    constexpr bool isPositive() const { return value_ > 0; }
+    constexpr Quantity abs() const { return Quantity(value_ < 0 ? -value_ : value_); }
+
+    constexpr Quantity operator-() const { return Quantity(-value_); }
+    constexpr Quantity operator+(Quantity o) const { return Quantity(value_ + o.value_); }
+    constexpr Quantity operator-(Quantity o) const { return Quantity(value_ - o.value_); }
+    Quantity& operator+=(Quantity o) { value_ += o.value_; return *this; }
+    Quantity& operator-=(Quantity o) { value_ -= o.value_; return *this; }
+
+    constexpr bool operator==(Quantity o) const { return value_ == o.value_; }
+    constexpr bool operator!=(Quantity o) const { return value_ != o.value_; }
+    constexpr bool operator<(Quantity o) const { return value_ < o.value_; }
+    constexpr bool operator<=(Quantity o) const { return value_ <= o.value_; }
+    constexpr bool operator>(Quantity o) const { return value_ > o.value_; }
+    constexpr bool operator>=(Quantity o) const { return value_ >= o.value_; }
+
+private:
+    int64_t value_ = 0;
+};
+
+// Fixed-point decimal with 6 fractional digits (1 raw unit = 1e-6).
+// Fine enough for every HK/US/CN tick size, so prices from different
+// instruments compare and accumulate exactly. Exchange adapters convert from
+// and to double at the API boundary only.
+class Price {
+public:
+    static constexpr int64_t kScale = 1000000;
+
+    constexpr Price() = default;
+
+    static constexpr Price fromRaw(int64_t raw) { return Price(raw); }
+    static Price fromDouble(double value) { return Price(std::llround(value * kScale)); }
+
+    constexpr int64_t raw() const { return raw_; }
+    double toDouble() const { return static_cast<double>(raw_) / kScale; }
+
+    constexpr bool isZero() const { return raw_ == 0; }
+    constexpr bool isPositive() const { return raw_ > 0; }
+    constexpr Price abs() const { return Price(raw_ < 0 ? -raw_ : raw_); }
+
+    constexpr Price operator-() const { return Price(-raw_); }
+    constexpr Price operator+(Price o) const { return Price(raw_ + o.raw_); }
+    constexpr Price operator-(Price o) const { return Price(raw_ - o.raw_); }
+    Price& operator+=(Price o) { raw_ += o.raw_; return *this; }
+    Price& operator-=(Price o) { raw_ -= o.raw_; return *this; }
+
+    constexpr bool operator==(Price o) const { return raw_ == o.raw_; }
+    constexpr bool operator!=(Price o) const { return raw_ != o.raw_; }
+    constexpr bool operator<(Price o) const { return raw_ < o.raw_; }
+    constexpr bool operator<=(Price o) const { return raw_ <= o.raw_; }
+    constexpr bool operator>(Price o) const { return raw_ > o.raw_; }
+    constexpr bool operator>=(Price o) const { return raw_ >= o.raw_; }
+
+    // Ratio of two fixed-point values (e.g. P/L over cost)
+    double ratio(Price denominator) const {
+        return denominator.raw_ != 0 ? static_cast<double>(raw_) / denominator.raw_ : 0.0;
+    }
+
+private:
+    constexpr explicit Price(int64_t raw) : raw_(raw) {}
+
+    int64_t raw_ = 0;
+};
+
+// Cash amounts (cost, market value, P/L) share the price scale
+using Amount = Price;
+
+// price * quantity, exact
+inline Amount operator*(Price price, Quantity quantity) {
+    return Amount::fromRaw(price.raw() * quantity.value());
+}
+
+// amount / quantity, rounded half away from zero to the fixed-point unit
+inline Price averagePrice(Amount amount, Quantity quantity) {
+    if (quantity.isZero()) return Price();
+    int64_t q = quantity.value();
+    int64_t raw = amount.raw();
+    int64_t quotient = raw / q;
+    int64_t remainder = raw % q;
+    if (2 * std::llabs(remainder) >= std::llabs(q)) {
+        quotient += ((raw < 0) == (q < 0)) ? 1 : -1;
+    }
+    return Price::fromRaw(quotient);
+}
+
+// amount * numerator / denominator without overflowing the intermediate product
+inline Amount scaleAmount(Amount amount, Quantity numerator, Quantity denominator) {
+    if (denominator.isZero()) return Amount();
+    int64_t raw = amount.raw();
+    int64_t den = denominator.value();
+    int64_t num = numerator.value();
+    return Amount::fromRaw((raw / den) * num + (raw % den) * num / den);
+}
+
+// Round to a multiple of `tick` (nearest, ties away from zero)
+inline Price roundToTick(Price price, Price tick) {
+    if (tick.raw() <= 0) return price;
+    int64_t t = tick.raw();
+    int64_t raw = price.raw();
+    int64_t half = t / 2;
+    int64_t ticks = raw >= 0 ? (raw + half) / t : -((-raw + half) / t);
+    return Price::fromRaw(ticks * t);
+}
+
+inline std::ostream& operator<<(std::ostream& os, Quantity quantity) {
+    return os << quantity.value();
+}
+
+inline std::ostream& operator<<(std::ostream& os, Price price) {
+    return os << price.toDouble();
+}
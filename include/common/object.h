@@ -3,16 +3,65 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <type_traits>
 #include "constant.h"
+#include "symbol_registry.h"
+#include "fixed_point.h"
 #include "utils/logger_defines.h"
+#include "utils/exchange_time.h"
 
 
+// One price level of the book; price and volume interleaved so a level is a
+// single 16-byte load
+struct DepthLevel {
+    double price = 0.0;
+    int64_t volume = 0;
+};
+
+// Fixed-depth book stored inline (no heap), sized to whole cache lines.
+// Trivially copyable, so a book copies with memcpy and can live in pools/rings.
+struct alignas(64) DepthBook {
+    static constexpr size_t kMaxDepth = 10;
+
+    DepthLevel bids[kMaxDepth];
+    DepthLevel asks[kMaxDepth];
+    uint8_t bid_count = 0;
+    uint8_t ask_count = 0;
+
+    void setBid(size_t level, double price, int64_t volume) {
+        if (level >= kMaxDepth) return;
+        bids[level].price = price;
+        bids[level].volume = volume;
+        if (level >= bid_count) bid_count = static_cast<uint8_t>(level + 1);
+    }
+
+    void setAsk(size_t level, double price, int64_t volume) {
+        if (level >= kMaxDepth) return;
+        asks[level].price = price;
+        asks[level].volume = volume;
+        if (level >= ask_count) ask_count = static_cast<uint8_t>(level + 1);
+    }
+
+    void clear() {
+        bid_count = 0;
+        ask_count = 0;
+    }
+};
+static_assert(std::is_trivially_copyable<DepthBook>::value, "DepthBook must stay memcpy-able");
+static_assert(sizeof(DepthBook) % 64 == 0, "DepthBook must occupy whole cache lines");
+
 // Tick data (unified format)
 struct TickData {
+    SymbolId symbol_id = kInvalidSymbolId;   // assigned by the exchange adapter
     std::string symbol;
     std::string exchange;
-    int64_t timestamp;
-    std::string datetime;
+    int64_t exchange_ts_ns = 0;              // exchange time, epoch ns
+    int64_t local_ts_ns = 0;                 // local receive time, epoch ns
+    int32_t utc_offset_sec = 0;              // exchange wall clock offset, for display
+
+    // Exchange-local "YYYY-MM-DD HH:MM:SS.mmm", formatted on demand
+    std::string datetime() const { return exchange_time::format(exchange_ts_ns, utc_offset_sec); }
 
     double last_price = 0.0;
     double open_price = 0.0;
@@ -27,22 +76,53 @@ struct TickData {
     double bid_price_1 = 0.0;
     int64_t bid_volume_1 = 0;
     double ask_price_1 = 0.0;
-    int64_t ask_volume_1 = 0;
+    int64_t ask_volume_1 = 0;                // deeper levels arrive as DepthData
+};
+
+// Market trade print (EVENT_TRADE payload); our own fills are TradeData
+struct TradePrint {
+    SymbolId symbol_id = kInvalidSymbolId;   // assigned by the exchange adapter
+    std::string symbol;
+    std::string exchange;
+    int64_t exchange_ts_ns = 0;              // exchange time, epoch ns
+    int64_t local_ts_ns = 0;                 // local receive time, epoch ns
+    int32_t utc_offset_sec = 0;
+
+    std::string datetime() const { return exchange_time::format(exchange_ts_ns, utc_offset_sec); }
+
+    double price = 0.0;
+    int64_t volume = 0;
+    double turnover = 0.0;
+    AggressorSide side = AggressorSide::UNKNOWN;
+    int64_t sequence = 0;                    // exchange print sequence, 0 if not provided
+};
+
+// Order book push (EVENT_DEPTH payload)
+struct DepthData {
+    SymbolId symbol_id = kInvalidSymbolId;   // assigned by the exchange adapter
+    std::string symbol;
+    std::string exchange;
+    int64_t exchange_ts_ns = 0;              // exchange time, epoch ns
+    int64_t local_ts_ns = 0;                 // local receive time, epoch ns
+    int32_t utc_offset_sec = 0;
 
-    std::vector<double> bid_prices;
-    std::vector<int64_t> bid_volumes;
-    std::vector<double> ask_prices;
-    std::vector<int64_t> ask_volumes;
+    std::string datetime() const { return exchange_time::format(exchange_ts_ns, utc_offset_sec); }
+
+    DepthBook book;     // full book as pushed, best level first
 };
 
 // Kline data (unified format)
 struct KlineData {
+    SymbolId symbol_id = kInvalidSymbolId;   // assigned by the exchange adapter
     std::string symbol;
     std::string exchange;
-    int64_t timestamp;
-    std::string datetime;
+    int64_t exchange_ts_ns = 0;              // bar time reported by the exchange, epoch ns
+    int64_t local_ts_ns = 0;                 // local receive time, epoch ns
+    int32_t utc_offset_sec = 0;
     std::string interval;
 
+    std::string datetime() const { return exchange_time::format(exchange_ts_ns, utc_offset_sec); }
+
     // Corresponding enum interval; keep the string field for external config compatibility
     KlineInterval interval_enum = KlineInterval::K_1M;
 
@@ -65,9 +145,9 @@ struct OrderData {
     OrderType type = OrderType::LIMIT;
     OrderStatus status = OrderStatus::SUBMITTING;
 
-    double price = 0.0;
-    int64_t volume = 0;
-    int64_t traded_volume = 0;
+    Price price;
+    Quantity volume;
+    Quantity traded_volume;
 
     int64_t create_time = 0;
     int64_t update_time = 0;
@@ -146,11 +226,15 @@ struct LogData {
 };
 // Market snapshot (used for market scanning)
 struct Snapshot {
+    SymbolId symbol_id = kInvalidSymbolId;  // Interned (exchange, symbol) id
     std::string symbol;           // Stock symbol
     std::string name;             // Stock name
     std::string exchange;         // Exchange
-    int64_t timestamp;            // Timestamp (milliseconds)
-    std::string datetime;         // Datetime string
+    int64_t exchange_ts_ns = 0;   // Exchange update time (epoch ns)
+    int64_t local_ts_ns = 0;      // Local receive time (epoch ns)
+    int32_t utc_offset_sec = 0;   // Exchange UTC offset
+
+    std::string datetime() const { return exchange_time::format(exchange_ts_ns, utc_offset_sec); }
 
     double last_price = 0.0;      // Latest price
     double open_price = 0.0;      // Open price
@@ -169,4 +253,6 @@ struct Snapshot {
     int64_t bid_volume_1 = 0;     // Best bid volume
     double ask_price_1 = 0.0;     // Best ask price
     int64_t ask_volume_1 = 0;     // Best ask volume
+
+    double tick_size = 0.0;       // Exchange-reported price spread (0 = unknown)
 };
\ No newline at end of file
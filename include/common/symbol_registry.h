@@ -0,0 +1,262 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+
+// Dense 32-bit handle for an (exchange, code) pair
+using SymbolId = uint32_t;
+constexpr SymbolId kInvalidSymbolId = UINT32_MAX;
+
+// Process-wide symbol interning table.
+// Exchange adapters intern symbols once at ingestion and stamp the id on the
+// market data structs; downstream components index their per-symbol state by
+// id instead of hashing or comparing strings on every event.
+// Ids are never reused, and id -> name lookups are lock-free.
+// Header-only so dynamically loaded exchange modules can share the host's
+// instance (see bind()).
+class SymbolRegistry {
+public:
+    static SymbolRegistry& getInstance() {
+        SymbolRegistry* registry = slot().load(std::memory_order_acquire);
+        if (registry == nullptr) {
+            static SymbolRegistry instance;
+            SymbolRegistry* expected = nullptr;
+            slot().compare_exchange_strong(expected, &instance, std::memory_order_acq_rel);
+            registry = slot().load(std::memory_order_acquire);
+        }
+        return *registry;
+    }
+
+    // Point this binary at another binary's registry (called by the host on
+    // each loaded exchange module before creating exchange instances)
+    static void bind(SymbolRegistry* shared) {
+        if (shared != nullptr) {
+            slot().store(shared, std::memory_order_release);
+        }
+    }
+
+    // Returns the id for (exchange, code), assigning a new one if needed
+    SymbolId intern(const std::string& exchange, const std::string& code) {
+        std::string key = makeKey(exchange, code);
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = ids_.find(key);
+            if (it != ids_.end()) return it->second;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(key);
+        if (it != ids_.end()) return it->second;
+
+        SymbolId id = static_cast<SymbolId>(count_.load(std::memory_order_relaxed));
+        size_t chunk = id / kChunkSize;
+        if (chunk >= kMaxChunks) return kInvalidSymbolId;
+        if (chunks_[chunk].load(std::memory_order_relaxed) == nullptr) {
+            chunks_[chunk].store(new Entry[kChunkSize], std::memory_order_relaxed);
+        }
+        Entry& added = chunks_[chunk].load(std::memory_order_relaxed)[id % kChunkSize];
+        added.exchange = exchange;
+        added.code = code;
+
+        ids_.emplace(std::move(key), id);
+        auto by_code = by_code_.emplace(code, id);
+        if (!by_code.second && !exchange.empty() && entry(by_code.first->second).exchange.empty()) {
+            by_code.first->second = id;
+        }
+        count_.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    // Lookup without assigning; kInvalidSymbolId if unknown
+    SymbolId find(const std::string& exchange, const std::string& code) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(makeKey(exchange, code));
+        return it != ids_.end() ? it->second : kInvalidSymbolId;
+    }
+
+    // Lookup by code alone, for call paths that carry no exchange. Adapters
+    // intern bare codes (e.g. "00700"), so the same code in two exchanges
+    // resolves to the first exchange that registered it; a code-only
+    // registration (empty exchange) gives way to the first exchange one.
+    SymbolId findByCode(const std::string& code) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = by_code_.find(code);
+        return it != by_code_.end() ? it->second : kInvalidSymbolId;
+    }
+
+    // Returns `id` if the adapter already stamped one, otherwise looks it up
+    SymbolId resolve(SymbolId id, const std::string& exchange, const std::string& code) const {
+        if (id != kInvalidSymbolId) return id;
+        return exchange.empty() ? findByCode(code) : find(exchange, code);
+    }
+
+    const std::string& code(SymbolId id) const { return entry(id).code; }
+    const std::string& exchange(SymbolId id) const { return entry(id).exchange; }
+
+    bool valid(SymbolId id) const {
+        return id < count_.load(std::memory_order_acquire);
+    }
+
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+
+    ~SymbolRegistry() {
+        for (auto& chunk : chunks_) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    SymbolRegistry(const SymbolRegistry&) = delete;
+    SymbolRegistry& operator=(const SymbolRegistry&) = delete;
+
+private:
+    SymbolRegistry() = default;
+
+    struct Entry {
+        std::string exchange;
+        std::string code;
+    };
+
+    static constexpr size_t kChunkSize = 4096;
+    static constexpr size_t kMaxChunks = 1024;   // ~4M symbols
+
+    static std::atomic<SymbolRegistry*>& slot() {
+        static std::atomic<SymbolRegistry*> instance{nullptr};
+        return instance;
+    }
+
+    static std::string makeKey(const std::string& exchange, const std::string& code) {
+        std::string key;
+        key.reserve(exchange.size() + 1 + code.size());
+        key.append(exchange).push_back('\x1f');
+        key.append(code);
+        return key;
+    }
+
+    const Entry& entry(SymbolId id) const {
+        static const Entry empty;
+        if (!valid(id)) return empty;
+        return chunks_[id / kChunkSize].load(std::memory_order_acquire)[id % kChunkSize];
+    }
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, SymbolId> ids_;
+    std::unordered_map<std::string, SymbolId> by_code_;
+    std::atomic<size_t> count_{0};
+    std::atomic<Entry*> chunks_[kMaxChunks] = {};
+};
+
+// Per-symbol container indexed directly by SymbolId.
+// Storage is chunked so element addresses stay stable as the table grows.
+// Not thread-safe; owners guard it with their existing mutex.
+template <typename T>
+class SymbolMap {
+public:
+    bool contains(SymbolId id) const {
+        const Slot* slot = slotAt(id);
+        return slot && slot->present;
+    }
+
+    T* find(SymbolId id) {
+        Slot* slot = slotAt(id);
+        return (slot && slot->present) ? &slot->value : nullptr;
+    }
+
+    const T* find(SymbolId id) const {
+        const Slot* slot = slotAt(id);
+        return (slot && slot->present) ? &slot->value : nullptr;
+    }
+
+    // Inserts a default-constructed value if absent. kInvalidSymbolId is
+    // never stored: it gets a scratch value, which would otherwise size the
+    // table to its last chunk.
+    T& operator[](SymbolId id) {
+        assert(id != kInvalidSymbolId);
+        if (id == kInvalidSymbolId) {
+            scratch_ = T();
+            return scratch_;
+        }
+        size_t chunk = id / kChunkSize;
+        if (chunk >= chunks_.size()) {
+            chunks_.resize(chunk + 1);
+        }
+        if (!chunks_[chunk]) {
+            chunks_[chunk].reset(new Slot[kChunkSize]);
+        }
+        Slot& slot = chunks_[chunk][id % kChunkSize];
+        if (!slot.present) {
+            slot.present = true;
+            ++size_;
+        }
+        return slot.value;
+    }
+
+    bool erase(SymbolId id) {
+        Slot* slot = slotAt(id);
+        if (!slot || !slot->present) return false;
+        slot->present = false;
+        slot->value = T();
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        chunks_.clear();
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // fn(SymbolId, T&) for every present entry, in id order
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        for (size_t c = 0; c < chunks_.size(); ++c) {
+            if (!chunks_[c]) continue;
+            for (size_t i = 0; i < kChunkSize; ++i) {
+                if (chunks_[c][i].present) fn(static_cast<SymbolId>(c * kChunkSize + i), chunks_[c][i].value);
+            }
+        }
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t c = 0; c < chunks_.size(); ++c) {
+            if (!chunks_[c]) continue;
+            for (size_t i = 0; i < kChunkSize; ++i) {
+                if (chunks_[c][i].present) fn(static_cast<SymbolId>(c * kChunkSize + i), chunks_[c][i].value);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        T value{};
+        bool present = false;
+    };
+
+    static constexpr size_t kChunkSize = 1024;
+
+    Slot* slotAt(SymbolId id) {
+        size_t chunk = id / kChunkSize;
+        if (id == kInvalidSymbolId || chunk >= chunks_.size() || !chunks_[chunk]) return nullptr;
+        return &chunks_[chunk][id % kChunkSize];
+    }
+
+    const Slot* slotAt(SymbolId id) const {
+        size_t chunk = id / kChunkSize;
+        if (id == kInvalidSymbolId || chunk >= chunks_.size() || !chunks_[chunk]) return nullptr;
+        return &chunks_[chunk][id % kChunkSize];
+    }
+
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    size_t size_ = 0;
+    T scratch_{};
+};
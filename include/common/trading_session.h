@@ -0,0 +1,211 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "utils/exchange_time.h"
+
+// Continuous trading windows of a market, in minutes from local midnight.
+// Auctions are not listed: their trades belong to the adjacent window.
+struct SessionWindow {
+    int open_min = 0;
+    int close_min = 0;
+};
+
+// Regular sessions for the market codes used in exchange configs
+// ("HK", "US", "CN"). Empty for unknown markets, meaning round-the-clock.
+inline const std::vector<SessionWindow>& tradingSessions(const std::string& market) {
+    static const std::vector<SessionWindow> hk = {{9 * 60 + 30, 12 * 60}, {13 * 60, 16 * 60}};
+    static const std::vector<SessionWindow> cn = {{9 * 60 + 30, 11 * 60 + 30}, {13 * 60, 15 * 60}};
+    static const std::vector<SessionWindow> us = {{9 * 60 + 30, 16 * 60}};
+    static const std::vector<SessionWindow> none;
+
+    if (market == "HK") return hk;
+    if (market == "US") return us;
+    if (market == "CN" || market == "SH" || market == "SZ") return cn;
+    return none;
+}
+
+// Phase of a market's trading day
+enum class MarketPhase : uint8_t {
+    kClosed,        // before the first window, after the last, or no trading that day
+    kPreOpen,       // opening auction (HK, CN) or pre-market (US)
+    kContinuous,
+    kBreak,         // between two continuous sessions
+    kPostClose      // closing auction (HK, CN) or after-hours (US)
+};
+
+inline const char* marketPhaseName(MarketPhase phase) {
+    switch (phase) {
+    case MarketPhase::kPreOpen: return "pre-open";
+    case MarketPhase::kContinuous: return "continuous";
+    case MarketPhase::kBreak: return "break";
+    case MarketPhase::kPostClose: return "post-close";
+    default: return "closed";
+    }
+}
+
+// Window of a non-continuous phase, in minutes from local midnight
+struct PhaseWindow {
+    int open_min = 0;
+    int close_min = 0;
+    MarketPhase phase = MarketPhase::kClosed;
+    bool extended_hours = false;    // pre-/after-hours trading rather than an auction
+};
+
+// Auction and extended-hours windows of a regular day. They take precedence
+// over tradingSessions(): the CN closing call ends the afternoon session.
+inline const std::vector<PhaseWindow>& auctionWindows(const std::string& market) {
+    static const std::vector<PhaseWindow> hk = {{9 * 60, 9 * 60 + 30, MarketPhase::kPreOpen},
+                                                {16 * 60, 16 * 60 + 10, MarketPhase::kPostClose}};
+    static const std::vector<PhaseWindow> cn = {{9 * 60 + 15, 9 * 60 + 30, MarketPhase::kPreOpen},
+                                                {14 * 60 + 57, 15 * 60, MarketPhase::kPostClose}};
+    static const std::vector<PhaseWindow> us = {{4 * 60, 9 * 60 + 30, MarketPhase::kPreOpen, true},
+                                                {16 * 60, 20 * 60, MarketPhase::kPostClose, true}};
+    static const std::vector<PhaseWindow> none;
+
+    if (market == "HK") return hk;
+    if (market == "US") return us;
+    if (market == "CN" || market == "SH" || market == "SZ") return cn;
+    return none;
+}
+
+// Close of a half trading day (HK holiday eves, US early closes)
+inline int halfDayCloseMinute(const std::string& market) {
+    if (market == "US") return 13 * 60;
+    const auto& sessions = tradingSessions(market);
+    return sessions.empty() ? 0 : sessions.front().close_min;
+}
+
+// Kind of trading day, as exchange calendars publish them
+enum class TradeDayType : uint8_t {
+    kClosed,        // weekend or holiday
+    kWhole,
+    kMorning,       // closes at halfDayCloseMinute()
+    kAfternoon      // afternoon session only
+};
+
+struct TradeDay {
+    int date = 0;   // YYYYMMDD
+    TradeDayType type = TradeDayType::kWhole;
+};
+
+// Continuous windows of a day of `type`
+inline std::vector<SessionWindow> daySessions(const std::string& market, TradeDayType type) {
+    const auto& regular = tradingSessions(market);
+    std::vector<SessionWindow> sessions;
+    if (type == TradeDayType::kWhole) return regular;
+    if (type == TradeDayType::kMorning) {
+        int close = halfDayCloseMinute(market);
+        for (const auto& session : regular) {
+            if (session.open_min < close) sessions.push_back({session.open_min, std::min(session.close_min, close)});
+        }
+    } else if (type == TradeDayType::kAfternoon) {
+        for (const auto& session : regular) {
+            if (session.open_min >= 12 * 60) sessions.push_back(session);
+        }
+    }
+    return sessions;
+}
+
+// Auction windows of a day of `type`: a half day's closing phase follows
+// its early close, and an afternoon-only day has no opening auction
+inline std::vector<PhaseWindow> dayAuctions(const std::string& market, TradeDayType type) {
+    const auto& regular = auctionWindows(market);
+    std::vector<PhaseWindow> auctions;
+    if (type == TradeDayType::kWhole) return regular;
+    for (const auto& window : regular) {
+        if (window.phase == MarketPhase::kPreOpen) {
+            if (type == TradeDayType::kMorning) auctions.push_back(window);
+        } else if (type == TradeDayType::kMorning) {
+            int close = halfDayCloseMinute(market);
+            auctions.push_back({close, close + window.close_min - window.open_min, window.phase, window.extended_hours});
+        } else if (type == TradeDayType::kAfternoon) {
+            auctions.push_back(window);
+        }
+    }
+    return auctions;
+}
+
+// Phase at `minute_of_day` given the day's windows
+inline MarketPhase phaseAt(const std::vector<SessionWindow>& sessions, const std::vector<PhaseWindow>& auctions,
+                           int minute_of_day) {
+    for (const auto& window : auctions) {
+        if (minute_of_day >= window.open_min && minute_of_day < window.close_min) return window.phase;
+    }
+    for (const auto& session : sessions) {
+        if (minute_of_day >= session.open_min && minute_of_day < session.close_min) return MarketPhase::kContinuous;
+    }
+    if (!sessions.empty() && minute_of_day >= sessions.front().open_min && minute_of_day < sessions.back().close_min) {
+        return MarketPhase::kBreak;
+    }
+    return MarketPhase::kClosed;
+}
+
+// First window boundary after `minute_of_day`; 24 * 60 if none is left
+inline int nextPhaseChange(const std::vector<SessionWindow>& sessions, const std::vector<PhaseWindow>& auctions,
+                           int minute_of_day) {
+    int next = 24 * 60;
+    auto consider = [&](int minute) {
+        if (minute > minute_of_day) next = std::min(next, minute);
+    };
+    for (const auto& window : auctions) {
+        consider(window.open_min);
+        consider(window.close_min);
+    }
+    for (const auto& session : sessions) {
+        consider(session.open_min);
+        consider(session.close_min);
+    }
+    return next;
+}
+
+// Minutes of continuous trading in a regular day
+inline int sessionMinutes(const std::vector<SessionWindow>& sessions) {
+    int minutes = 0;
+    for (const auto& session : sessions) {
+        minutes += session.close_min - session.open_min;
+    }
+    return minutes;
+}
+
+// Minutes of continuous trading elapsed by `minute_of_day`: 0 before the
+// open, sessionMinutes() after the close
+inline int elapsedSessionMinutes(const std::vector<SessionWindow>& sessions, int minute_of_day) {
+    int elapsed = 0;
+    for (const auto& session : sessions) {
+        if (minute_of_day <= session.open_min) break;
+        elapsed += std::min(minute_of_day, session.close_min) - session.open_min;
+    }
+    return elapsed;
+}
+
+// Offset of the market's wall clock from UTC at `epoch_ns`; 0 for unknown markets
+inline int32_t marketUtcOffset(const std::string& market, int64_t epoch_ns) {
+    if (market == "US") return exchange_time::utcOffset(epoch_ns, exchange_time::usEasternTime());
+    if (market == "HK" || market == "CN" || market == "SH" || market == "SZ") {
+        return exchange_time::utcOffset(epoch_ns, exchange_time::chinaTime());
+    }
+    return 0;
+}
+
+// Calendar date (YYYYMMDD) on the market's wall clock at `epoch_ns`
+inline int marketDate(const std::string& market, int64_t epoch_ns) {
+    int64_t local_sec = epoch_ns / exchange_time::kNanosPerSecond + marketUtcOffset(market, epoch_ns);
+    int64_t days = local_sec / exchange_time::kSecondsPerDay;
+    if (local_sec % exchange_time::kSecondsPerDay < 0) --days;
+    int y = 0;
+    unsigned m = 0;
+    unsigned d = 0;
+    exchange_time::civilFromDays(days, y, m, d);
+    return y * 10000 + static_cast<int>(m) * 100 + static_cast<int>(d);
+}
+
+// Minute of the day on the market's wall clock at `epoch_ns`
+inline int marketMinuteOfDay(const std::string& market, int64_t epoch_ns) {
+    int64_t local_sec = epoch_ns / exchange_time::kNanosPerSecond + marketUtcOffset(market, epoch_ns);
+    int64_t sec_of_day = local_sec % exchange_time::kSecondsPerDay;
+    if (sec_of_day < 0) sec_of_day += exchange_time::kSecondsPerDay;
+    return static_cast<int>(sec_of_day / 60);
+}
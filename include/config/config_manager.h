@@ -33,6 +33,17 @@ struct ScannerParams {
     double min_volume = 1000000;
     double min_turnover_rate = 0.01;
     int top_n = 10;
+    int snapshot_requests_in_flight = 4;      // snapshot batches requested ahead of the one being scored
+    bool push_enabled = false;                // re-rank on quote pushes between polls
+    int push_symbols = 100;                   // best candidates of each poll kept on quote push
+    bool volume_preload = true;               // fetch the watch list's volume history once per trading date
+    int volume_preload_parallelism = 4;       // history requests in flight during the preload
+    std::string volume_cache_dir = "data/scanner";  // daily volume averages and volume curves (empty = no cache)
+    std::string filter_expression;            // replaces the built-in criteria but the volume ratio (empty = built in)
+    std::string score_expression;             // replaces the built-in score (empty = built in)
+    bool tiered_scan = true;                  // poll quiet stocks less often than active ones
+    int tier_hot_speedup = 4;                 // hot stocks are polled this many times per scan interval
+    int tier_cold_slowdown = 4;               // cold stocks are polled this many times less often than warm
 
     // === Breakout stock selection parameters ===
     double breakout_volume_ratio_min = 2.5;   // minimum volume ratio
@@ -89,6 +100,24 @@ struct LoggingConfig {
     bool console = true;
     bool file = true;
     std::string file_dir = "logs/";
+    int segment_size_mb = 64;              // Rotate when a segment reaches this size
+    int rotate_interval_hours = 24;        // Rotate after this long even if not full (0 = size only)
+    bool compress_rotated = true;          // gzip closed segments in the background
+};
+
+// Market data subscription configuration
+struct MarketDataConfig {
+    int subscription_flush_ms = 200;       // Batch window for coalescing subscribe/unsubscribe requests
+    int subscription_timeout_ms = 10000;   // Unconfirmed requests are retried after this long
+    int subscription_quota = 0;            // Cap on quota units to use (0 = whatever the exchange reports)
+    int subscription_linger_seconds = 300; // Keep released feeds this long in case they are needed again
+    int kline_cache_bars = 1000;           // Bars kept in memory per (symbol, interval)
+    std::string bar_store_dir = "data/bars"; // On-disk K-line history (empty = disabled)
+    std::string calendar_dir = "data/calendar"; // Cached exchange trading calendars (empty = not cached)
+    bool aggregate_bars = true;            // Build 1m..1h K-lines from trade ticks instead of subscribing
+    int bar_update_ms = 250;               // Min gap between in-progress bar updates (-1 = closed bars only)
+    int feed_stale_seconds = 60;           // In-session silence before a subscribed symbol counts as stale (0 = off)
+    int feed_backfill_parallelism = 4;     // History requests in flight while backfilling missed bars
 };
 
 // Telegram notification configuration
@@ -116,6 +145,7 @@ struct TradingConfig {
     RiskParams risk;
     StrategyParams strategy;
     LoggingConfig logging;
+    MarketDataConfig market_data;
     NotificationConfig notification;
 };
 
@@ -133,6 +163,10 @@ public:
     // Convenience accessors - scanner params
     const ScannerParams& getScannerParams() const { return config_.scanner; }
     
+    // Scanner expressions as currently in `json_file`, for applying edits to
+    // a running scanner; leaves the loaded configuration untouched
+    bool readScanExpressions(const std::string& json_file, std::string& filter, std::string& score) const;
+    
     // Convenience accessors - multi-exchange support
     const std::vector<ExchangeInstanceConfig>& getExchanges() const { return config_.exchanges; }
     std::vector<ExchangeInstanceConfig> getEnabledExchanges() const;
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include "common/object.h"
+#include "common/trading_session.h"
+#include "config/config_manager.h"
+#include "event/event_interface.h"
+
+// Builds intraday K-lines (1m/3m/5m/15m/30m/1h) from EVENT_TRADE prints, so one tick
+// subscription per symbol replaces a subscription per K-line interval.
+// Bars follow the market's sessions: they start at each session open, the
+// last one before a break is cut short at the break (HK 11:30-12:00 for 1h),
+// and auction trades fold into the adjacent bar. Extended-hours trades (US
+// pre-market and after-hours) and other prints outside the trading day are
+// left out, as in the exchange's regular-session K-lines. Like those, bars
+// are stamped with their end time.
+// Closed bars are published as EVENT_KLINE once their end time has passed,
+// and again if late trades (e.g. the closing auction) change them;
+// in-progress updates are published at most every bar_update_ms.
+// A bar that was already in progress when its feed started misses trades
+// and is never published.
+class BarAggregator {
+public:
+    static BarAggregator& getInstance();
+
+    void initializeEventHandlers(IEventEngine* event_engine);
+
+    // Start/stop the sweep that closes bars when their time is up
+    void start(const MarketDataConfig& config);
+    void stop();
+
+    // Whether `interval` (canonical, see DataSubscriber::normalizeKLineType)
+    // is built here; false for every interval when aggregation is disabled
+    bool builds(const std::string& interval) const;
+
+    // Reference-counted demand for one interval of a symbol
+    void addInterval(const std::string& exchange_name, const std::string& symbol, const std::string& interval);
+    void removeInterval(const std::string& exchange_name, const std::string& symbol, const std::string& interval);
+
+    void onTrade(const TradePrint& trade);
+
+    // Close every bar whose end time is before `now_ns`
+    void sweep(int64_t now_ns);
+
+    // Non-copyable
+    BarAggregator(const BarAggregator&) = delete;
+    BarAggregator& operator=(const BarAggregator&) = delete;
+
+private:
+    BarAggregator() = default;
+    ~BarAggregator();
+
+    static constexpr size_t kIntervalCount = 6;
+
+    struct Bar {
+        int64_t start_ns = 0;           // exchange time
+        int64_t end_ns = 0;
+        double open = 0.0;
+        double high = 0.0;
+        double low = 0.0;
+        double close = 0.0;
+        int64_t volume = 0;
+        double turnover = 0.0;
+        int64_t published_ns = 0;       // local time of the last in-progress update
+        bool active = false;            // has trades and has not been closed
+        bool partial = false;           // started before the feed did: misses earlier trades
+    };
+
+    struct SymbolBars {
+        SymbolId symbol_id = kInvalidSymbolId;
+        std::string exchange;
+        std::string symbol;
+        const std::vector<SessionWindow>* sessions = nullptr;
+        const std::vector<PhaseWindow>* auctions = nullptr;
+        int32_t utc_offset_sec = 0;     // of the last trade
+        std::array<int, kIntervalCount> refs{};
+        std::array<int64_t, kIntervalCount> since_ns{};   // when each interval was first wanted
+        std::array<Bar, kIntervalCount> bars{};
+    };
+
+    static int intervalIndex(const std::string& interval);
+
+    // Bar bounds containing exchange time `ts_ns`; false for a trade that
+    // belongs to no regular bar
+    static bool bucketFor(int64_t ts_ns, int32_t utc_offset_sec, int64_t interval_sec,
+                          const std::vector<SessionWindow>& sessions, const std::vector<PhaseWindow>& auctions,
+                          int64_t& start_ns, int64_t& end_ns);
+
+    // Helpers below expect mutex_ to be held
+    void fold(SymbolBars& state, size_t index, const TradePrint& trade, int64_t now_ns);
+    void publish(const SymbolBars& state, size_t index, int64_t now_ns);
+
+    void onTradeEvent(const EventPtr& event);
+    void sweepLoop();
+
+    SymbolMap<SymbolBars> symbols_;
+    mutable std::mutex mutex_;
+
+    bool enabled_ = true;
+    int64_t update_interval_ns_ = 250000000;   // < 0: closed bars only
+
+    IEventEngine* event_engine_ = nullptr;
+    int trade_handler_id_ = -1;
+
+    std::thread sweep_thread_;
+    std::atomic<bool> running_{false};
+    std::mutex sweep_mutex_;
+    std::condition_variable sweep_cv_;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include "common/object.h"
+
+class IExchange;
+
+// On-disk K-line store, one file per (exchange, symbol, interval) under
+// <dir>/<exchange>/<interval>/<symbol>.bars.
+// Each file is a 64-byte header followed by one fixed-capacity column per
+// field (timestamp, open, high, low, close, volume, turnover), bars sorted
+// by time. Files are read through mmap and only the bars missing since the
+// last sync are fetched from the exchange and appended, so history survives
+// restarts instead of being downloaded again.
+class BarStore {
+public:
+    static BarStore& getInstance();
+
+    // Enable the store rooted at `dir`; until then reads go straight to the exchange
+    bool open(const std::string& dir);
+    void close();
+    bool isOpen() const;
+
+    // Last `count` bars, oldest first. Served from disk when the stored series
+    // was synced within the last bar, and for daily and longer bars on the
+    // market's current date; otherwise topped up from `exchange`.
+    // Falls back to the stored bars when the exchange returns nothing.
+    std::vector<KlineData> getHistoryKLine(
+        const std::shared_ptr<IExchange>& exchange,
+        const std::string& symbol,
+        const std::string& kline_type,
+        int count
+    );
+
+    // Last `count` stored bars, oldest first, without contacting the exchange;
+    // empty when the store is closed or holds no such series
+    std::vector<KlineData> readStored(const std::string& exchange_name,
+                                      const std::string& symbol,
+                                      const std::string& kline_type,
+                                      int count);
+
+    // Non-copyable
+    BarStore(const BarStore&) = delete;
+    BarStore& operator=(const BarStore&) = delete;
+
+private:
+    BarStore() = default;
+
+    struct Bar {
+        int64_t ts_ns = 0;
+        double open = 0.0;
+        double high = 0.0;
+        double low = 0.0;
+        double close = 0.0;
+        int64_t volume = 0;
+        double turnover = 0.0;
+    };
+
+    struct Series {
+        std::vector<Bar> bars;          // tail of the file, oldest first
+        size_t first = 0;               // file row of bars[0]
+        size_t total = 0;               // bars in the file
+        int64_t synced_at_ns = 0;       // wall clock of the last exchange sync
+        int32_t utc_offset_sec = 0;
+        bool complete = false;          // the exchange has no older history
+    };
+
+    std::string pathFor(const std::string& exchange_name, const std::string& symbol,
+                        const std::string& interval) const;
+    std::mutex& lockFor(const std::string& path);
+
+    // Reads the header and the last `count` bars (all bars when count is 0)
+    static bool load(const std::string& path, size_t count, Series& out);
+    // Writes `bars` at file row `index`, dropping any rows after them, and
+    // stores the sync time, offset and complete flag of `meta`
+    static bool write(const std::string& path, const Series& meta, size_t index, const std::vector<Bar>& bars);
+
+    static std::vector<KlineData> toKLines(const Series& series, const std::string& symbol,
+                                           const std::string& exchange_name, const std::string& kline_type,
+                                           size_t count);
+
+    std::string dir_;
+    bool open_ = false;
+    mutable std::mutex mutex_;
+
+    // Striped per-file locks: one fetch per series at a time, different series in parallel
+    std::array<std::mutex, 64> file_locks_;
+};
@@ -6,7 +6,14 @@
 #include <mutex>
 #include <functional>
 #include <memory>
+#include <set>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include "common/object.h"
+#include "config/config_manager.h"
 
  
 
@@ -15,17 +22,74 @@ using KLineCallback = std::function<void(const std::string&, const KlineData&)>;
 using TickCallback = std::function<void(const std::string&, const TickData&)>;
 using SnapshotCallback = std::function<void(const Snapshot&)>;
 
+// Subscription quota usage of one exchange
+struct SubscriptionUsage {
+    std::string exchange;
+    int quota = -1;               // usable quota units, -1 = unlimited
+    int used = 0;                 // units held or being subscribed
+    size_t subscribed = 0;        // confirmed feeds
+    size_t position_feeds = 0;    // ... for symbols with open positions
+    size_t lingering = 0;         // ... released by all consumers, kept until evicted or idle
+    size_t deferred = 0;          // wanted but waiting for quota
+    size_t pending = 0;           // requests awaiting confirmation
+};
+
 class DataSubscriber {
 public:
     static DataSubscriber& getInstance();
     
-    // Subscribe to K-line (candlestick) data
-    bool subscribeKLine(const std::string& symbol, const std::string& kline_type);
-    void unsubscribeKLine(const std::string& symbol);
+    // Start/stop the background flush that sends pending subscription changes
+    void start(const MarketDataConfig& config);
+    void stop();
     
-    // Subscribe to tick data
+    // Subscriptions are reference-counted per (exchange, symbol, data type):
+    // the exchange feed is requested with the first reference and released
+    // with the last, so consumers never tear down a feed another one uses.
+    // Changes are coalesced and sent as one multi-symbol request per data type
+    // every flush interval; the exchange confirms asynchronously.
+    // Within the exchange's quota, feeds for symbols with open positions come
+    // first, then feeds some consumer holds, then released feeds kept warm;
+    // when a higher-priority feed needs room, the least recently used
+    // lower-priority feed that is past the exchange's minimum hold is evicted.
+    // Intraday K-lines the BarAggregator builds take a tick reference instead.
+    bool subscribeKLine(const std::string& exchange_name, const std::string& symbol, const std::string& kline_type);
+    void unsubscribeKLine(const std::string& exchange_name, const std::string& symbol, const std::string& kline_type);
+    bool subscribeTick(const std::string& exchange_name, const std::string& symbol);
+    void unsubscribeTick(const std::string& exchange_name, const std::string& symbol);
+    bool subscribeDepth(const std::string& exchange_name, const std::string& symbol);     // feeds OrderBookEngine
+    void unsubscribeDepth(const std::string& exchange_name, const std::string& symbol);
+    
+    // Same as above, with the exchange resolved from the symbol registry
+    bool subscribeKLine(const std::string& symbol, const std::string& kline_type);
+    void unsubscribeKLine(const std::string& symbol, const std::string& kline_type);
     bool subscribeTick(const std::string& symbol);
     void unsubscribeTick(const std::string& symbol);
+    bool subscribeDepth(const std::string& symbol);
+    void unsubscribeDepth(const std::string& symbol);
+    
+    // Send pending changes now instead of waiting for the next flush
+    void flush();
+    
+    // After a reconnect the exchange holds none of our feeds: forget what was
+    // confirmed or in flight on `exchange_name` and send every referenced
+    // feed again, batched like any other change. Lingering feeds are dropped.
+    void resubscribeAll(const std::string& exchange_name);
+    
+    // Confirmed by the exchange
+    bool isSubscribed(const std::string& exchange_name, const std::string& symbol, const std::string& data_type) const;
+    size_t getActiveSubscriptionCount() const;
+    
+    // Confirmed feeds some consumer holds on `exchange_name`, as (symbol, data type)
+    std::vector<std::pair<std::string, std::string>> getActiveFeeds(const std::string& exchange_name) const;
+    
+    // Quota usage per exchange, and the same as printable lines
+    std::vector<SubscriptionUsage> getSubscriptionUsage() const;
+    std::string getUsageReport() const;
+    
+    // Canonical K-line type ("1m", "5m", "1h", "1d", ...) for the aliases
+    // accepted by the exchanges ("K_5M", "5min", ...)
+    static std::string normalizeKLineType(const std::string& kline_type);
+    static KlineInterval klineIntervalEnum(const std::string& kline_type);
     
     // Register callback handlers
     void registerKLineCallback(KLineCallback callback);
@@ -48,9 +112,66 @@ public:
     
 private:
     DataSubscriber() = default;
+    ~DataSubscriber();
+    
+    // (exchange, symbol, data type)
+    using SubscriptionKey = std::tuple<std::string, std::string, std::string>;
+    
+    struct SubscriptionState {
+        int ref_count = 0;
+        bool active = false;            // confirmed by the exchange
+        bool in_flight = false;         // request sent, not yet confirmed
+        bool in_flight_subscribe = false;
+        bool deferred = false;          // wanted but no quota
+        int cost = 1;                   // quota units
+        int failures = 0;
+        std::chrono::steady_clock::time_point retry_after;
+        std::chrono::steady_clock::time_point subscribed_at;
+        std::chrono::steady_clock::time_point last_used;   // last reference taken or dropped
+    };
+    
+    // Eviction order, lowest first
+    enum Priority { kLingering = 0, kReferenced = 1, kPosition = 2 };
+    
+    struct ExchangeQuota {
+        int quota = -1;                 // -1 = unlimited
+        bool refreshed = false;
+        std::chrono::steady_clock::time_point last_refresh;
+    };
+    
+    // One outstanding exchange request
+    struct PendingBatch {
+        std::vector<SubscriptionKey> keys;
+        bool subscribe = true;
+        std::chrono::steady_clock::time_point sent_at;
+    };
+    
+    bool addReference(const std::string& exchange_name, const std::string& symbol, const std::string& data_type);
+    void releaseReference(const std::string& exchange_name, const std::string& symbol, const std::string& data_type);
+    std::string resolveExchange(const std::string& symbol) const;
+    void onSubscriptionResult(uint64_t batch_id, bool success);
+    void flushLoop();
+    void refreshQuotas();
+    
+    // Helpers below expect subscription_mutex_ to be held
+    Priority priorityOf(const SubscriptionKey& key, const SubscriptionState& state) const;
+    int unitsInUse(const std::string& exchange_name) const;
+    
+    std::map<SubscriptionKey, SubscriptionState> subscriptions_;
+    std::set<SubscriptionKey> dirty_;                 // desired != confirmed, not yet sent
+    std::map<uint64_t, PendingBatch> pending_batches_;
+    uint64_t next_batch_id_ = 1;
+    std::map<std::string, ExchangeQuota> quotas_;
+    mutable std::mutex subscription_mutex_;
     
-    std::map<std::string, std::string> kline_subscriptions_;  // symbol -> kline_type
-    std::map<std::string, bool> tick_subscriptions_;
+    std::thread flush_thread_;
+    std::atomic<bool> running_{false};
+    std::mutex flush_mutex_;
+    std::condition_variable flush_cv_;
+    std::chrono::milliseconds flush_interval_{200};
+    std::chrono::milliseconds confirm_timeout_{10000};
+    std::chrono::seconds linger_{300};
+    int quota_cap_ = 0;
     
     std::vector<KLineCallback> kline_callbacks_;
     std::vector<TickCallback> tick_callbacks_;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+#include "common/object.h"
+#include "common/trading_session.h"
+#include "config/config_manager.h"
+#include "event/event_interface.h"
+
+class IExchange;
+
+// Feed state of one symbol
+struct FeedStatus {
+    int64_t last_update_ns = 0;     // local receive time of the latest push, epoch ns
+    bool stale = false;             // subscribed but silent for feed_stale_seconds of session time
+    int64_t gaps = 0;               // K-line jumps over missing bars, or print sequence jumps
+    int64_t missed_bars = 0;
+    int64_t missed_prints = 0;
+    int64_t backfills = 0;
+};
+
+// Watches market data for loss and repairs it.
+// Every push stamps its symbol, and K-line pushes are checked against the
+// previous bar of their interval: a jump over session time that should have
+// held bars is a gap, and the symbol's cached bars are reloaded. Bars the
+// BarAggregator builds have no bar for minutes without trades, so they are
+// checked through the prints they are built from: a jump in the exchange's
+// print sequence is a gap as well.
+// A monitor thread flags subscribed symbols that stay silent in session,
+// and reconnects exchanges whose connection dropped. Once an exchange is
+// back, all of its feeds are renewed in batched requests and every symbol
+// seen on it is backfilled with one history request per cached interval,
+// feed_backfill_parallelism at a time. An exchange whose subscribed
+// symbols all fall silent while connected is resynced the same way.
+class FeedHealth {
+public:
+    static FeedHealth& getInstance();
+
+    void initializeEventHandlers(IEventEngine* event_engine);
+
+    // Start/stop the monitor
+    void start(const MarketDataConfig& config);
+    void stop();
+
+    void onTick(const TickData& tick);
+    void onTrade(const TradePrint& trade);
+    void onDepth(const DepthData& depth);
+    void onKLine(const KlineData& kline);
+
+    // One monitor pass: staleness, reconnects, resyncs and queued backfills
+    void check(int64_t now_ns);
+
+    // False if nothing was received for the symbol
+    bool getStatus(SymbolId symbol_id, FeedStatus& out) const;
+    bool isStale(SymbolId symbol_id) const;
+    std::vector<SymbolId> getStaleSymbols() const;
+
+    // One line per exchange: connection, stale feeds, gaps, last resync
+    std::string getHealthReport() const;
+
+    // Non-copyable
+    FeedHealth(const FeedHealth&) = delete;
+    FeedHealth& operator=(const FeedHealth&) = delete;
+
+private:
+    FeedHealth() = default;
+    ~FeedHealth();
+
+    struct SymbolHealth {
+        FeedStatus status;
+        int64_t watched_since_ns = 0;              // first seen subscribed, for feeds that never pushed
+        int64_t last_backfill_ns = 0;
+        int64_t last_sequence = 0;                 // of the latest trade print, 0 if not provided
+        std::map<std::string, int64_t> last_bar_ns; // interval -> latest bar time
+    };
+
+    struct ExchangeHealth {
+        std::string market;
+        bool connected = false;
+        bool was_connected = false;                // only dropped connections are retried
+        int64_t down_since_ns = 0;
+        std::chrono::steady_clock::time_point next_attempt;
+        int failures = 0;
+        size_t feeds = 0;
+        size_t stale = 0;
+        int64_t last_resync_ns = 0;
+        int64_t last_resync_ms = 0;                // time the last resync took
+    };
+
+    struct BackfillJob {
+        std::string exchange;
+        std::string symbol;
+        SymbolId symbol_id = kInvalidSymbolId;
+    };
+
+    void touch(SymbolId symbol_id, int64_t local_ts_ns);
+    void checkExchange(const std::shared_ptr<IExchange>& exchange, int64_t now_ns);
+    void resync(const std::string& name, int64_t now_ns);
+    void backfill(const std::vector<BackfillJob>& jobs);
+    void monitorLoop();
+
+    void onTickEvent(const EventPtr& event);
+    void onTradeEvent(const EventPtr& event);
+    void onDepthEvent(const EventPtr& event);
+    void onKLineEvent(const EventPtr& event);
+
+    SymbolMap<SymbolHealth> symbols_;
+    std::set<SymbolId> gapped_;                    // awaiting backfill
+    std::map<std::string, ExchangeHealth> exchanges_;
+    mutable std::mutex mutex_;
+
+    int64_t stale_ns_ = 60LL * 1000000000LL;       // 0 = staleness not checked
+    size_t parallelism_ = 4;
+
+    std::thread monitor_thread_;
+    std::atomic<bool> running_{false};
+    std::mutex monitor_mutex_;
+    std::condition_variable monitor_cv_;
+
+    IEventEngine* event_engine_ = nullptr;
+    int tick_handler_id_ = -1;
+    int trade_handler_id_ = -1;
+    int depth_handler_id_ = -1;
+    int kline_handler_id_ = -1;
+};
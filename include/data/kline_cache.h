@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include "common/object.h"
+#include "event/event_interface.h"
+
+class IExchange;
+
+// In-memory K-line cache keyed by (symbol, interval).
+// Each series is a ring of the most recent bars, seeded once from the
+// exchange's history and kept current by EVENT_KLINE pushes, so repeated
+// history reads are served from memory instead of an exchange round trip.
+// A series with no pushes is refetched once it is older than one bar, or for
+// daily and longer bars once the market date has changed.
+class KLineCache {
+public:
+    static KLineCache& getInstance();
+
+    // Bars kept per (symbol, interval); requests for more bypass the cache
+    void setCapacity(size_t bars);
+
+    void initializeEventHandlers(IEventEngine* event_engine);
+
+    // Last `count` bars, oldest first. Served from memory when the cached
+    // series covers the request, otherwise read through the BarStore and cached.
+    std::vector<KlineData> getHistoryKLine(
+        const std::shared_ptr<IExchange>& exchange,
+        const std::string& symbol,
+        const std::string& kline_type,
+        int count
+    );
+
+    // Apply a pushed bar (in-progress update or new bar) to a cached series
+    void onKLine(const KlineData& kline);
+
+    // Drop the cached series of a symbol that missed pushes, so the next
+    // read goes back to the BarStore. Returns (interval, bars held) of what
+    // was dropped, for reloading the same depth.
+    std::vector<std::pair<std::string, size_t>> invalidate(SymbolId symbol_id);
+
+    void clear();
+
+    // Nominal length of a bar of a canonical interval ("1m", "1d", ...)
+    static std::chrono::seconds barDuration(const std::string& interval);
+
+    // Whether bars of `interval` last synced at `synced_ns` may miss bars by
+    // `now_ns`: after a whole bar, and for daily and longer bars as soon as
+    // the market's date changes, since the last bar of a day synced before
+    // its close is partial
+    static bool syncExpired(const std::string& interval, const std::string& market,
+                            int64_t synced_ns, int64_t now_ns);
+
+    // Non-copyable
+    KLineCache(const KLineCache&) = delete;
+    KLineCache& operator=(const KLineCache&) = delete;
+
+private:
+    KLineCache() = default;
+
+    // Ring of bars; grows up to the capacity, then overwrites the oldest
+    struct Series {
+        std::vector<KlineData> bars;
+        size_t head = 0;                // index of the oldest bar once full
+        bool complete = false;          // the exchange has no older history
+        int64_t updated_ns = 0;         // wall clock of the last seed or push
+
+        size_t size() const { return bars.size(); }
+        const KlineData& at(size_t i) const;        // 0 = oldest
+        KlineData& back();
+        void push(const KlineData& bar, size_t capacity);
+    };
+
+    bool readCached(SymbolId symbol_id, const std::string& interval, const std::string& market,
+                    size_t count, std::vector<KlineData>& out);
+    void seed(SymbolId symbol_id, const std::string& interval, const std::vector<KlineData>& history,
+              size_t requested);
+    void onKLineEvent(const EventPtr& event);
+
+    SymbolMap<std::map<std::string, Series>> series_;   // symbol -> interval -> bars
+    size_t capacity_ = 1000;
+    mutable std::mutex mutex_;
+
+    IEventEngine* event_engine_ = nullptr;
+    int kline_handler_id_ = -1;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include "common/object.h"
+#include "event/event_interface.h"
+
+// Derived order book figures; prices are 0 when a side is empty
+struct BookMetrics {
+    double best_bid = 0.0;
+    double best_ask = 0.0;
+    double spread = 0.0;
+    double mid = 0.0;
+    double microprice = 0.0;        // mid leaning toward the thinner side of level 1
+    int64_t bid_volume = 0;         // over the requested levels
+    int64_t ask_volume = 0;
+    double imbalance = 0.0;         // (bid - ask) / (bid + ask) over the requested levels, -1..1
+    int64_t exchange_ts_ns = 0;
+    int64_t local_ts_ns = 0;
+};
+
+// Latest L2 book per symbol, kept current from EVENT_DEPTH pushes.
+// Books live in one flat slot per symbol and each push overwrites its slot
+// in place, storing running volume totals alongside, so every metric is a
+// constant-time read whatever depth it covers.
+class OrderBookEngine {
+public:
+    static OrderBookEngine& getInstance();
+
+    void initializeEventHandlers(IEventEngine* event_engine);
+
+    // Apply a full-book push
+    void onDepth(const DepthData& depth);
+
+    // Copy of the current book; false if none was received
+    bool getBook(SymbolId symbol_id, DepthBook& out) const;
+
+    // Metrics over the top `levels` levels (capped at the book depth);
+    // false if no book was received
+    bool getMetrics(SymbolId symbol_id, size_t levels, BookMetrics& out) const;
+
+    // Bid volume over ask volume across `levels` levels, the depth-aware
+    // counterpart of the level-1 bid/ask ratio; false if no book was received
+    bool getBidAskRatio(SymbolId symbol_id, size_t levels, double& ratio) const;
+    // The same for many symbols under one lock; ratios[i] is left as it was
+    // where no book was received
+    void getBidAskRatios(const std::vector<SymbolId>& symbol_ids, size_t levels, std::vector<double>& ratios) const;
+
+    void remove(SymbolId symbol_id);
+    void clear();
+
+    // Non-copyable
+    OrderBookEngine(const OrderBookEngine&) = delete;
+    OrderBookEngine& operator=(const OrderBookEngine&) = delete;
+
+private:
+    OrderBookEngine() = default;
+
+    struct Book {
+        DepthBook book;
+        int64_t bid_total[DepthBook::kMaxDepth];   // volume of levels 0..i
+        int64_t ask_total[DepthBook::kMaxDepth];
+        int64_t exchange_ts_ns = 0;
+        int64_t local_ts_ns = 0;
+    };
+
+    void onDepthEvent(const EventPtr& event);
+    static double bidAskRatio(const Book& slot, size_t levels);
+
+    SymbolMap<Book> books_;
+    mutable std::mutex mutex_;
+
+    IEventEngine* event_engine_ = nullptr;
+    int depth_handler_id_ = -1;
+};
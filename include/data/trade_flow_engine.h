@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "common/object.h"
+#include "event/event_interface.h"
+
+// Order flow of one symbol over a trailing window
+struct FlowStats {
+    int window_seconds = 0;
+    int64_t buy_volume = 0;         // aggressive buys
+    int64_t sell_volume = 0;        // aggressive sells
+    int64_t volume = 0;             // all prints, including neutral
+    double turnover = 0.0;
+    int64_t prints = 0;
+    double vwap = 0.0;              // 0 without prints
+    double print_rate = 0.0;        // prints per second
+    double imbalance = 0.0;         // (buy - sell) / (buy + sell), -1..1
+    double last_price = 0.0;
+};
+
+// Rolling order flow per symbol from EVENT_TRADE prints.
+// Each symbol keeps a ring of one-second buckets plus running totals for the
+// 10s, 60s and 300s windows; a print updates its bucket and the totals, and
+// buckets leaving a window are subtracted as time moves on, so reads are
+// constant-time. Prints without an aggressor side are classified against
+// the order book when one is held, otherwise by the tick rule.
+class TradeFlowEngine {
+public:
+    static TradeFlowEngine& getInstance();
+
+    void initializeEventHandlers(IEventEngine* event_engine);
+
+    void onTrade(const TradePrint& trade);
+
+    // Stats for the smallest maintained window covering `window_seconds`
+    // (10, 60 or 300), as of `now_ns` (epoch ns, 0 = now). False if the
+    // symbol has never traded.
+    bool getFlow(SymbolId symbol_id, int window_seconds, FlowStats& out, int64_t now_ns = 0);
+
+    void remove(SymbolId symbol_id);
+    void clear();
+
+    // Non-copyable
+    TradeFlowEngine(const TradeFlowEngine&) = delete;
+    TradeFlowEngine& operator=(const TradeFlowEngine&) = delete;
+
+private:
+    TradeFlowEngine() = default;
+
+    static constexpr size_t kRingSeconds = 300;
+    static constexpr size_t kWindowCount = 3;
+    static constexpr int kWindows[kWindowCount] = {10, 60, 300};
+
+    struct Totals {
+        int64_t buy_volume = 0;
+        int64_t sell_volume = 0;
+        int64_t volume = 0;
+        double turnover = 0.0;
+        int64_t prints = 0;
+
+        void add(const Totals& other, int sign);
+    };
+
+    struct Flow {
+        std::array<Totals, kRingSeconds> buckets{};
+        std::array<Totals, kWindowCount> windows{};
+        int64_t last_second = 0;        // newest bucket, epoch seconds
+        int64_t last_print_ns = 0;
+        double last_price = 0.0;
+        AggressorSide last_side = AggressorSide::UNKNOWN;
+    };
+
+    // Moves the window forward to `second`, expiring buckets on the way
+    static void advance(Flow& flow, int64_t second);
+
+    void onTradeEvent(const EventPtr& event);
+
+    SymbolMap<std::unique_ptr<Flow>> flows_;   // ~12KB each, allocated on the first print
+    mutable std::mutex mutex_;
+
+    IEventEngine* event_engine_ = nullptr;
+    int trade_handler_id_ = -1;
+};
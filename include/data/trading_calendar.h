@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include "common/trading_session.h"
+
+class IExchange;
+
+// Trading days, sessions and phases of each market on its own clock.
+// Holidays and half days come from the exchange's published calendar a year
+// at a time, cached under <dir>/<market>_<year>.txt so restarts do not ask
+// again; days not covered by one fall back to Monday to Friday. Markets
+// without a session table trade round the clock. SH and SZ share the CN
+// calendar.
+class TradingCalendar {
+public:
+    static TradingCalendar& getInstance();
+
+    // Directory of the cached calendars; empty keeps them in memory only
+    void setCacheDir(const std::string& dir);
+
+    // Make the trading days of `date`'s year known for the exchange's market,
+    // from the cache or else the exchange. Blocking; false if neither covers
+    // `date`.
+    bool load(const std::shared_ptr<IExchange>& exchange, int date);
+
+    TradeDayType dayType(const std::string& market, int date) const;
+
+    // Continuous windows of `date` (YYYYMMDD); empty on closed days and for
+    // round-the-clock markets
+    std::vector<SessionWindow> sessions(const std::string& market, int date) const;
+
+    MarketPhase phase(const std::string& market, int64_t epoch_ns) const;
+
+    // Time from `epoch_ns` until the phase may next change, at most until
+    // the market's next midnight
+    int64_t untilPhaseChangeNs(const std::string& market, int64_t epoch_ns) const;
+
+    // Seconds of continuous trading in [from_ns, to_ns), holidays excluded;
+    // wall time for round-the-clock markets
+    int64_t sessionSeconds(const std::string& market, int64_t from_ns, int64_t to_ns) const;
+
+    // Non-copyable
+    TradingCalendar(const TradingCalendar&) = delete;
+    TradingCalendar& operator=(const TradingCalendar&) = delete;
+
+private:
+    TradingCalendar() = default;
+
+    // One published year; dates after `last_date` are not known yet
+    struct Year {
+        std::map<int, TradeDayType> days;
+        int last_date = 0;
+    };
+
+    static std::string calendarMarket(const std::string& market);
+    TradeDayType dayTypeLocked(const std::string& market, int date) const;
+
+    std::string cachePath(const std::string& market, int year) const;
+    static bool loadYear(const std::string& path, const std::string& market, Year& out);
+    static bool saveYear(const std::string& path, const std::string& market, const Year& year);
+
+    mutable std::mutex mutex_;
+    std::string cache_dir_;
+    std::map<std::string, std::map<int, Year>> years_;     // by calendar market, then year
+};
@@ -7,12 +7,14 @@
 #include <functional>
 #include "common/defines.h"
 #include "common/object.h"
+#include "common/trading_session.h"
 
 // Forward declaration
 class IEventEngine;
 
 #define ExchangeClass "GetExchangeClass"
 #define ExchangeInstance "GetExchangeInstance"
+#define ExchangeBindSymbolRegistry "BindSymbolRegistry"
 
 namespace dylib {
     class library;
@@ -43,6 +45,24 @@ struct ExchangePosition {
     double profit_loss_ratio;
 };
 
+// Completion callback for asynchronous subscription changes
+using SubscriptionCallback = std::function<void(bool success)>;
+
+// Completion callback for asynchronous snapshot requests
+using SnapshotBatchCallback = std::function<void(bool success, std::map<std::string, Snapshot> snapshots)>;
+
+// Request limit of an exchange endpoint: at most `max_requests` requests in
+// any `window_seconds`, each for at most `max_symbols` symbols (0 = no limit)
+struct RequestRateLimit {
+    int max_requests = 0;
+    int window_seconds = 0;
+    int max_symbols = 0;
+};
+
+// Data type keys for tick and order book subscriptions; K-line subscriptions use the K-line type
+constexpr const char* kTickDataType = "tick";
+constexpr const char* kDepthDataType = "depth";
+
 // Exchange interface base class
 class IExchange {
 public:
@@ -55,6 +75,13 @@ public:
     virtual std::string getName() const = 0;
     virtual std::string getDisplayName() const = 0;
     
+    // Re-establish a connection that dropped after connect(). Market data
+    // subscriptions do not survive it and have to be renewed by the caller.
+    virtual bool reconnect() {
+        disconnect();
+        return connect();
+    }
+    
     // ========== Account related ==========
     virtual AccountInfo getAccountInfo() = 0;
     virtual std::vector<ExchangePosition> getPositions() = 0;
@@ -64,13 +91,13 @@ public:
     virtual std::string placeOrder(
         const std::string& symbol,
         const std::string& side,      // "BUY" or "SELL"
-        int quantity,
+        Quantity quantity,
         const std::string& order_type, // "MARKET" or "LIMIT"
-        double price = 0.0
+        Price price = Price()
     ) = 0;
     
     virtual bool cancelOrder(const std::string& order_id) = 0;
-    virtual bool modifyOrder(const std::string& order_id, int new_quantity, double new_price) = 0;
+    virtual bool modifyOrder(const std::string& order_id, Quantity new_quantity, Price new_price) = 0;
     virtual OrderData getOrderStatus(const std::string& order_id) = 0;
     virtual std::vector<OrderData> getOrderHistory(int days = 1) = 0;
     
@@ -80,18 +107,99 @@ public:
     virtual bool subscribeTick(const std::string& symbol) = 0;
     virtual bool unsubscribeTick(const std::string& symbol) = 0;
     
+    // Subscribe or unsubscribe many symbols to one data type (kTickDataType,
+    // kDepthDataType or a K-line type) in a single request. Returns false if
+    // the request could not be sent; otherwise `on_complete` reports the
+    // exchange's answer, and may run on an exchange callback thread.
+    // The default applies the per-symbol calls above synchronously and has
+    // no order book feed.
+    virtual bool updateSubscriptions(const std::vector<std::string>& symbols,
+                                     const std::string& data_type,
+                                     bool subscribe,
+                                     SubscriptionCallback on_complete) {
+        if (data_type == kDepthDataType) {
+            return false;
+        }
+        bool ok = true;
+        for (const auto& symbol : symbols) {
+            if (data_type == kTickDataType) {
+                ok = (subscribe ? subscribeTick(symbol) : unsubscribeTick(symbol)) && ok;
+            } else {
+                ok = (subscribe ? subscribeKLine(symbol, data_type) : unsubscribeKLine(symbol)) && ok;
+            }
+        }
+        if (on_complete) on_complete(ok);
+        return true;
+    }
+    
+    // Account-wide subscription quota in units of getSubscriptionCost().
+    // Returns false if the exchange does not limit subscriptions.
+    virtual bool getSubscriptionQuota(int& used, int& remaining) {
+        (void)used;
+        (void)remaining;
+        return false;
+    }
+    
+    // Quota units one symbol consumes for `data_type`
+    virtual int getSubscriptionCost(const std::string& data_type) const {
+        (void)data_type;
+        return 1;
+    }
+    
+    // Minimum time a subscription must be held before it can be released
+    virtual int getMinSubscriptionHoldSeconds() const { return 0; }
+    
+    // Market whose trading sessions apply ("HK", "US", "CN"), empty if unknown
+    virtual std::string getMarket() const { return ""; }
+    
+    // Trading days of the market from `begin_date` to `end_date` (YYYYMMDD,
+    // inclusive), holidays left out. Returns false if the exchange does not
+    // publish a calendar.
+    virtual bool getTradeDates(int begin_date, int end_date, std::vector<TradeDay>& days) {
+        (void)begin_date;
+        (void)end_date;
+        (void)days;
+        return false;
+    }
+    
     virtual std::vector<KlineData> getHistoryKLine(
         const std::string& symbol,
         const std::string& kline_type,
         int count
     ) = 0;
     
+    // Limit on getHistoryKLine requests; bulk loaders pace themselves to stay under it
+    virtual RequestRateLimit getHistoryRateLimit() const { return {}; }
+    
+    // Symbols that may still be fetched through getHistoryKLine in the
+    // exchange's quota period. Returns false if history is not quota-limited.
+    virtual bool getHistoryQuota(int& used, int& remaining) {
+        (void)used;
+        (void)remaining;
+        return false;
+    }
+    
     virtual Snapshot getSnapshot(const std::string& symbol) = 0;
     
     // ========== Market scanning related ==========
     virtual std::vector<std::string> getMarketStockList() = 0;
     virtual std::map<std::string, Snapshot> getBatchSnapshots(const std::vector<std::string>& stock_codes) = 0;
     
+    // Request snapshots without waiting for them, so several requests can be
+    // in flight. Returns false if the request could not be sent; otherwise
+    // `on_complete` receives the snapshots, possibly on an exchange callback
+    // thread. The default fetches synchronously through getBatchSnapshots.
+    virtual bool requestBatchSnapshots(const std::vector<std::string>& stock_codes,
+                                       SnapshotBatchCallback on_complete) {
+        auto snapshots = getBatchSnapshots(stock_codes);
+        bool success = !snapshots.empty() || stock_codes.empty();
+        if (on_complete) on_complete(success, std::move(snapshots));
+        return true;
+    }
+    
+    // Limit on snapshot requests; callers pace themselves to stay under it
+    virtual RequestRateLimit getSnapshotRateLimit() const { return {}; }
+    
     // ========== Event-driven interface ==========
     // Exchange implementations should convert raw data to unified formats and publish events.
     // Callbacks are not used; use the event engine instead.
@@ -43,9 +43,9 @@ public:
         const std::string& exchange_name,
         const std::string& symbol,
         const std::string& side,
-        int quantity,
+        Quantity quantity,
         const std::string& order_type,
-        double price = 0.0
+        Price price = Price()
     );
     
     bool cancelOrder(const std::string& exchange_name, const std::string& order_id);
@@ -18,6 +18,9 @@ namespace Futu {
 namespace Qot_Common {
     class Security;
 }
+namespace Qot_GetSecuritySnapshot {
+    class Response;
+}
 class FutuSpi;
 #endif
 
@@ -41,6 +44,7 @@ public:
     bool connect() override;
     bool disconnect() override;
     bool isConnected() const override;
+    bool reconnect() override;
     std::string getName() const override { return "futu"; }
     std::string getDisplayName() const override { return "Futu Securities"; }
     
@@ -53,13 +57,13 @@ public:
     std::string placeOrder(
         const std::string& symbol,
         const std::string& side,
-        int quantity,
+        Quantity quantity,
         const std::string& order_type,
-        double price = 0.0
+        Price price = Price()
     ) override;
     
     bool cancelOrder(const std::string& order_id) override;
-    bool modifyOrder(const std::string& order_id, int new_quantity, double new_price) override;
+    bool modifyOrder(const std::string& order_id, Quantity new_quantity, Price new_price) override;
     OrderData getOrderStatus(const std::string& order_id) override;
     std::vector<OrderData> getOrderHistory(int days = 1) override;
     
@@ -68,18 +72,32 @@ public:
     bool unsubscribeKLine(const std::string& symbol) override;
     bool subscribeTick(const std::string& symbol) override;
     bool unsubscribeTick(const std::string& symbol) override;
+    bool updateSubscriptions(const std::vector<std::string>& symbols,
+                             const std::string& data_type,
+                             bool subscribe,
+                             SubscriptionCallback on_complete) override;
+    bool getSubscriptionQuota(int& used, int& remaining) override;
+    int getSubscriptionCost(const std::string& data_type) const override;
+    int getMinSubscriptionHoldSeconds() const override { return 60; }   // OpenD rule
+    std::string getMarket() const override { return config_.market; }
+    bool getTradeDates(int begin_date, int end_date, std::vector<TradeDay>& days) override;
     
     std::vector<KlineData> getHistoryKLine(
         const std::string& symbol,
         const std::string& kline_type,
         int count
     ) override;
+    RequestRateLimit getHistoryRateLimit() const override { return {60, 30, 1}; }       // OpenD rule
+    bool getHistoryQuota(int& used, int& remaining) override;
     
     Snapshot getSnapshot(const std::string& symbol) override;
     
     // ========== Market scanning related ==========
     std::vector<std::string> getMarketStockList() override;
     std::map<std::string, Snapshot> getBatchSnapshots(const std::vector<std::string>& stock_codes) override;
+    bool requestBatchSnapshots(const std::vector<std::string>& stock_codes,
+                               SnapshotBatchCallback on_complete) override;
+    RequestRateLimit getSnapshotRateLimit() const override { return {60, 30, 400}; }   // OpenD rule
     
     // ========== Event engine ==========
     IEventEngine* getEventEngine() const override { return event_engine_; }
@@ -106,6 +124,7 @@ private:
     #ifdef ENABLE_FUTU
     Qot_Common::Security convertToSecurity(const std::string& symbol);
     int32_t convertKLineType(const std::string& kline_type);
+    std::map<std::string, Snapshot> convertSnapshots(const Qot_GetSecuritySnapshot::Response& rsp);
     #endif
 };
 
@@ -113,5 +132,6 @@ private:
 extern "C"
 {
 	QTS_DECL_EXPORT const char* GetExchangeClass();
+	QTS_DECL_EXPORT void BindSymbolRegistry(SymbolRegistry* registry);
 	QTS_DECL_EXPORT IExchange* GetExchangeInstance(IEventEngine* event_engine, const std::map<std::string, std::string>& config);
 }
\ No newline at end of file
@@ -41,13 +41,13 @@ public:
     std::string placeOrder(
         const std::string& symbol,
         const std::string& side,
-        int quantity,
+        Quantity quantity,
         const std::string& order_type,
-        double price = 0.0
+        Price price = Price()
     ) override;
     
     bool cancelOrder(const std::string& order_id) override;
-    bool modifyOrder(const std::string& order_id, int new_quantity, double new_price) override;
+    bool modifyOrder(const std::string& order_id, Quantity new_quantity, Price new_price) override;
     OrderData getOrderStatus(const std::string& order_id) override;
     std::vector<OrderData> getOrderHistory(int days = 1) override;
     
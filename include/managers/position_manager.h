@@ -4,18 +4,21 @@
 #include <map>
 #include <mutex>
 #include <memory>
+#include "common/symbol_registry.h"
+#include "common/fixed_point.h"
 
  
 
 struct Position {
+    SymbolId symbol_id = kInvalidSymbolId;
     std::string symbol;
-    int quantity;
-    double avg_price;
-    double current_price;
-    double cost;
-    double market_value;
-    double profit_loss;
-    double profit_loss_ratio;
+    Quantity quantity;
+    Price avg_price;
+    Price current_price;
+    Amount cost;                // exact cost basis of the open quantity
+    Amount market_value;
+    Amount profit_loss;
+    double profit_loss_ratio = 0.0;
     std::string side;  // "LONG" or "SHORT"
 };
 
@@ -23,21 +26,25 @@ class PositionManager {
 public:
     static PositionManager& getInstance();
     
-    // Update position
-    void updatePosition(const std::string& symbol, int quantity, double price);
+    // Update position; `exchange` is the one the order went to, empty if unknown
+    void updatePosition(const std::string& symbol, Quantity quantity, Price price,
+                        const std::string& exchange = "");
 
     // Update market price
-    void updateMarketPrice(const std::string& symbol, double price);
+    void updateMarketPrice(const std::string& symbol, Price price);
+    void updateMarketPrice(SymbolId symbol_id, Price price);
 
     // Get position
     Position* getPosition(const std::string& symbol);
+    Position* getPosition(SymbolId symbol_id);
     std::map<std::string, Position> getAllPositions();
 
     // Position queries
     int getTotalPositions() const;
-    double getTotalMarketValue() const;
-    double getTotalProfitLoss() const;
+    Amount getTotalMarketValue() const;
+    Amount getTotalProfitLoss() const;
     bool hasPosition(const std::string& symbol) const;
+    bool hasPosition(SymbolId symbol_id) const;
 
     // Clear positions (for testing)
     void clearPositions();
@@ -49,7 +56,8 @@ public:
 private:
     PositionManager() = default;
     
-    std::map<std::string, Position> positions_;
+    // Indexed by symbol id; string-keyed calls resolve through SymbolRegistry
+    SymbolMap<Position> positions_;
     mutable std::mutex mutex_;
     
     void calculateProfitLoss(Position& position);
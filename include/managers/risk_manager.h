@@ -3,6 +3,7 @@
 #include <string>
 #include <map>
 #include <mutex>
+#include "common/fixed_point.h"
 
  
 
@@ -21,14 +22,14 @@ public:
     static RiskManager& getInstance();
     
     // Risk checks
-    bool checkOrderRisk(const std::string& symbol, int quantity, double price);
+    bool checkOrderRisk(const std::string& symbol, Quantity quantity, Price price);
 
     // Check stop-loss / take-profit conditions
-    bool shouldStopLoss(const std::string& symbol, double current_price);
-    bool shouldTakeProfit(const std::string& symbol, double current_price);
+    bool shouldStopLoss(const std::string& symbol, Price current_price);
+    bool shouldTakeProfit(const std::string& symbol, Price current_price);
 
     // Calculate suggested position size
-    int calculatePositionSize(double stock_price, double available_cash);
+    Quantity calculatePositionSize(Price stock_price, Amount available_cash);
 
     // Update risk metrics
     void updateDailyPnL(double pnl);
@@ -15,6 +15,7 @@
 class StrategyBase;
 
 struct ScanResult {
+    SymbolId symbol_id = kInvalidSymbolId;
     std::string symbol;
     std::string stock_name;
     double price;
@@ -39,9 +40,10 @@ struct ScanResult {
 
 // Strategy instance information
 struct StrategyInstance {
+    SymbolId symbol_id = kInvalidSymbolId;
     std::string symbol;
     std::shared_ptr<StrategyBase> strategy;
-    bool is_active;
+    bool is_active = false;
     std::string exchange_name;  // exchange name
     std::shared_ptr<IExchange> exchange;  // corresponding exchange instance
 };
@@ -53,13 +55,24 @@ public:
     // Initialize event handlers
     void initializeEventHandlers(IEventEngine* event_engine);
 
-    // Dynamic strategy management - create/remove strategy instances based on scan results
-    void processScanResults(const std::vector<ScanResult>& results);
+    // Dynamic strategy management - create/remove strategy instances based on scan results.
+    // Each exchange is scanned on its own: only instances of `exchange_name`
+    // are removed when they drop out of its results.
+    void processScanResults(const std::string& exchange_name, const std::vector<ScanResult>& results);
+
+    // Incremental form for a ranking kept by the scanner: `top` is the
+    // exchange's current top N, `entered` and `left` its changes since the
+    // last call. Only stocks that left are removed; strategies kept for an
+    // open position are retried on later calls.
+    void processRankingChanges(const std::string& exchange_name,
+                               const std::vector<ScanResult>& top,
+                               const std::vector<SymbolId>& entered,
+                               const std::vector<SymbolId>& left);
 
     // Strategy instance management
-    void createStrategyInstance(const std::string& symbol, const ScanResult& scan_result);
-    void removeStrategyInstance(const std::string& symbol, bool force = false);
-    bool hasStrategyInstance(const std::string& symbol) const;
+    void createStrategyInstance(const ScanResult& scan_result);
+    void removeStrategyInstance(SymbolId symbol_id, bool force = false);
+    bool hasStrategyInstance(SymbolId symbol_id) const;
 
     // Start/stop all strategies
     void startAllStrategies();
@@ -77,11 +90,11 @@ public:
 private:
     StrategyManager() = default;
     
-    // stock symbol -> strategy instance
-    std::map<std::string, StrategyInstance> strategy_instances_;
+    // symbol id -> strategy instance
+    SymbolMap<StrategyInstance> strategy_instances_;
 
-    // set of stock symbols from last scan
-    std::set<std::string> last_scan_stocks_;
+    // exchange name -> symbol ids from its last scan
+    std::map<std::string, std::set<SymbolId>> last_scan_stocks_;
 
     // event engine pointer
     IEventEngine* event_engine_ = nullptr;
@@ -94,7 +107,8 @@ private:
     mutable std::mutex mutex_;
     
     // internal helper functions
-    bool canRemoveStrategy(const std::string& symbol) const;
+    bool canRemoveStrategy(SymbolId symbol_id) const;
+    StrategyInstance* findInstance(SymbolId symbol_id, const std::string& exchange, const std::string& symbol);
     std::shared_ptr<StrategyBase> createStrategy(const std::string& symbol, const ScanResult& scan_result);
 
     // event handlers
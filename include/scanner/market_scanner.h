@@ -3,6 +3,11 @@
 #include "exchange/exchange_interface.h"
 #include "managers/strategy_manager.h"
 #include "config/config_manager.h"
+#include "event/event_interface.h"
+#include "scanner/snapshot_table.h"
+#include "scanner/top_n_ranking.h"
+#include "scanner/volume_curve.h"
+#include "utils/request_window.h"
 #include <string>
 #include <vector>
 #include <thread>
@@ -11,17 +16,42 @@
 #include <chrono>
 #include <ctime>
 #include <mutex>
+#include <condition_variable>
+#include <map>
+#include <set>
 #include <deque>
+#include <functional>
 
+// Scans each exchange on its own worker thread, so a slow or failing
+// exchange never delays the others: every worker keeps its own interval
+// and error backoff, and
+// hands its results to the StrategyManager, which keeps each exchange's
+// strategy instances apart.
+// Workers follow their market's phases in the TradingCalendar: continuous
+// trading is scanned (faster in the first 30 minutes of a session), the
+// opening auction or pre-market slowly, and breaks, closes and holidays not
+// at all.
+// Each exchange's qualified stocks are kept in a TopNRanking across polls,
+// so the StrategyManager is told which stocks entered and left the top_n
+// rather than handed a fresh list to diff.
+// With scanner.push_enabled, each poll also picks the exchange's best
+// push_symbols candidates and holds tick feeds for them. Their quote pushes
+// are re-scored on a push worker as they change, and the exchange's ranking
+// is handed over again as soon as its top_n changes; the rest of the
+// universe is only seen by polls.
 class MarketScanner {
 public:
     MarketScanner();
     ~MarketScanner();
     
-    // Add an exchange instance (supports multiple exchanges)
+    // Add an exchange instance (supports multiple exchanges); scanned right
+    // away if the scanner is already running
     void addExchange(std::shared_ptr<IExchange> exchange);
     
-    // Start scanning all added exchanges
+    // Quote pushes for push mode
+    void initializeEventHandlers(IEventEngine* event_engine);
+    
+    // Start one scan worker per added exchange, plus the push worker
     void start();
     void stop();
     bool isRunning() const { return running_; }
@@ -35,19 +65,32 @@ public:
         bool running;
         std::map<std::string, int> watch_list_counts;
         std::map<std::string, std::vector<std::string>> qualified_stocks;
-        bool is_trading_time;
-        bool is_opening_period;
+        bool is_trading_time;                          // some exchange's market is in continuous trading
+        bool is_opening_period;                        // some exchange's market is in an opening period
         std::vector<std::string> active_exchanges;
+        std::map<std::string, int64_t> last_scan_ms;   // duration of each exchange's last scan
     };
     
     ScannerStatus getStatus() const;
     
+    // Compile and swap in the filter and score expressions (empty = built
+    // in) without stopping the scan workers; the next evaluation uses them.
+    // On a compile error the current ones stay and false is returned.
+    bool setScanExpressions(const std::string& filter, const std::string& score);
+    
 private:
     std::atomic<bool> running_;
-    std::unique_ptr<std::thread> scan_thread_;
+    std::vector<std::thread> scan_threads_;          // one per exchange
     std::vector<std::shared_ptr<IExchange>> exchanges_;
     mutable std::mutex exchanges_mutex_;
     
+    // Wakes sleeping workers on stop()
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    
+    std::map<std::string, int64_t> last_scan_ms_;
+    mutable std::mutex scan_stats_mutex_;
+    
     // Watch lists (grouped by exchange)
     std::map<std::string, std::vector<std::string>> watch_lists_;
     mutable std::mutex watch_list_mutex_;
@@ -59,51 +102,166 @@ private:
     // Scanner parameter configuration
     ScannerParams scanner_params_;
     static constexpr int BATCH_SIZE = 400;
+    static constexpr int SNAPSHOT_TIMEOUT_MS = 10000;         // a batch not answered by then is dropped
     static constexpr int OPENING_SCAN_INTERVAL_MS = 30000;     // 30s during opening period (faster to catch breakouts)
     static constexpr int NORMAL_SCAN_INTERVAL_MS = 60000;      // 60s during normal trading
-    static constexpr int NON_TRADING_SCAN_INTERVAL_MS = 120000; // 120s outside trading hours
+    static constexpr int AUCTION_SCAN_INTERVAL_MS = 120000;    // 120s in the opening auction or pre-market
+    static constexpr int MAX_IDLE_WAIT_MS = 3600000;           // longest sleep while the market is not trading
     
     // === Breakout detection ===
     // Historical volume cache (used to compute volume ratio)
     struct VolumeHistory {
-        std::deque<int64_t> daily_volumes;  // recent N days' volumes
-        int64_t avg_volume = 0;             // average volume
-        double last_price = 0.0;            // last scanned price (used to compute price speed)
-        int64_t last_scan_time = 0;         // last scan timestamp
+        int64_t avg_volume = 0;             // average of the VOLUME_HISTORY_DAYS sessions before trading_date
+        int trading_date = 0;               // YYYYMMDD on the market's clock
     };
-    std::map<std::string, VolumeHistory> volume_history_;
+    SymbolMap<VolumeHistory> volume_history_;
     mutable std::mutex volume_history_mutex_;
     static constexpr int VOLUME_HISTORY_DAYS = 5;
+    static constexpr size_t BOOK_RATIO_LEVELS = 5;   // order book levels in the bid/ask ratio
+    
+    // === Volume history preload ===
+    // Once per trading date each exchange's watch list takes its volume
+    // averages from the on-disk cache, and the rest are fetched on the
+    // preload worker within the exchange's history limits. Scans keep
+    // loading averages they miss on demand meanwhile.
+    struct PreloadRequest {
+        std::shared_ptr<IExchange> exchange;
+        std::vector<std::string> symbols;
+        int trading_date = 0;
+    };
+    std::deque<PreloadRequest> preload_queue_;
+    std::mutex preload_mutex_;
+    std::condition_variable preload_cv_;
+    std::thread preload_thread_;
+    
+    void preloadLoop();
+    void preloadVolumeHistory(const PreloadRequest& request);
+    // Averages from a new trading date on; queues the watch list's preload
+    void beginTradingDate(const std::shared_ptr<IExchange>& exchange, int trading_date);
     
-    // Cache of last scan snapshots (used to compute price speed)
-    std::map<std::string, Snapshot> last_snapshots_;
-    mutable std::mutex last_snapshots_mutex_;
+    // <volume_cache_dir>/<exchange>/avg_volume_<YYYYMMDD>.txt, "symbol average" per line
+    std::string volumeCachePath(const std::string& exchange_name, int trading_date) const;
+    size_t loadVolumeCache(const std::string& exchange_name, int trading_date);
+    void saveVolumeCache(const std::string& exchange_name, int trading_date);
+    
+    // Intraday volume curves are rebuilt from the bar store's 1-minute bars
+    // once per trading date, after the averages they are bucketed by
+    static constexpr int VOLUME_CURVE_DAYS = 20;
+    static constexpr size_t VOLUME_CURVE_MIN_DAYS = 20;     // full days across the watch list
+    
+    // <volume_cache_dir>/<exchange>/volume_curve.txt
+    std::string volumeCurvePath(const std::string& exchange_name) const;
+    // The saved curve, or a straight line until one is built
+    void loadVolumeCurve(const std::shared_ptr<IExchange>& exchange);
+    void refreshVolumeCurve(const PreloadRequest& request);
+    
+    // === Ranking ===
+    // Ranking of one exchange, carried across polls and quote pushes
+    struct LiveRanking {
+        TopNRanking index;                          // qualified stocks by score
+        std::set<SymbolId> pushed;                  // tick feeds held by the scanner
+    };
+    std::map<std::string, LiveRanking> live_rankings_;
+    std::mutex live_mutex_;
+    
+    // === Push mode ===
+    struct PushCandidate {
+        SymbolId symbol_id;
+        std::string symbol;
+        double score;
+    };
     
-    void scanLoop();
-    void performScan(const std::shared_ptr<IExchange>& exchange);
+    SymbolMap<TickData> pending_quotes_;            // latest push per symbol, awaiting the push worker
+    SymbolMap<bool> push_feeds_;                    // every ranking's `pushed`, for the event thread
+    std::mutex quotes_mutex_;
+    std::condition_variable quotes_cv_;
+    std::thread push_thread_;
     
-    // Fetch market snapshots in batches
-    std::vector<ScanResult> batchFetchMarketData(const std::shared_ptr<IExchange>& exchange, const std::vector<std::string>& symbols);
+    IEventEngine* event_engine_ = nullptr;
+    int tick_handler_id_ = -1;
     
-    // Time checks
-    bool isInTradingTime() const;
-    bool isInOpeningPeriod() const;
+    void onTickEvent(const EventPtr& event);
+    void pushLoop();
+    void evaluateQuote(const TickData& tick);
     
-    // Filtering and scoring
-    bool meetsSelectionCriteria(ScanResult& result);
-    double calculateScore(const ScanResult& result) const;
-    ScanResult convertSnapshotToScanResult(const Snapshot& snapshot, 
-                                           const std::string& exchange_name,
-                                           std::shared_ptr<IExchange> exchange = nullptr);
+    // After a poll: the candidates to push
+    void updatePushSet(const std::string& exch_name, const std::vector<PushCandidate>& candidates);
+    void releasePushFeeds();
+    
+    // ScanResults of ranked symbols from their table rows, in the given order
+    std::vector<ScanResult> rankedResults(const std::shared_ptr<IExchange>& exchange,
+                                          const std::vector<SymbolId>& symbol_ids);
+    
+    // Record the exchange's top_n and hand it with its changes to the StrategyManager
+    void publishResults(const std::string& exch_name, const std::vector<ScanResult>& results,
+                        const RankingDelta& delta);
+    
+    void scanLoop(std::shared_ptr<IExchange> exchange);
+    // Poll the exchange's watch list and rank it. With tiered scanning only
+    // the stocks due in their tier are fetched unless `full`.
+    void performScan(const std::shared_ptr<IExchange>& exchange, RequestWindow& snapshot_window, bool full);
+    
+    // Sleep up to `ms`; false once stopping
+    bool waitFor(int ms);
+    
+    // Fetch market snapshots in batches, keeping up to
+    // snapshot_requests_in_flight requests outstanding within the exchange's
+    // snapshot rate limit. Each batch is handed to `on_batch` on the calling
+    // thread as soon as it lands. Returns the snapshots received.
+    size_t batchFetchMarketData(const std::shared_ptr<IExchange>& exchange,
+                                const std::vector<std::string>& symbols,
+                                RequestWindow& snapshot_window,
+                                const std::function<void(const std::map<std::string, Snapshot>&)>& on_batch);
+    
+    // === Snapshot table ===
+    // Latest snapshot of every scanned stock in columns; filtering and
+    // scoring run over it, and ScanResults are built for selected rows only
+    SnapshotTable table_;
+    std::vector<std::string> table_markets_;        // by table exchange index
+    std::vector<uint32_t> scan_generations_;        // latest scan started
+    std::vector<uint32_t> completed_generations_;   // latest scan ranked
+    std::vector<VolumeCurve> table_curves_;         // invalid: no session table
+    ScanKernelParams kernel_params_;
+    std::mutex table_mutex_;
+    
+    // Scanner settings expressions may name, e.g. change_min
+    std::map<std::string, double> expressionConstants() const;
+    
+    // Scans between polls of each tier; all 1 without tiered scanning
+    std::array<uint32_t, kScanTiers> tierCycles() const;
+    
+    // Helpers below expect table_mutex_ to be held
+    uint16_t tableIndex(const std::shared_ptr<IExchange>& exchange);
+    // Kernel inputs; rows of `scanning_index` older than `generation` drop out
+    std::vector<ScanExchangeFactors> exchangeFactors(int scanning_index = -1, uint32_t generation = 0) const;
+    
+    // Store a batch of polled snapshots; returns the rows whose figures changed
+    std::vector<uint32_t> ingestSnapshots(const std::string& exch_name, uint16_t exchange_index,
+                                          uint32_t generation,
+                                          const std::map<std::string, Snapshot>& snapshots);
+    void loadMissingHistory(const std::shared_ptr<IExchange>& exchange,
+                            const std::vector<SymbolId>& symbol_ids,
+                            std::set<SymbolId>& tried);
+    ScanResult toScanResult(const ScanRow& row, const std::shared_ptr<IExchange>& exchange) const;
+    
+    // First 30 minutes of one of the market's sessions today, on its own
+    // clock; never for round-the-clock markets
+    bool isInOpeningPeriod(const std::string& market) const;
     
     // === Breakout detection methods ===
-    double calculateVolumeRatio(const std::string& symbol, int64_t current_volume,
-                                 const std::shared_ptr<IExchange>& exchange);
-    double calculateSpeed(const std::string& symbol, double current_price) const;
+    // Average daily volume of the last VOLUME_HISTORY_DAYS, loaded on first
+    // use each trading date; 0 if the exchange has none
+    double loadAverageVolume(SymbolId symbol_id, const std::string& symbol,
+                             const std::shared_ptr<IExchange>& exchange);
+    // Daily volumes from the exchange, averaged over the completed sessions
+    // before `trading_date`; 0 if unavailable
+    int64_t fetchAverageVolume(const std::shared_ptr<IExchange>& exchange, const std::string& symbol,
+                               int trading_date);
+    // Expected full-day volume over the volume traded so far, pro rata to
+    // the day's trading minutes, where no volume curve is available yet;
+    // a round-the-clock market's day starts at its midnight
+    static double volumeExtrapolation(const std::string& market, int64_t now_ns);
+    // Level-1 bid/ask ratio, used where no full book is subscribed; level 1
+    // alone is easily spoofed
     double calculateBidAskRatio(const Snapshot& snapshot) const;
-    void updateVolumeHistory(const std::string& symbol, int64_t volume, double price);
-    void initVolumeHistory(const std::shared_ptr<IExchange>& exchange, const std::vector<std::string>& symbols);
-    
-    // Get current time (hour, minute)
-    std::pair<int, int> getCurrentTime() const;
 };
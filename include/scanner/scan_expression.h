@@ -0,0 +1,88 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Snapshot table columns an expression can read
+enum class ScanColumn : uint8_t {
+    kPrice,
+    kPreClose,
+    kOpen,
+    kHigh,
+    kLow,
+    kVolume,
+    kTurnoverRate,
+    kBidAskRatio,
+    kAvgVolume,
+    kChange,
+    kAmplitude,
+    kSpeed,
+    kPriceVsHigh,
+    kVolumeRatio,       // score expressions only: known once history has loaded
+    kCount
+};
+constexpr size_t kScanColumnCount = static_cast<size_t>(ScanColumn::kCount);
+
+// Scanner rule compiled from config, e.g.
+//   change >= 0.02 && change <= change_max && price_vs_high <= 0.05
+//   min(1, volume_ratio / 10) * 35 + (bid_ask_ratio > 2 ? 5 : 0)
+// Numbers, column names, named constants, + - * /, comparisons, && || !,
+// ?: and min(a, b), max(a, b), abs(x), clamp(x, lo, hi). Conditions are 1
+// or 0; every value is a double and nothing short-circuits.
+//
+// Compilation folds constants into a flat register program. Evaluation runs
+// each instruction over a block of rows before the next, so dispatch costs
+// once per instruction and block while the loops over rows stay tight.
+// Immutable once compiled and safe to share between threads.
+class ScanExpression {
+public:
+    enum class Kind {
+        kFilter,        // rows pass where non-zero; may not read volume_ratio
+        kScore
+    };
+
+    // Null on a syntax error or unknown name, described in `error`
+    static std::shared_ptr<const ScanExpression> compile(const std::string& source, Kind kind,
+                                                         const std::map<std::string, double>& constants,
+                                                         std::string& error);
+
+    // Values of rows [begin, end) into `out`; `columns` is indexed by ScanColumn
+    void evaluate(const double* const* columns, size_t begin, size_t end, std::vector<double>& out) const;
+
+    const std::string& source() const { return source_; }
+    size_t instructionCount() const { return code_.size(); }
+
+    static const char* columnName(ScanColumn column);
+
+private:
+    enum class Op : uint8_t {
+        kAdd, kSub, kMul, kDiv, kMin, kMax, kNeg, kAbs, kNot,
+        kLt, kLe, kGt, kGe, kEq, kNe, kAnd, kOr, kSelect
+    };
+
+    // Operand slots: columns, then constants, then registers
+    struct Instruction {
+        Op op;
+        uint16_t dst;       // register
+        uint16_t a;
+        uint16_t b;
+        uint16_t c;
+    };
+
+    struct Node;
+    class Parser;
+    friend class Parser;
+
+    static double apply(Op op, double a, double b, double c);
+    static void run(Op op, double* dst, const double* a, const double* b, const double* c, size_t n);
+
+    std::string source_;
+    std::vector<Instruction> code_;
+    std::vector<double> constants_;
+    size_t registers_ = 0;
+    uint16_t result_ = 0;   // slot holding the value
+};
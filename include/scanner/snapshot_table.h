@@ -0,0 +1,203 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "common/object.h"
+#include "scanner/volume_curve.h"
+#include "scanner/scan_expression.h"
+
+// Breakout criteria and score weights as applied by the table kernels
+struct ScanKernelParams {
+    double min_price = 1.0;
+    double max_price = 1000.0;
+    double change_min = 0.02;
+    double change_max = 0.10;
+    double amplitude_min = 0.02;
+    double min_turnover_rate = 0.01;
+    double min_volume = 1000000;
+    double volume_ratio_min = 2.5;
+    double min_bid_ask_ratio = 0.8;       // weaker bids mean too much selling pressure
+    double max_price_vs_high = 0.05;      // further off the high has pulled back
+    double weight_volume = 35.0;
+    double weight_change = 25.0;
+    double weight_speed = 25.0;
+    double weight_turnover = 15.0;
+
+    // Configured replacements of the built-in criteria and score; null = built in
+    std::shared_ptr<const ScanExpression> filter;
+    std::shared_ptr<const ScanExpression> score;
+};
+
+// Refresh tier of a row, from how close its last metrics came to the criteria
+enum class ScanTier : uint8_t {
+    kHot,           // passes, or is halfway to the liquidity and change thresholds
+    kWarm,          // liquid but not moving
+    kCold           // under half the volume or turnover threshold, or priced out of range
+};
+constexpr size_t kScanTiers = 3;
+
+// Per-exchange inputs of one evaluation, indexed by exchange index
+struct ScanExchangeFactors {
+    // Rows drop out once the scan that should have refreshed them has run:
+    // a row of tier t last updated by scan g counts while g + tier_cycles[t]
+    // is past min_generation
+    uint32_t min_generation = 0;
+    std::array<uint32_t, kScanTiers> tier_cycles;
+    VolumeCurve::Thresholds volume_thresholds{};    // average volume bucket bounds
+    // Expected full-day volume / volume so far, by average volume bucket
+    std::array<double, kVolumeBuckets> volume_extrapolation;
+    double score_multiplier = 1.0;        // opening period bonus
+
+    ScanExchangeFactors() {
+        tier_cycles.fill(1);
+        volume_extrapolation.fill(1.0);
+    }
+};
+
+// One row, copied out for building a ScanResult
+struct ScanRow {
+    SymbolId symbol_id = kInvalidSymbolId;
+    uint16_t exchange_index = 0;
+    std::string name;
+    double price = 0.0;
+    double pre_close = 0.0;
+    double open_price = 0.0;
+    double high_price = 0.0;
+    double low_price = 0.0;
+    double volume = 0.0;
+    double turnover_rate = 0.0;
+    double bid_ask_ratio = 0.0;
+    double change_ratio = 0.0;
+    double amplitude = 0.0;
+    double speed = 0.0;
+    double price_vs_high = 0.0;
+    double volume_ratio = 0.0;
+    double score = 0.0;
+};
+
+// Column store of the scanner's latest snapshots, one row per symbol of
+// every scanned exchange. Breakout criteria and scores are computed by
+// branch-free loops over the columns, so a whole multi-market universe is
+// rescored in one pass per kernel. Evaluation runs in two passes: prefilter()
+// applies everything but the volume ratio, whose history the caller loads
+// for the rows it reports, then score() finishes the mask and the score.
+// Not thread-safe; the scanner guards it with its own mutex.
+class SnapshotTable {
+public:
+    enum class Selection {
+        kQualified,     // meets every criterion
+        kRising         // up on the day within the price range: push candidates
+    };
+
+    // Stable index of an exchange name, used to key ScanExchangeFactors
+    uint16_t exchangeIndex(const std::string& exchange_name);
+    size_t exchangeCount() const { return exchange_names_.size(); }
+
+    // Store a polled snapshot; the row's previous price becomes the speed
+    // reference. A snapshot that would leave every column as it is only
+    // marks the row as polled by `generation` and returns false, so its
+    // derived columns need no recomputing.
+    bool update(uint16_t exchange_index, uint32_t generation, const Snapshot& snapshot,
+                double bid_ask_ratio, uint32_t& row);
+
+    // Apply a pushed quote, keeping the speed reference of the last poll.
+    // Returns false if the symbol has no row or its quote did not change.
+    bool updateQuote(SymbolId symbol_id, const TickData& tick);
+
+    // Trailing average daily volume; 0 = unknown
+    void setAverageVolume(SymbolId symbol_id, double avg_volume);
+    // Forget the exchange's averages, e.g. on a new trading date
+    void resetAverageVolumes(uint16_t exchange_index);
+
+    bool findRow(SymbolId symbol_id, uint32_t& row) const;
+    size_t size() const { return symbol_ids_.size(); }
+
+    // Derived columns, tiers and every criterion but the volume ratio, over
+    // rows [begin, end). Returns the symbols of `exchange_index` that pass
+    // and have no average volume yet.
+    std::vector<SymbolId> prefilter(const ScanKernelParams& params,
+                                    const std::vector<ScanExchangeFactors>& factors,
+                                    uint16_t exchange_index,
+                                    size_t begin, size_t end);
+    std::vector<SymbolId> prefilter(const ScanKernelParams& params,
+                                    const std::vector<ScanExchangeFactors>& factors,
+                                    uint16_t exchange_index) {
+        return prefilter(params, factors, exchange_index, 0, size());
+    }
+    // The same over the given rows, a run of adjacent rows at a time
+    std::vector<SymbolId> prefilter(const ScanKernelParams& params,
+                                    const std::vector<ScanExchangeFactors>& factors,
+                                    uint16_t exchange_index,
+                                    std::vector<uint32_t> rows);
+
+    // Volume ratio, final mask and score over rows [begin, end). A score
+    // expression still gets the opening multiplier of the row's exchange;
+    // where it is not finite the row scores -inf. A filter expression that
+    // is not finite fails the row.
+    void score(const ScanKernelParams& params, const std::vector<ScanExchangeFactors>& factors,
+               size_t begin, size_t end);
+    void score(const ScanKernelParams& params, const std::vector<ScanExchangeFactors>& factors) {
+        score(params, factors, 0, size());
+    }
+
+    // Selected rows of the exchange as of the last evaluation, in row order
+    std::vector<uint32_t> select(uint16_t exchange_index, Selection selection) const;
+    // The same, highest score first; `limit` 0 = all
+    std::vector<uint32_t> top(uint16_t exchange_index, Selection selection, size_t limit) const;
+
+    // Whether scan `generation` has to fetch the row again
+    bool due(uint32_t row, uint32_t generation, const std::array<uint32_t, kScanTiers>& tier_cycles) const {
+        return generation_[row] + tier_cycles[tier_[row]] <= generation;
+    }
+    // Rows of the exchange per tier
+    std::array<size_t, kScanTiers> tierCounts(uint16_t exchange_index) const;
+
+    bool qualified(uint32_t row) const { return qualified_[row] != 0; }
+    SymbolId symbolAt(uint32_t row) const { return symbol_ids_[row]; }
+    double scoreAt(uint32_t row) const { return score_[row]; }
+    ScanRow row(uint32_t row) const;
+
+private:
+    uint32_t rowOf(SymbolId symbol_id);
+    // Column pointers indexed by ScanColumn, for expressions
+    std::array<const double*, kScanColumnCount> expressionColumns() const;
+
+    SymbolMap<uint32_t> rows_;
+    std::vector<std::string> exchange_names_;
+
+    // Identity and cold columns
+    std::vector<SymbolId> symbol_ids_;
+    std::vector<uint16_t> exchange_;
+    std::vector<uint32_t> generation_;
+    std::vector<std::string> names_;
+
+    // Inputs
+    std::vector<double> price_;
+    std::vector<double> pre_close_;
+    std::vector<double> open_;
+    std::vector<double> high_;
+    std::vector<double> low_;
+    std::vector<double> volume_;
+    std::vector<double> turnover_rate_;
+    std::vector<double> bid_ask_ratio_;
+    std::vector<double> prev_price_;        // price at the previous poll
+    std::vector<double> avg_volume_;
+
+    // Derived
+    std::vector<double> change_;
+    std::vector<double> amplitude_;
+    std::vector<double> speed_;
+    std::vector<double> price_vs_high_;
+    std::vector<double> volume_ratio_;
+    std::vector<double> score_;
+    std::vector<uint8_t> basic_;            // every criterion but the volume ratio
+    std::vector<uint8_t> rising_;
+    std::vector<uint8_t> qualified_;
+    std::vector<uint8_t> tier_;             // ScanTier; new rows are hot until evaluated
+
+    std::vector<double> expression_out_;    // scratch of the expression kernels
+};
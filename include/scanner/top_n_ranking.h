@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <set>
+#include <vector>
+#include "common/object.h"
+
+// Symbols that entered or left a TopNRanking's top N. Changes accumulate
+// across calls and cancel out: a symbol that leaves and re-enters within
+// the same delta is not reported.
+struct RankingDelta {
+    std::vector<SymbolId> entered;
+    std::vector<SymbolId> left;
+
+    bool empty() const { return entered.empty() && left.empty(); }
+};
+
+// Scores of a set of symbols, kept ordered with the best `capacity` of them
+// held apart as the top N. Inserting, rescoring or removing a symbol costs
+// O(log n) and reports the top N membership it changed, so consumers can
+// follow the ranking through deltas instead of re-sorting and diffing full
+// sets. Equal scores rank the lower symbol id first. Not thread-safe.
+class TopNRanking {
+public:
+    explicit TopNRanking(size_t capacity = 0) : capacity_(capacity) {}
+
+    size_t capacity() const { return capacity_; }
+    void setCapacity(size_t capacity, RankingDelta& delta);
+
+    // Insert the symbol or move it to its new score
+    void update(SymbolId symbol_id, double score, RankingDelta& delta);
+    void remove(SymbolId symbol_id, RankingDelta& delta);
+    void clear();
+
+    bool contains(SymbolId symbol_id) const { return scores_.contains(symbol_id); }
+    bool inTop(SymbolId symbol_id) const;
+    size_t size() const { return scores_.size(); }
+
+    // Top N, highest score first
+    std::vector<SymbolId> top() const;
+    // Every ranked symbol, in no particular order
+    std::vector<SymbolId> symbols() const;
+
+private:
+    struct Entry {
+        double score;
+        SymbolId symbol_id;
+
+        // Best first
+        bool operator<(const Entry& other) const {
+            if (score != other.score) return score > other.score;
+            return symbol_id < other.symbol_id;
+        }
+    };
+
+    // Restore |top_| == min(capacity_, size()) with every top_ entry ranked
+    // ahead of every rest_ entry
+    void rebalance(RankingDelta& delta);
+    static void noteEntered(SymbolId symbol_id, RankingDelta& delta);
+    static void noteLeft(SymbolId symbol_id, RankingDelta& delta);
+
+    std::set<Entry> top_;
+    std::set<Entry> rest_;
+    SymbolMap<double> scores_;
+    size_t capacity_;
+};
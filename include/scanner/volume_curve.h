@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "common/object.h"
+
+// Liquidity buckets of a VolumeCurve, split by average daily volume
+constexpr size_t kVolumeBuckets = 4;
+
+// Expected share of a day's volume traded by each minute of a market's
+// continuous sessions, one curve per liquidity bucket. Volume piles up at
+// the open and the close, so extrapolating the volume so far linearly
+// overstates the day early in the session; dividing by the curve compares
+// it with what an average day has traded by the same minute instead.
+// Built from stored 1-minute bars by VolumeCurve::Builder.
+class VolumeCurve {
+public:
+    using Thresholds = std::array<double, kVolumeBuckets - 1>;
+
+    // Every minute trading alike, the straight line the curve replaces
+    static VolumeCurve uniform(const std::string& market);
+
+    // False for markets without a session table
+    bool valid() const { return minutes_ > 0; }
+    int builtDate() const { return built_date_; }
+    size_t samples(size_t bucket) const { return samples_[bucket]; }
+
+    // Upper average volume of each bucket but the last, ascending
+    const Thresholds& thresholds() const { return thresholds_; }
+    size_t bucketOf(double avg_volume) const;
+
+    // Cumulative share of the day's volume after `elapsed_minutes` of
+    // continuous trading. The first minute's share stands in before it has
+    // passed, so the opening auction is not extrapolated over the whole day.
+    double expectedShare(size_t bucket, int elapsed_minutes) const;
+
+    // Text file: a "market minutes date" line, the thresholds, then one line
+    // of samples and shares per bucket. Fails on a different session layout.
+    bool load(const std::string& path, const std::string& market);
+    bool save(const std::string& path) const;
+
+    // Accumulates days of 1-minute bars, bucketed by the symbol's average
+    class Builder {
+    public:
+        Builder(const std::string& market, const Thresholds& thresholds);
+
+        // Adds the days of `bars` (oldest first, stamped with their end
+        // time) before `before_date` that span the whole session. Returns
+        // the days added.
+        size_t addSymbol(double avg_volume, const std::vector<KlineData>& bars, int before_date);
+        size_t days() const { return pooled_days_; }
+
+        // Buckets with fewer than `min_days` use the pooled curve of all
+        // buckets. False if the pool itself has fewer.
+        bool build(int built_date, size_t min_days, VolumeCurve& out) const;
+
+        // Bucket bounds splitting `averages` into equally populated buckets
+        static Thresholds quantiles(std::vector<double> averages);
+
+    private:
+        // False for a day without volume
+        bool addDay(size_t bucket, const std::vector<double>& minute_volume);
+
+        std::string market_;
+        Thresholds thresholds_;
+        int minutes_ = 0;
+        std::array<std::vector<double>, kVolumeBuckets> share_sums_;
+        std::array<size_t, kVolumeBuckets> days_{};
+        std::vector<double> pooled_sums_;
+        size_t pooled_days_ = 0;
+    };
+
+private:
+    std::string market_;
+    int minutes_ = 0;
+    int built_date_ = 0;
+    Thresholds thresholds_{};
+    std::array<std::vector<double>, kVolumeBuckets> shares_;   // by elapsed minute - 1
+    std::array<size_t, kVolumeBuckets> samples_{};
+};
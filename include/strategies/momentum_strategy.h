@@ -26,9 +26,10 @@ private:
         double entry_volume_ratio = 0.0;   // volume ratio at entry
         double entry_score = 0.0;          // breakout score at entry
         int64_t entry_time_ms = 0;         // entry timestamp
+        std::string market;                // trading calendar the stale timer runs on
     };
 
-    std::map<std::string, ChaseEntry> chase_entries_;  // tracking of chased positions
+    SymbolMap<ChaseEntry> chase_entries_;  // tracking of chased positions, by symbol id
     mutable std::mutex chase_mutex_;
     
     // Technical indicator calculations
@@ -38,10 +39,10 @@ private:
     
     // Entry/exit decision logic for momentum chasing
     bool shouldEnter(const ScanResult& result, const std::vector<KlineData>& klines);
-    bool shouldChaseExit(const std::string& symbol, double current_price, double speed);
+    bool shouldChaseExit(SymbolId symbol_id, double current_price, double speed);
     
     // Position sizing
-    int calculateQuantity(const std::string& symbol, double price);
+    Quantity calculateQuantity(const std::string& symbol, Price price);
     
     // Utility methods
     int64_t currentTimeMs() const;
@@ -41,8 +41,12 @@ protected:
     void unsubscribeStock(const std::string& symbol);
     
     // Trading methods
-    bool buy(const std::string& symbol, int quantity, double price = 0.0);
-    bool sell(const std::string& symbol, int quantity, double price = 0.0);
+    // `exchange` names the exchange the symbol trades on, so the position is
+    // keyed like the exchange's market data
+    bool buy(const std::string& symbol, Quantity quantity, Price price = Price(),
+             const std::string& exchange = "");
+    bool sell(const std::string& symbol, Quantity quantity, Price price = Price(),
+              const std::string& exchange = "");
     
     // Get historical data
     std::vector<KlineData> getHistoryKLine(
@@ -14,9 +14,10 @@ public:
     std::string placeOrder(
         const std::string& symbol,
         OrderSide side,
-        int quantity,
+        Quantity quantity,
         OrderType type = OrderType::MARKET,
-        double price = 0.0
+        Price price = Price(),
+        const std::string& exchange = ""     // empty: the symbol's code is looked up alone
     );
     
     // Cancel an order
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/fixed_point.h"
+#include "common/symbol_registry.h"
+
+// Minimum price increment per instrument.
+// Adapters record the exchange-reported tick size when they see it; anything
+// without an explicit entry falls back to the rules of its exchange's market,
+// and is left unrounded where the market is unknown.
+class TickSizeTable {
+public:
+    static TickSizeTable& getInstance();
+
+    void setTickSize(SymbolId symbol_id, Price tick);
+    // Many at once under one lock
+    void setTickSizes(const std::vector<std::pair<SymbolId, Price>>& ticks);
+
+    // Tick size applicable to `symbol_id` at `price`; zero if unknown
+    Price tickSize(SymbolId symbol_id, Price price) const;
+
+    // Round a limit price to the instrument's tick grid
+    Price round(SymbolId symbol_id, Price price) const;
+
+    // HKEX spread table (part A)
+    static Price hkTickSize(Price price);
+    // Default tick of a market (HK, US, CN/SH/SZ) at `price`; zero if unknown
+    static Price marketTickSize(const std::string& market, Price price);
+
+    // Non-copyable
+    TickSizeTable(const TickSizeTable&) = delete;
+    TickSizeTable& operator=(const TickSizeTable&) = delete;
+
+private:
+    TickSizeTable() = default;
+
+    SymbolMap<Price> ticks_;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <string>
+
+// Exchange timestamp helpers.
+// Market data carries exchange time as epoch nanoseconds plus the exchange's
+// UTC offset; human-readable strings are produced only on demand.
+// Header-only: used directly by the exchange adapter modules.
+namespace exchange_time {
+
+constexpr int64_t kNanosPerSecond = 1000000000LL;
+constexpr int64_t kSecondsPerDay = 86400;
+
+// Local receive time, epoch ns
+inline int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+inline int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+inline void civilFromDays(int64_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(yoe + era * 400 + (m <= 2));
+}
+
+// How a market's wall clock maps to UTC
+struct TimeZoneRule {
+    int32_t standard_offset_sec = 8 * 3600;   // HK / CN default
+    bool us_dst = false;                      // apply US daylight saving rules
+
+    int32_t offsetFor(int y, unsigned m, unsigned d) const {
+        if (!us_dst) return standard_offset_sec;
+        // DST: second Sunday of March through the first Sunday of November
+        auto nthSunday = [y](unsigned month, int n) {
+            int64_t first = daysFromCivil(y, month, 1);
+            int weekday = static_cast<int>((first + 4) % 7);   // 0 = Sunday
+            if (weekday < 0) weekday += 7;
+            return static_cast<unsigned>(1 + (7 - weekday) % 7 + 7 * (n - 1));
+        };
+        unsigned dst_start = nthSunday(3, 2);
+        unsigned dst_end = nthSunday(11, 1);
+        bool in_dst = (m > 3 && m < 11) || (m == 3 && d >= dst_start) || (m == 11 && d < dst_end);
+        return standard_offset_sec + (in_dst ? 3600 : 0);
+    }
+};
+
+// HK and mainland China: UTC+8 all year
+inline const TimeZoneRule& chinaTime() {
+    static const TimeZoneRule rule{8 * 3600, false};
+    return rule;
+}
+
+// US equities: America/New_York. Switching per calendar day is exact for
+// market data, since the 2am change never falls inside a session.
+inline const TimeZoneRule& usEasternTime() {
+    static const TimeZoneRule rule{-5 * 3600, true};
+    return rule;
+}
+
+// Offset of the market's wall clock at an instant
+inline int32_t utcOffset(int64_t epoch_ns, const TimeZoneRule& rule) {
+    int64_t local_sec = epoch_ns / kNanosPerSecond + rule.standard_offset_sec;
+    int64_t days = local_sec / kSecondsPerDay - (local_sec % kSecondsPerDay < 0 ? 1 : 0);
+    int y;
+    unsigned m, d;
+    civilFromDays(days, y, m, d);
+    return rule.offsetFor(y, m, d);
+}
+
+namespace detail {
+
+inline bool digits(const char* p, int n, int& out) {
+    int v = 0;
+    for (int i = 0; i < n; ++i) {
+        unsigned c = static_cast<unsigned>(p[i]) - '0';
+        if (c > 9) return false;
+        v = v * 10 + static_cast<int>(c);
+    }
+    out = v;
+    return true;
+}
+
+// Last parsed date per thread; push callbacks see one trading day at a time
+struct DayCache {
+    char key[10] = {};
+    const TimeZoneRule* rule = nullptr;
+    int64_t day_start_utc_ns = 0;   // local midnight of `key` expressed in UTC
+    int32_t offset_sec = 0;
+};
+
+} // namespace detail
+
+// Parses "YYYY-MM-DD HH:MM:SS[.fff]" (':' is also accepted before the
+// fraction, up to 9 fractional digits) or a bare "YYYY-MM-DD" in the
+// exchange's local time. Returns epoch ns, or 0 if the string is malformed.
+// No allocation; the date part is resolved once per day per thread.
+inline int64_t parse(const char* s, size_t len, const TimeZoneRule& rule, int32_t* offset_out = nullptr) {
+    if (s == nullptr || len < 10 || s[4] != '-' || s[7] != '-') return 0;
+
+    thread_local detail::DayCache cache;
+    if (cache.rule != &rule || std::memcmp(cache.key, s, 10) != 0) {
+        int y, mo, d;
+        if (!detail::digits(s, 4, y) || !detail::digits(s + 5, 2, mo) || !detail::digits(s + 8, 2, d) ||
+            mo < 1 || mo > 12 || d < 1 || d > 31) {
+            return 0;
+        }
+        cache.offset_sec = rule.offsetFor(y, static_cast<unsigned>(mo), static_cast<unsigned>(d));
+        cache.day_start_utc_ns = (daysFromCivil(y, static_cast<unsigned>(mo), static_cast<unsigned>(d)) * kSecondsPerDay -
+                                  cache.offset_sec) * kNanosPerSecond;
+        std::memcpy(cache.key, s, 10);
+        cache.rule = &rule;
+    }
+    if (offset_out) *offset_out = cache.offset_sec;
+
+    if (len == 10) return cache.day_start_utc_ns;
+    if (len < 19 || s[13] != ':' || s[16] != ':') return 0;
+
+    int hh, mm, ss;
+    if (!detail::digits(s + 11, 2, hh) || !detail::digits(s + 14, 2, mm) || !detail::digits(s + 17, 2, ss)) {
+        return 0;
+    }
+
+    int64_t frac_ns = 0;
+    if (len > 20 && (s[19] == '.' || s[19] == ':')) {
+        int64_t scale = 100000000;
+        for (size_t i = 20; i < len && scale > 0; ++i, scale /= 10) {
+            unsigned c = static_cast<unsigned>(s[i]) - '0';
+            if (c > 9) break;
+            frac_ns += c * scale;
+        }
+    }
+
+    return cache.day_start_utc_ns + (static_cast<int64_t>(hh) * 3600 + mm * 60 + ss) * kNanosPerSecond + frac_ns;
+}
+
+inline int64_t parse(const std::string& s, const TimeZoneRule& rule, int32_t* offset_out = nullptr) {
+    return parse(s.data(), s.size(), rule, offset_out);
+}
+
+// "YYYY-MM-DD HH:MM:SS.mmm" in the exchange's local time
+inline std::string format(int64_t epoch_ns, int32_t utc_offset_sec) {
+    if (epoch_ns == 0) return std::string();
+
+    int64_t local_ns = epoch_ns + static_cast<int64_t>(utc_offset_sec) * kNanosPerSecond;
+    int64_t secs = local_ns / kNanosPerSecond;
+    int64_t rem_ns = local_ns % kNanosPerSecond;
+    if (rem_ns < 0) {
+        rem_ns += kNanosPerSecond;
+        --secs;
+    }
+    int64_t days = secs / kSecondsPerDay;
+    int64_t sod = secs % kSecondsPerDay;
+    if (sod < 0) {
+        sod += kSecondsPerDay;
+        --days;
+    }
+
+    int y;
+    unsigned m, d;
+    civilFromDays(days, y, m, d);
+
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u %02d:%02d:%02d.%03d",
+                  y, m, d,
+                  static_cast<int>(sod / 3600), static_cast<int>((sod / 60) % 60), static_cast<int>(sod % 60),
+                  static_cast<int>(rem_ns / 1000000));
+    return std::string(buf);
+}
+
+} // namespace exchange_time
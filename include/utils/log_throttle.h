@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Per-call-site rate limiter for hot-path logging.
+// Allows at most `max_lines` messages per `interval_ms` window and counts
+// everything dropped so the next emitted line can report it.
+// Header-only so it can be used from dynamically loaded exchange modules.
+class LogThrottle {
+public:
+    LogThrottle(uint32_t max_lines, int64_t interval_ms)
+        : max_lines_(max_lines), interval_ms_(interval_ms) {}
+
+    // Returns true if the caller should log; `suppressed` receives the number
+    // of messages dropped at this call site since the last emitted one.
+    bool allow(uint64_t& suppressed) {
+        int64_t now = nowMs();
+        int64_t window_start = window_start_.load(std::memory_order_relaxed);
+        if (now - window_start >= interval_ms_ &&
+            window_start_.compare_exchange_strong(window_start, now, std::memory_order_relaxed)) {
+            count_.store(0, std::memory_order_relaxed);
+        }
+
+        if (count_.fetch_add(1, std::memory_order_relaxed) < max_lines_) {
+            suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    static std::string suppressedSummary(uint64_t suppressed) {
+        return "[throttled] " + std::to_string(suppressed) + " similar message(s) suppressed";
+    }
+
+private:
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const uint32_t max_lines_;
+    const int64_t interval_ms_;
+    std::atomic<int64_t> window_start_{0};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+// 1-in-N sampler for per-event logging
+class LogSampler {
+public:
+    explicit LogSampler(uint32_t every_n) : every_n_(every_n == 0 ? 1 : every_n) {}
+
+    bool allow() {
+        return counter_.fetch_add(1, std::memory_order_relaxed) % every_n_ == 0;
+    }
+
+    uint32_t everyN() const { return every_n_; }
+
+private:
+    const uint32_t every_n_;
+    std::atomic<uint64_t> counter_{0};
+};
+
+// Generic call-site macros. `sink` is anything callable as sink(level, message),
+// e.g. `Logger::getInstance().log` or a class's `writeLog`.
+// The message expression is only evaluated when the line is actually emitted.
+#define QTS_LOG_THROTTLED(sink, level, max_lines, interval_ms, msg)              \
+    do {                                                                         \
+        static LogThrottle qts_log_throttle_((max_lines), (interval_ms));        \
+        uint64_t qts_log_suppressed_ = 0;                                        \
+        if (qts_log_throttle_.allow(qts_log_suppressed_)) {                      \
+            if (qts_log_suppressed_ > 0) {                                       \
+                sink((level), LogThrottle::suppressedSummary(qts_log_suppressed_)); \
+            }                                                                    \
+            sink((level), (msg));                                                \
+        }                                                                        \
+    } while (0)
+
+#define QTS_LOG_SAMPLED(sink, level, every_n, msg)                               \
+    do {                                                                         \
+        static LogSampler qts_log_sampler_((every_n));                           \
+        if (qts_log_sampler_.allow()) {                                          \
+            sink((level), "[sampled 1/" + std::to_string(qts_log_sampler_.everyN()) + "] " + (msg)); \
+        }                                                                        \
+    } while (0)
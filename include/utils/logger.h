@@ -8,6 +8,8 @@
 #include <iomanip>
 #include <filesystem>
 #include "logger_defines.h"
+#include "log_throttle.h"
+#include "rotating_log_file.h"
 #include "event/event_interface.h"
 
 class Logger {
@@ -17,6 +19,10 @@ public:
     void log(LogLevel level, const std::string& message);
     void setLogLevel(LogLevel level) { min_level_ = level; }
 
+    // Applies the logging section of the config. Until this is called the
+    // file sink opens lazily under "logs/" with default rotation settings.
+    void configure(LogLevel level, bool console, bool file, const RotatingLogFile::Options& file_options);
+
     void handld_logs(const EventPtr&);
 
     // Non-copyable
@@ -27,7 +33,10 @@ private:
     Logger();
     ~Logger();
     
-    std::ofstream log_file_;
+    RotatingLogFile log_file_;
+    RotatingLogFile::Options file_options_;
+    bool console_enabled_ = true;
+    bool file_enabled_ = true;
     LogLevel min_level_ = LogLevel::Info;
     std::mutex mutex_;
     
@@ -39,3 +48,15 @@ private:
 #define LOG_INFO(msg) Logger::getInstance().log(LogLevel::Info, msg)
 #define LOG_WARN(msg) Logger::getInstance().log(LogLevel::Warn, msg)
 #define LOG_ERROR(msg) Logger::getInstance().log(LogLevel::Error, msg)
+
+// Hot-path variants: at most `max_lines` per `interval_ms` at each call site
+#define LOG_DEBUG_THROTTLED(max_lines, interval_ms, msg) \
+    QTS_LOG_THROTTLED(Logger::getInstance().log, LogLevel::Debug, max_lines, interval_ms, msg)
+#define LOG_INFO_THROTTLED(max_lines, interval_ms, msg) \
+    QTS_LOG_THROTTLED(Logger::getInstance().log, LogLevel::Info, max_lines, interval_ms, msg)
+#define LOG_WARN_THROTTLED(max_lines, interval_ms, msg) \
+    QTS_LOG_THROTTLED(Logger::getInstance().log, LogLevel::Warn, max_lines, interval_ms, msg)
+
+// Hot-path variants: log only one in every `n` calls at each call site
+#define LOG_DEBUG_EVERY_N(n, msg) QTS_LOG_SAMPLED(Logger::getInstance().log, LogLevel::Debug, n, msg)
+#define LOG_INFO_EVERY_N(n, msg) QTS_LOG_SAMPLED(Logger::getInstance().log, LogLevel::Info, n, msg)
@@ -16,3 +16,10 @@ inline std::string levelToString(LogLevel level) {
         default: return "UNKNOWN";
     }
 }
+
+inline LogLevel stringToLevel(const std::string& level) {
+    if (level == "DEBUG") return LogLevel::Debug;
+    if (level == "WARN" || level == "WARNING") return LogLevel::Warn;
+    if (level == "ERROR") return LogLevel::Error;
+    return LogLevel::Info;
+}
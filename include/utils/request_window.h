@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Client-side pacing for request limits of the form "at most N requests in
+// any T seconds". Remembers the send time of the last N requests, so a
+// burst of N goes out at once and the next request waits until the oldest
+// one leaves the window. Not thread-safe; keep one per caller.
+class RequestWindow {
+public:
+    RequestWindow() = default;
+    RequestWindow(size_t max_requests, int64_t window_ms)
+        : max_requests_(max_requests), window_ms_(window_ms) {}
+
+    bool limited() const { return max_requests_ > 0 && window_ms_ > 0; }
+
+    // Milliseconds until another request may be sent; 0 = now
+    int64_t waitMs(int64_t now_ms) const {
+        if (!limited() || sent_ms_.size() < max_requests_) {
+            return 0;
+        }
+        return std::max<int64_t>(0, sent_ms_.front() + window_ms_ - now_ms);
+    }
+
+    void record(int64_t now_ms) {
+        if (!limited()) {
+            return;
+        }
+        sent_ms_.push_back(now_ms);
+        while (sent_ms_.size() > max_requests_) {
+            sent_ms_.pop_front();
+        }
+    }
+
+private:
+    size_t max_requests_ = 0;        // 0 = unlimited
+    int64_t window_ms_ = 0;
+    std::deque<int64_t> sent_ms_;
+};
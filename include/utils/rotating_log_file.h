@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+
+// Segmented log file writer.
+// Each segment is preallocated to `segment_bytes` and (on POSIX) mapped into
+// memory, so appending a line is a memcpy into the page cache with no syscall
+// and no per-line flush. A segment is closed and truncated to its used length
+// when it fills up or when it is older than `rotate_interval_seconds`; closed
+// segments are gzip-compressed on a background thread when zlib is available.
+// Not thread-safe: the owner (Logger) serializes calls.
+class RotatingLogFile {
+public:
+    struct Options {
+        std::string dir = "logs/";
+        std::string base_name = "trading_system";
+        size_t segment_bytes = 64 * 1024 * 1024;
+        int64_t rotate_interval_seconds = 24 * 3600;   // <= 0 disables time-based rotation
+        bool compress_rotated = true;
+    };
+
+    RotatingLogFile() = default;
+    ~RotatingLogFile();
+
+    RotatingLogFile(const RotatingLogFile&) = delete;
+    RotatingLogFile& operator=(const RotatingLogFile&) = delete;
+
+    bool open(const Options& options);
+    void close();
+    bool isOpen() const { return segment_open_; }
+
+    // Appends raw bytes (caller supplies the trailing newline)
+    void write(const char* data, size_t len);
+
+private:
+    bool openSegment(size_t min_bytes);
+    void closeSegment();
+    std::string nextSegmentPath();
+
+    void enqueueCompression(const std::string& path);
+    void compressionLoop();
+    static bool compressFile(const std::string& path);
+
+    Options options_;
+    std::string run_timestamp_;
+    uint32_t segment_seq_ = 0;
+
+    bool segment_open_ = false;
+    std::string segment_path_;
+    int64_t segment_opened_at_ = 0;   // steady clock, seconds
+    size_t segment_capacity_ = 0;
+    size_t segment_used_ = 0;
+
+#ifdef _WIN32
+    std::ofstream stream_;
+    std::string stream_buffer_;
+#else
+    int fd_ = -1;
+    char* mapped_ = nullptr;          // nullptr => fall back to write(2)
+#endif
+
+    // Background compression of rotated segments
+    std::thread compress_thread_;
+    std::mutex compress_mutex_;
+    std::condition_variable compress_cv_;
+    std::deque<std::string> compress_queue_;
+    bool compress_stop_ = false;
+};
@@ -40,6 +40,26 @@ bool ConfigManager::loadFromJson(const std::string& json_file) {
     }
 }
 
+bool ConfigManager::readScanExpressions(const std::string& json_file, std::string& filter, std::string& score) const {
+    try {
+        std::ifstream file(json_file);
+        if (!file.is_open()) {
+            return false;
+        }
+        
+        json j;
+        file >> j;
+        const json scanner = j.value("scanner", json::object());
+        filter = scanner.value("filter_expression", std::string());
+        score = scanner.value("score_expression", std::string());
+        return true;
+    } catch (const std::exception& e) {
+        // A save still in progress or a syntax error; the next save is read again
+        std::cerr << "Failed to read scanner expressions: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 bool ConfigManager::loadFromText(const std::string& text_file) {
     std::ifstream file(text_file);
     if (!file.is_open()) {
@@ -94,6 +114,17 @@ void ConfigManager::parseJsonConfig(const json& j) {
         config_.scanner.min_volume = scanner.value("min_volume", 1000000.0);
         config_.scanner.min_turnover_rate = scanner.value("min_turnover_rate", 0.01);
         config_.scanner.top_n = scanner.value("top_n", 10);
+        config_.scanner.snapshot_requests_in_flight = scanner.value("snapshot_requests_in_flight", 4);
+        config_.scanner.push_enabled = scanner.value("push_enabled", false);
+        config_.scanner.push_symbols = scanner.value("push_symbols", 100);
+        config_.scanner.volume_preload = scanner.value("volume_preload", true);
+        config_.scanner.volume_preload_parallelism = scanner.value("volume_preload_parallelism", 4);
+        config_.scanner.volume_cache_dir = scanner.value("volume_cache_dir", std::string("data/scanner"));
+        config_.scanner.filter_expression = scanner.value("filter_expression", std::string());
+        config_.scanner.score_expression = scanner.value("score_expression", std::string());
+        config_.scanner.tiered_scan = scanner.value("tiered_scan", true);
+        config_.scanner.tier_hot_speedup = scanner.value("tier_hot_speedup", 4);
+        config_.scanner.tier_cold_slowdown = scanner.value("tier_cold_slowdown", 4);
     }
     
     // Parse risk management parameters
@@ -127,6 +158,25 @@ void ConfigManager::parseJsonConfig(const json& j) {
         config_.logging.console = logging.value("console", true);
         config_.logging.file = logging.value("file", true);
         config_.logging.file_dir = logging.value("file_dir", "logs");
+        config_.logging.segment_size_mb = logging.value("segment_size_mb", 64);
+        config_.logging.rotate_interval_hours = logging.value("rotate_interval_hours", 24);
+        config_.logging.compress_rotated = logging.value("compress_rotated", true);
+    }
+    
+    // Parse market data configuration
+    if (j.contains("market_data")) {
+        const auto& market_data = j["market_data"];
+        config_.market_data.subscription_flush_ms = market_data.value("subscription_flush_ms", 200);
+        config_.market_data.subscription_timeout_ms = market_data.value("subscription_timeout_ms", 10000);
+        config_.market_data.subscription_quota = market_data.value("subscription_quota", 0);
+        config_.market_data.subscription_linger_seconds = market_data.value("subscription_linger_seconds", 300);
+        config_.market_data.kline_cache_bars = market_data.value("kline_cache_bars", 1000);
+        config_.market_data.bar_store_dir = market_data.value("bar_store_dir", "data/bars");
+        config_.market_data.calendar_dir = market_data.value("calendar_dir", "data/calendar");
+        config_.market_data.aggregate_bars = market_data.value("aggregate_bars", true);
+        config_.market_data.bar_update_ms = market_data.value("bar_update_ms", 250);
+        config_.market_data.feed_stale_seconds = market_data.value("feed_stale_seconds", 60);
+        config_.market_data.feed_backfill_parallelism = market_data.value("feed_backfill_parallelism", 4);
     }
     
     // Parse notification configuration
@@ -0,0 +1,316 @@
+#include "data/bar_aggregator.h"
+#include "data/data_subscriber.h"
+#include "exchange/exchange_manager.h"
+#include "event/event.h"
+#include "utils/exchange_time.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+namespace {
+
+constexpr int64_t kNsPerSec = 1000000000LL;
+
+// Bars close this long after their end time, leaving room for trades in flight
+constexpr int64_t kCloseGraceNs = 2 * kNsPerSec;
+
+// Closing prints stamped just after the bell (the US closing cross) still
+// belong to the session's last bar
+constexpr int64_t kLateCloseSec = 5;
+
+struct IntervalSpec {
+    const char* name;
+    int64_t seconds;
+};
+
+constexpr IntervalSpec kIntervals[] = {
+    {"1m", 60}, {"3m", 180}, {"5m", 300}, {"15m", 900}, {"30m", 1800}, {"1h", 3600},
+};
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+} // namespace
+
+BarAggregator& BarAggregator::getInstance() {
+    static BarAggregator instance;
+    return instance;
+}
+
+BarAggregator::~BarAggregator() {
+    stop();
+}
+
+void BarAggregator::initializeEventHandlers(IEventEngine* event_engine) {
+    if (event_engine == nullptr) {
+        LOG_ERROR("Event engine is null");
+        return;
+    }
+
+    event_engine_ = event_engine;
+    trade_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_TRADE,
+        [this](const EventPtr& event) { this->onTradeEvent(event); }
+    );
+
+    LOG_INFO("BarAggregator event handlers registered");
+}
+
+void BarAggregator::start(const MarketDataConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        enabled_ = config.aggregate_bars;
+        update_interval_ns_ = config.bar_update_ms < 0 ? -1 : int64_t(config.bar_update_ms) * 1000000;
+    }
+    if (!config.aggregate_bars || running_) return;
+
+    running_ = true;
+    sweep_thread_ = std::thread(&BarAggregator::sweepLoop, this);
+    LOG_INFO("Bar aggregation started, in-progress updates every " + std::to_string(config.bar_update_ms) + "ms");
+}
+
+void BarAggregator::stop() {
+    if (!running_) return;
+
+    {
+        std::lock_guard<std::mutex> lock(sweep_mutex_);
+        running_ = false;
+    }
+    sweep_cv_.notify_all();
+    if (sweep_thread_.joinable()) {
+        sweep_thread_.join();
+    }
+}
+
+int BarAggregator::intervalIndex(const std::string& interval) {
+    for (size_t i = 0; i < kIntervalCount; ++i) {
+        if (interval == kIntervals[i].name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool BarAggregator::builds(const std::string& interval) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_ && intervalIndex(interval) >= 0;
+}
+
+void BarAggregator::addInterval(const std::string& exchange_name, const std::string& symbol,
+                                const std::string& interval) {
+    int index = intervalIndex(interval);
+    if (index < 0) return;
+
+    // Resolve the market outside the lock; sessions are static tables
+    std::string market;
+    if (auto exchange = ExchangeManager::getInstance().getExchange(exchange_name)) {
+        market = exchange->getMarket();
+    }
+    SymbolId symbol_id = SymbolRegistry::getInstance().intern(exchange_name, symbol);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SymbolBars& state = symbols_[symbol_id];
+    if (state.sessions == nullptr) {
+        state.symbol_id = symbol_id;
+        state.exchange = exchange_name;
+        state.symbol = symbol;
+        state.sessions = &tradingSessions(market);
+        state.auctions = &auctionWindows(market);
+    }
+    if (state.refs[index]++ == 0) {
+        state.bars[index] = Bar();
+        state.since_ns[index] = exchange_time::nowNs();
+    }
+}
+
+void BarAggregator::removeInterval(const std::string& exchange_name, const std::string& symbol,
+                                   const std::string& interval) {
+    int index = intervalIndex(interval);
+    if (index < 0) return;
+    SymbolId symbol_id = SymbolRegistry::getInstance().find(exchange_name, symbol);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SymbolBars* state = symbols_.find(symbol_id);
+    if (state == nullptr || state->refs[index] == 0) return;
+
+    if (--state->refs[index] == 0) {
+        state->bars[index] = Bar();
+        bool unused = std::all_of(state->refs.begin(), state->refs.end(), [](int refs) { return refs == 0; });
+        if (unused) {
+            symbols_.erase(symbol_id);
+        }
+    }
+}
+
+void BarAggregator::onTradeEvent(const EventPtr& event) {
+    if (!event) {
+        return;
+    }
+
+    const TradePrint* trade = event->getData<TradePrint>();
+    if (trade != nullptr) {
+        onTrade(*trade);
+    }
+}
+
+void BarAggregator::onTrade(const TradePrint& trade) {
+    if (trade.exchange_ts_ns == 0 || trade.price <= 0.0) {
+        return;
+    }
+
+    SymbolId symbol_id = SymbolRegistry::getInstance().resolve(trade.symbol_id, trade.exchange, trade.symbol);
+    if (symbol_id == kInvalidSymbolId) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SymbolBars* state = symbols_.find(symbol_id);
+    if (state == nullptr) return;
+
+    state->utc_offset_sec = trade.utc_offset_sec;
+    int64_t now_ns = trade.local_ts_ns != 0 ? trade.local_ts_ns : exchange_time::nowNs();
+    for (size_t i = 0; i < kIntervalCount; ++i) {
+        if (state->refs[i] > 0) {
+            fold(*state, i, trade, now_ns);
+        }
+    }
+}
+
+void BarAggregator::fold(SymbolBars& state, size_t index, const TradePrint& trade, int64_t now_ns) {
+    Bar& bar = state.bars[index];
+    const int64_t ts = trade.exchange_ts_ns;
+
+    // Fast path: inside the open bar. Otherwise locate the bar; auction and
+    // break trades may still map onto the current one.
+    if (!(bar.active && ts >= bar.start_ns && ts < bar.end_ns)) {
+        int64_t start_ns = 0;
+        int64_t end_ns = 0;
+        if (!bucketFor(ts, trade.utc_offset_sec, kIntervals[index].seconds, *state.sessions, *state.auctions,
+                       start_ns, end_ns)) {
+            return;
+        }
+
+        if (end_ns < bar.end_ns) {
+            return;   // late trade for a bar already superseded
+        }
+        if (end_ns > bar.end_ns) {
+            if (bar.active) {
+                publish(state, index, now_ns);
+            }
+            bar = Bar();
+            bar.start_ns = start_ns;
+            bar.end_ns = end_ns;
+            bar.open = bar.high = bar.low = trade.price;
+            bar.partial = start_ns < state.since_ns[index];
+        }
+        bar.active = true;   // also reopens a closed bar for late trades
+    }
+
+    bar.high = std::max(bar.high, trade.price);
+    bar.low = std::min(bar.low, trade.price);
+    bar.close = trade.price;
+    bar.volume += trade.volume;
+    bar.turnover += trade.turnover;
+
+    if (update_interval_ns_ >= 0 && now_ns - bar.published_ns >= update_interval_ns_) {
+        bar.published_ns = now_ns;
+        publish(state, index, now_ns);
+    }
+}
+
+void BarAggregator::publish(const SymbolBars& state, size_t index, int64_t now_ns) {
+    const Bar& bar = state.bars[index];
+    if (bar.partial || event_engine_ == nullptr) return;
+
+    KlineData kline;
+    kline.symbol_id = state.symbol_id;
+    kline.symbol = state.symbol;
+    kline.exchange = state.exchange;
+    kline.exchange_ts_ns = bar.end_ns;
+    kline.local_ts_ns = now_ns;
+    kline.utc_offset_sec = state.utc_offset_sec;
+    kline.interval = kIntervals[index].name;
+    kline.interval_enum = DataSubscriber::klineIntervalEnum(kline.interval);
+    kline.open_price = bar.open;
+    kline.high_price = bar.high;
+    kline.low_price = bar.low;
+    kline.close_price = bar.close;
+    kline.volume = bar.volume;
+    kline.turnover = bar.turnover;
+
+    auto event = std::make_shared<Event>(EventType::EVENT_KLINE);
+    event->setData(kline);
+    event_engine_->putEvent(event);
+}
+
+bool BarAggregator::bucketFor(int64_t ts_ns, int32_t utc_offset_sec, int64_t interval_sec,
+                              const std::vector<SessionWindow>& sessions, const std::vector<PhaseWindow>& auctions,
+                              int64_t& start_ns, int64_t& end_ns) {
+    int64_t local_sec = floorDiv(ts_ns, kNsPerSec) + utc_offset_sec;
+    int64_t midnight = floorDiv(local_sec, 86400) * 86400;
+    int64_t sec_of_day = local_sec - midnight;
+
+    int64_t open = 0;
+    int64_t close = 86400;
+    if (!sessions.empty()) {
+        size_t s = 0;
+        while (s < sessions.size() && sec_of_day >= int64_t(sessions[s].close_min) * 60) {
+            ++s;
+        }
+        if (s == sessions.size() || sec_of_day < int64_t(sessions[s].open_min) * 60) {
+            // Outside continuous trading. The pre-open auction folds into the
+            // first bar; the closing auction, break trades and late closing
+            // prints into the preceding session's last bar.
+            const PhaseWindow* auction = nullptr;
+            for (const auto& window : auctions) {
+                if (sec_of_day >= int64_t(window.open_min) * 60 && sec_of_day < int64_t(window.close_min) * 60) {
+                    auction = &window;
+                    break;
+                }
+            }
+            bool late_close = s > 0 && sec_of_day < int64_t(sessions[s - 1].close_min) * 60 + kLateCloseSec;
+            bool in_break = s > 0 && s < sessions.size();
+            bool in_auction = auction != nullptr && !auction->extended_hours;
+
+            if (in_auction && auction->phase == MarketPhase::kPreOpen && s < sessions.size()) {
+                sec_of_day = int64_t(sessions[s].open_min) * 60;
+            } else if (s > 0 && (late_close || in_break || in_auction)) {
+                --s;
+                sec_of_day = int64_t(sessions[s].close_min) * 60 - 1;
+            } else {
+                return false;   // extended hours or no trading
+            }
+        }
+        open = int64_t(sessions[s].open_min) * 60;
+        close = int64_t(sessions[s].close_min) * 60;
+    }
+
+    int64_t start = open + (sec_of_day - open) / interval_sec * interval_sec;
+    int64_t end = std::min(start + interval_sec, close);
+    start_ns = (midnight + start - utc_offset_sec) * kNsPerSec;
+    end_ns = (midnight + end - utc_offset_sec) * kNsPerSec;
+    return true;
+}
+
+void BarAggregator::sweep(int64_t now_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    symbols_.forEach([&](SymbolId, SymbolBars& state) {
+        for (size_t i = 0; i < kIntervalCount; ++i) {
+            Bar& bar = state.bars[i];
+            if (bar.active && bar.end_ns + kCloseGraceNs <= now_ns) {
+                bar.active = false;
+                publish(state, i, now_ns);
+            }
+        }
+    });
+}
+
+void BarAggregator::sweepLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(sweep_mutex_);
+            sweep_cv_.wait_for(lock, std::chrono::milliseconds(500), [this] { return !running_; });
+        }
+        if (!running_) break;
+
+        sweep(exchange_time::nowNs());
+    }
+}
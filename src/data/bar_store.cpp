@@ -0,0 +1,407 @@
+#include "data/bar_store.h"
+#include "data/data_subscriber.h"
+#include "data/kline_cache.h"
+#include "exchange/exchange_interface.h"
+#include "utils/exchange_time.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'Q', 'T', 'S', 'B', 'A', 'R', 'S', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kColumns = 7;          // timestamp, open, high, low, close, volume, turnover
+constexpr uint64_t kMinCapacity = 256;
+constexpr uint32_t kFlagComplete = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columns;
+    uint64_t capacity;                    // rows allocated per column
+    uint64_t count;                       // rows written; updated last, so a torn append is ignored
+    int64_t synced_at_ns;
+    int32_t utc_offset_sec;
+    uint32_t flags;
+    uint8_t reserved[16];
+};
+static_assert(sizeof(FileHeader) == 64, "bar file header must stay 64 bytes");
+
+size_t columnOffset(uint64_t capacity, uint32_t column, uint64_t row) {
+    return sizeof(FileHeader) + (static_cast<size_t>(column) * capacity + row) * 8;
+}
+
+bool validHeader(const FileHeader& header, size_t file_size) {
+    return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+           header.version == kVersion &&
+           header.columns == kColumns &&
+           header.count <= header.capacity &&
+           columnOffset(header.capacity, kColumns, 0) <= file_size;
+}
+
+std::string safeFileName(const std::string& name) {
+    std::string out = name;
+    for (char& c : out) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-' && c != '_') {
+            c = '_';
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+BarStore& BarStore::getInstance() {
+    static BarStore instance;
+    return instance;
+}
+
+bool BarStore::open(const std::string& dir) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        LOG_ERROR("Failed to create bar store directory " + dir + ": " + ec.message());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    dir_ = dir;
+    open_ = true;
+    LOG_INFO("Bar store opened at " + dir);
+    return true;
+}
+
+void BarStore::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = false;
+}
+
+bool BarStore::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open_;
+}
+
+std::string BarStore::pathFor(const std::string& exchange_name, const std::string& symbol,
+                              const std::string& interval) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::filesystem::path path(dir_);
+    path /= safeFileName(exchange_name);
+    path /= safeFileName(interval);
+    path /= safeFileName(symbol) + ".bars";
+    return path.string();
+}
+
+std::mutex& BarStore::lockFor(const std::string& path) {
+    return file_locks_[std::hash<std::string>{}(path) % file_locks_.size()];
+}
+
+std::vector<KlineData> BarStore::getHistoryKLine(
+    const std::shared_ptr<IExchange>& exchange,
+    const std::string& symbol,
+    const std::string& kline_type,
+    int count) {
+
+    if (!exchange || count <= 0) {
+        return {};
+    }
+    if (!isOpen()) {
+        return exchange->getHistoryKLine(symbol, kline_type, count);
+    }
+
+    const std::string interval = DataSubscriber::normalizeKLineType(kline_type);
+    const std::string path = pathFor(exchange->getName(), symbol, interval);
+    const size_t wanted = static_cast<size_t>(count);
+    const int64_t bar_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        KLineCache::barDuration(interval)).count();
+    const int64_t now_ns = exchange_time::nowNs();
+
+    std::lock_guard<std::mutex> file_lock(lockFor(path));
+
+    Series stored;
+    load(path, wanted, stored);
+
+    bool covers = stored.total >= wanted || stored.complete;
+    if (stored.total > 0 && covers &&
+        !KLineCache::syncExpired(interval, exchange->getMarket(), stored.synced_at_ns, now_ns)) {
+        return toKLines(stored, symbol, exchange->getName(), kline_type, wanted);
+    }
+
+    // Fetch only the bars since the last stored one (plus the in-progress
+    // bar, which may have changed), or the whole request if history is short
+    size_t fetch_count = wanted;
+    if (stored.total > 0 && covers) {
+        int64_t elapsed = now_ns - stored.bars.back().ts_ns;
+        size_t missing = elapsed > 0 ? static_cast<size_t>(elapsed / bar_ns) + 2 : 2;
+        fetch_count = std::min(wanted, missing);
+    }
+
+    std::vector<KlineData> fetched = exchange->getHistoryKLine(symbol, kline_type, static_cast<int>(fetch_count));
+    if (fetched.empty()) {
+        // Exchange unavailable: serve whatever is on disk
+        return toKLines(stored, symbol, exchange->getName(), kline_type, wanted);
+    }
+
+    std::vector<Bar> bars;
+    bars.reserve(fetched.size());
+    for (const auto& kline : fetched) {
+        if (kline.exchange_ts_ns == 0 || (!bars.empty() && kline.exchange_ts_ns <= bars.back().ts_ns)) {
+            LOG_WARN("Bar store skipped " + symbol + " " + interval + ": unordered or untimed bars");
+            return fetched;
+        }
+        bars.push_back({kline.exchange_ts_ns, kline.open_price, kline.high_price, kline.low_price,
+                        kline.close_price, kline.volume, kline.turnover});
+    }
+
+    // Fetched bars reaching before the loaded tail need the whole file to merge against
+    if (stored.first > 0 && bars.front().ts_ns < stored.bars.front().ts_ns) {
+        load(path, 0, stored);
+    }
+
+    // Fetched bars are the latest contiguous run, so they replace everything from
+    // their first timestamp on. A run that does not reach the stored bars may
+    // leave a gap when the request was capped, so it then replaces the file.
+    auto pos = std::lower_bound(stored.bars.begin(), stored.bars.end(), bars.front().ts_ns,
+        [](const Bar& bar, int64_t ts) { return bar.ts_ns < ts; });
+    size_t keep = static_cast<size_t>(pos - stored.bars.begin());
+    if (keep == stored.bars.size() && fetch_count == wanted && fetched.size() == fetch_count) {
+        keep = 0;
+        stored.first = 0;
+    }
+    size_t index = stored.first + keep;
+
+    Series merged;
+    merged.synced_at_ns = now_ns;
+    merged.utc_offset_sec = fetched.back().utc_offset_sec;
+    merged.complete = index == 0 ? fetched.size() < fetch_count : stored.complete;
+    merged.bars.assign(stored.bars.begin(), stored.bars.begin() + static_cast<std::ptrdiff_t>(keep));
+    merged.bars.insert(merged.bars.end(), bars.begin(), bars.end());
+    merged.first = stored.first;
+    merged.total = index + bars.size();
+
+    if (!write(path, merged, index, bars)) {
+        LOG_WARN("Failed to write bar store file " + path);
+    }
+
+    return toKLines(merged, symbol, exchange->getName(), kline_type, wanted);
+}
+
+std::vector<KlineData> BarStore::readStored(const std::string& exchange_name,
+                                            const std::string& symbol,
+                                            const std::string& kline_type,
+                                            int count) {
+    if (count <= 0 || !isOpen()) {
+        return {};
+    }
+
+    const std::string interval = DataSubscriber::normalizeKLineType(kline_type);
+    const std::string path = pathFor(exchange_name, symbol, interval);
+
+    std::lock_guard<std::mutex> file_lock(lockFor(path));
+    Series stored;
+    if (!load(path, static_cast<size_t>(count), stored)) {
+        return {};
+    }
+    return toKLines(stored, symbol, exchange_name, kline_type, static_cast<size_t>(count));
+}
+
+std::vector<KlineData> BarStore::toKLines(const Series& series, const std::string& symbol,
+                                          const std::string& exchange_name, const std::string& kline_type,
+                                          size_t count) {
+    const KlineInterval interval_enum = DataSubscriber::klineIntervalEnum(kline_type);
+    SymbolId symbol_id = SymbolRegistry::getInstance().intern(exchange_name, symbol);
+
+    size_t n = std::min(count, series.bars.size());
+    std::vector<KlineData> klines;
+    klines.reserve(n);
+    for (size_t i = series.bars.size() - n; i < series.bars.size(); ++i) {
+        const Bar& bar = series.bars[i];
+        KlineData kline;
+        kline.symbol_id = symbol_id;
+        kline.symbol = symbol;
+        kline.exchange = exchange_name;
+        kline.exchange_ts_ns = bar.ts_ns;
+        kline.utc_offset_sec = series.utc_offset_sec;
+        kline.interval = kline_type;
+        kline.interval_enum = interval_enum;
+        kline.open_price = bar.open;
+        kline.high_price = bar.high;
+        kline.low_price = bar.low;
+        kline.close_price = bar.close;
+        kline.volume = bar.volume;
+        kline.turnover = bar.turnover;
+        klines.push_back(std::move(kline));
+    }
+    return klines;
+}
+
+bool BarStore::load(const std::string& path, size_t count, Series& out) {
+    out = Series();
+
+    const char* base = nullptr;
+    size_t size = 0;
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    base = static_cast<const char*>(addr);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return false;
+    }
+    std::vector<char> buffer(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (buffer.size() < sizeof(FileHeader) || !in.read(buffer.data(), buffer.size())) {
+        return false;
+    }
+    base = buffer.data();
+    size = buffer.size();
+#endif
+
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    bool ok = validHeader(header, size);
+    if (ok) {
+        size_t total = static_cast<size_t>(header.count);
+        size_t n = count == 0 ? total : std::min(count, total);
+        out.total = total;
+        out.first = total - n;
+        out.synced_at_ns = header.synced_at_ns;
+        out.utc_offset_sec = header.utc_offset_sec;
+        out.complete = (header.flags & kFlagComplete) != 0;
+        out.bars.resize(n);
+
+        // Gather each column into the row structs; Bar is seven 8-byte fields in column order
+        static_assert(sizeof(Bar) == kColumns * 8, "Bar must mirror the file columns");
+        for (uint32_t c = 0; c < kColumns; ++c) {
+            const char* column = base + columnOffset(header.capacity, c, out.first);
+            for (size_t i = 0; i < n; ++i) {
+                std::memcpy(reinterpret_cast<char*>(&out.bars[i]) + c * 8, column + i * 8, 8);
+            }
+        }
+    } else {
+        LOG_WARN("Ignoring invalid bar store file " + path);
+    }
+
+#ifndef _WIN32
+    ::munmap(const_cast<char*>(base), size);
+#endif
+    return ok;
+}
+
+bool BarStore::write(const std::string& path, const Series& meta, size_t index, const std::vector<Bar>& bars) {
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    bool exists = false;
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (in) {
+            size_t size = static_cast<size_t>(in.tellg());
+            in.seekg(0);
+            exists = size >= sizeof(header) &&
+                     in.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+                     validHeader(header, size);
+        }
+    }
+    if (!exists) {
+        std::memset(&header, 0, sizeof(header));
+        index = 0;
+    }
+    index = std::min<size_t>(index, static_cast<size_t>(header.count));
+
+    uint64_t total = index + bars.size();
+    std::vector<Bar> rows;
+    bool rewrite = !exists || total > header.capacity;
+    if (rewrite) {
+        // Columns are laid out back to back, so growing moves every column:
+        // write a file with doubled capacity and swap it in
+        Series existing;
+        if (index > 0) {
+            load(path, 0, existing);
+            index = std::min(index, existing.bars.size());
+        }
+        rows.assign(existing.bars.begin(), existing.bars.begin() + static_cast<std::ptrdiff_t>(index));
+        rows.insert(rows.end(), bars.begin(), bars.end());
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.columns = kColumns;
+        header.capacity = std::max<uint64_t>({kMinCapacity, total, header.capacity * 2});
+    }
+    header.count = total;
+    header.synced_at_ns = meta.synced_at_ns;
+    header.utc_offset_sec = meta.utc_offset_sec;
+    header.flags = meta.complete ? kFlagComplete : 0;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    const std::string target = rewrite ? path + ".tmp" : path;
+    std::fstream out;
+    if (rewrite) {
+        out.open(target, std::ios::binary | std::ios::out | std::ios::trunc);
+    } else {
+        out.open(target, std::ios::binary | std::ios::in | std::ios::out);
+    }
+    if (!out) {
+        return false;
+    }
+
+    const std::vector<Bar>& source = rewrite ? rows : bars;
+    uint64_t first_row = rewrite ? 0 : index;
+    std::vector<char> column(source.size() * 8);
+    for (uint32_t c = 0; c < kColumns; ++c) {
+        for (size_t i = 0; i < source.size(); ++i) {
+            std::memcpy(column.data() + i * 8, reinterpret_cast<const char*>(&source[i]) + c * 8, 8);
+        }
+        out.seekp(static_cast<std::streamoff>(columnOffset(header.capacity, c, first_row)));
+        out.write(column.data(), static_cast<std::streamsize>(column.size()));
+    }
+    if (rewrite) {
+        // Size the file to the full capacity so every column is addressable
+        out.seekp(static_cast<std::streamoff>(columnOffset(header.capacity, kColumns, 0) - 1));
+        out.put('\0');
+    }
+
+    // Header last: the row count commits the append
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        return false;
+    }
+
+    if (rewrite) {
+        std::filesystem::rename(target, path, ec);
+        if (ec) {
+            LOG_ERROR("Failed to replace bar store file " + path + ": " + ec.message());
+            return false;
+        }
+    }
+    return true;
+}
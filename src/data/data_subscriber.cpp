@@ -1,4 +1,10 @@
 #include "data/data_subscriber.h"
+#include "data/kline_cache.h"
+#include "data/bar_aggregator.h"
+#include "data/order_book_engine.h"
+#include "data/trade_flow_engine.h"
+#include "exchange/exchange_manager.h"
+#include "managers/position_manager.h"
 #include "utils/logger.h"
 #include <sstream>
 #include <algorithm>
@@ -11,80 +17,628 @@ DataSubscriber& DataSubscriber::getInstance() {
     return instance;
 }
 
-bool DataSubscriber::subscribeKLine(const std::string& symbol, const std::string& kline_type) {
-    std::lock_guard<std::mutex> lock(mutex_);
+namespace {
+
+// How often the exchange-reported quota is re-read
+constexpr auto kQuotaRefreshInterval = std::chrono::seconds(60);
+
+} // namespace
+
+DataSubscriber::~DataSubscriber() {
+    stop();
+}
+
+void DataSubscriber::start(const MarketDataConfig& config) {
+    if (running_) return;
     
-    // TODO: Call Futu API to subscribe to KLine
-    /*
-    FTDC_Quote_API* api = FTDC_Quote_API::getInstance();
-    bool success = api->subscribeKLine(symbol, kline_type);
-    if (!success) {
-        LOG_ERROR("Failed to subscribe KLine for " + symbol);
-        return false;
+    flush_interval_ = std::chrono::milliseconds(std::max(10, config.subscription_flush_ms));
+    confirm_timeout_ = std::chrono::milliseconds(std::max(1000, config.subscription_timeout_ms));
+    linger_ = std::chrono::seconds(std::max(0, config.subscription_linger_seconds));
+    quota_cap_ = std::max(0, config.subscription_quota);
+    running_ = true;
+    flush_thread_ = std::thread(&DataSubscriber::flushLoop, this);
+    
+    LOG_INFO("Subscription flush started, interval=" + std::to_string(flush_interval_.count()) + "ms");
+}
+
+void DataSubscriber::stop() {
+    if (!running_) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        running_ = false;
+    }
+    flush_cv_.notify_all();
+    if (flush_thread_.joinable()) {
+        flush_thread_.join();
     }
-    */
     
-    kline_subscriptions_[symbol] = kline_type;
+    // Release whatever consumers dropped during shutdown
+    linger_ = std::chrono::seconds(0);
+    flush();
+    LOG_INFO("Subscription flush stopped");
+}
+
+void DataSubscriber::flushLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(flush_mutex_);
+            flush_cv_.wait_for(lock, flush_interval_, [this] { return !running_; });
+        }
+        if (!running_) break;
+        refreshQuotas();
+        flush();
+    }
+}
+
+std::string DataSubscriber::normalizeKLineType(const std::string& kline_type) {
+    static const std::map<std::string, std::string> aliases = {
+        {"1m", "1m"}, {"1min", "1m"}, {"K_1M", "1m"},
+        {"3m", "3m"}, {"3min", "3m"}, {"K_3M", "3m"},
+        {"5m", "5m"}, {"5min", "5m"}, {"K_5M", "5m"},
+        {"15m", "15m"}, {"15min", "15m"}, {"K_15M", "15m"},
+        {"30m", "30m"}, {"30min", "30m"}, {"K_30M", "30m"},
+        {"60m", "1h"}, {"60min", "1h"}, {"1h", "1h"}, {"K_60M", "1h"},
+        {"1d", "1d"}, {"day", "1d"}, {"K_DAY", "1d"},
+        {"1w", "1w"}, {"week", "1w"}, {"K_WEEK", "1w"},
+        {"1mon", "1mon"}, {"month", "1mon"}, {"K_MON", "1mon"},
+    };
+    auto it = aliases.find(kline_type);
+    return it != aliases.end() ? it->second : kline_type;
+}
+
+KlineInterval DataSubscriber::klineIntervalEnum(const std::string& kline_type) {
+    static const std::map<std::string, KlineInterval> intervals = {
+        {"1m", KlineInterval::K_1M}, {"3m", KlineInterval::K_3M}, {"5m", KlineInterval::K_5M},
+        {"15m", KlineInterval::K_15M}, {"30m", KlineInterval::K_30M}, {"1h", KlineInterval::K_1H},
+        {"1d", KlineInterval::K_1D}, {"1w", KlineInterval::K_1W}, {"1mon", KlineInterval::K_1MO},
+    };
+    auto it = intervals.find(normalizeKLineType(kline_type));
+    return it != intervals.end() ? it->second : KlineInterval::K_1M;
+}
+
+std::string DataSubscriber::resolveExchange(const std::string& symbol) const {
+    auto& registry = SymbolRegistry::getInstance();
+    SymbolId id = registry.findByCode(symbol);
+    if (id != kInvalidSymbolId && !registry.exchange(id).empty()) {
+        return registry.exchange(id);
+    }
     
-    std::stringstream ss;
-    ss << "Subscribed KLine: " << symbol << " type=" << kline_type;
-    LOG_INFO(ss.str());
+    // Unambiguous with a single exchange
+    auto exchanges = ExchangeManager::getInstance().getAllExchanges();
+    if (exchanges.size() == 1) {
+        return exchanges.front()->getName();
+    }
+    return std::string();
+}
+
+bool DataSubscriber::addReference(const std::string& exchange_name, const std::string& symbol,
+                                  const std::string& data_type) {
+    if (exchange_name.empty()) {
+        LOG_ERROR("Cannot subscribe " + data_type + " for " + symbol + ": unknown exchange");
+        return false;
+    }
     
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    SubscriptionKey key(exchange_name, symbol, data_type);
+    auto& state = subscriptions_[key];
+    state.last_used = std::chrono::steady_clock::now();
+    if (++state.ref_count == 1) {
+        dirty_.insert(key);
+    }
     return true;
 }
 
-void DataSubscriber::unsubscribeKLine(const std::string& symbol) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void DataSubscriber::releaseReference(const std::string& exchange_name, const std::string& symbol,
+                                      const std::string& data_type) {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    SubscriptionKey key(exchange_name, symbol, data_type);
+    auto it = subscriptions_.find(key);
+    if (it == subscriptions_.end() || it->second.ref_count == 0) {
+        LOG_WARN("Unbalanced unsubscribe " + data_type + " for " + symbol);
+        return;
+    }
+    it->second.last_used = std::chrono::steady_clock::now();
+    if (--it->second.ref_count == 0) {
+        dirty_.insert(key);
+    }
+}
+
+bool DataSubscriber::subscribeKLine(const std::string& exchange_name, const std::string& symbol,
+                                    const std::string& kline_type) {
+    const std::string interval = normalizeKLineType(kline_type);
+    auto& aggregator = BarAggregator::getInstance();
+    if (aggregator.builds(interval)) {
+        // Built locally from trades: the tick feed serves every such interval
+        if (!addReference(exchange_name, symbol, kTickDataType)) {
+            return false;
+        }
+        aggregator.addInterval(exchange_name, symbol, interval);
+        return true;
+    }
+    return addReference(exchange_name, symbol, interval);
+}
+
+void DataSubscriber::unsubscribeKLine(const std::string& exchange_name, const std::string& symbol,
+                                      const std::string& kline_type) {
+    const std::string interval = normalizeKLineType(kline_type);
+    auto& aggregator = BarAggregator::getInstance();
+    if (aggregator.builds(interval)) {
+        aggregator.removeInterval(exchange_name, symbol, interval);
+        releaseReference(exchange_name, symbol, kTickDataType);
+        return;
+    }
+    releaseReference(exchange_name, symbol, interval);
+}
+
+bool DataSubscriber::subscribeTick(const std::string& exchange_name, const std::string& symbol) {
+    return addReference(exchange_name, symbol, kTickDataType);
+}
+
+void DataSubscriber::unsubscribeTick(const std::string& exchange_name, const std::string& symbol) {
+    releaseReference(exchange_name, symbol, kTickDataType);
+}
+
+bool DataSubscriber::subscribeDepth(const std::string& exchange_name, const std::string& symbol) {
+    return addReference(exchange_name, symbol, kDepthDataType);
+}
+
+void DataSubscriber::unsubscribeDepth(const std::string& exchange_name, const std::string& symbol) {
+    releaseReference(exchange_name, symbol, kDepthDataType);
+}
+
+bool DataSubscriber::subscribeKLine(const std::string& symbol, const std::string& kline_type) {
+    return subscribeKLine(resolveExchange(symbol), symbol, kline_type);
+}
+
+void DataSubscriber::unsubscribeKLine(const std::string& symbol, const std::string& kline_type) {
+    unsubscribeKLine(resolveExchange(symbol), symbol, kline_type);
+}
+
+bool DataSubscriber::subscribeTick(const std::string& symbol) {
+    return subscribeTick(resolveExchange(symbol), symbol);
+}
+
+void DataSubscriber::unsubscribeTick(const std::string& symbol) {
+    unsubscribeTick(resolveExchange(symbol), symbol);
+}
+
+bool DataSubscriber::subscribeDepth(const std::string& symbol) {
+    return subscribeDepth(resolveExchange(symbol), symbol);
+}
+
+void DataSubscriber::unsubscribeDepth(const std::string& symbol) {
+    unsubscribeDepth(resolveExchange(symbol), symbol);
+}
+
+DataSubscriber::Priority DataSubscriber::priorityOf(const SubscriptionKey& key, const SubscriptionState& state) const {
+    if (PositionManager::getInstance().hasPosition(std::get<1>(key))) {
+        return kPosition;
+    }
+    return state.ref_count > 0 ? kReferenced : kLingering;
+}
+
+int DataSubscriber::unitsInUse(const std::string& exchange_name) const {
+    int units = 0;
+    for (const auto& pair : subscriptions_) {
+        if (std::get<0>(pair.first) != exchange_name) continue;
+        const SubscriptionState& state = pair.second;
+        // A release already sent counts as free: unsubscribes go out first
+        bool held = state.in_flight ? state.in_flight_subscribe : state.active;
+        if (held) units += state.cost;
+    }
+    return units;
+}
+
+void DataSubscriber::refreshQuotas() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& exchange : ExchangeManager::getInstance().getAllExchanges()) {
+        if (!exchange->isConnected()) continue;
+        const std::string name = exchange->getName();
+        {
+            std::lock_guard<std::mutex> lock(subscription_mutex_);
+            ExchangeQuota& quota = quotas_[name];
+            if (quota.refreshed && now - quota.last_refresh < kQuotaRefreshInterval) continue;
+            quota.last_refresh = now;
+        }
+        
+        // Blocking exchange query, made without holding the lock
+        int used = 0;
+        int remaining = 0;
+        bool limited = exchange->getSubscriptionQuota(used, remaining);
+        
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        ExchangeQuota& quota = quotas_[name];
+        int previous = quota.quota;
+        quota.refreshed = true;
+        if (limited) {
+            // Our confirmed feeds are part of `used`; the rest belongs to other clients
+            int own = 0;
+            for (const auto& pair : subscriptions_) {
+                if (std::get<0>(pair.first) == name && pair.second.active) own += pair.second.cost;
+            }
+            quota.quota = remaining + own;
+        } else {
+            quota.quota = -1;
+        }
+        if (quota_cap_ > 0) {
+            quota.quota = quota.quota < 0 ? quota_cap_ : std::min(quota.quota, quota_cap_);
+        }
+        if (quota.quota != previous) {
+            LOG_INFO("Subscription quota for " + name + ": " +
+                     (quota.quota < 0 ? std::string("unlimited") : std::to_string(quota.quota)));
+        }
+    }
+}
+
+void DataSubscriber::flush() {
+    struct Request {
+        uint64_t batch_id;
+        std::vector<std::string> symbols;
+    };
+    // (subscribe, exchange, data type) -> one request; releases sort first so
+    // the exchange frees quota before the subscribes that need it
+    std::map<std::tuple<bool, std::string, std::string>, Request> requests;
     
-    // TODO: Call Futu API to unsubscribe
-    /*
-    FTDC_Quote_API* api = FTDC_Quote_API::getInstance();
-    api->unsubscribeKLine(symbol);
-    */
+    std::map<std::string, std::shared_ptr<IExchange>> exchanges;
+    for (auto& exchange : ExchangeManager::getInstance().getAllExchanges()) {
+        exchanges[exchange->getName()] = exchange;
+    }
     
-    kline_subscriptions_.erase(symbol);
+    {
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        
+        auto queueRequest = [&](const SubscriptionKey& key, SubscriptionState& state, bool subscribe) {
+            auto request_key = std::make_tuple(subscribe, std::get<0>(key), std::get<2>(key));
+            auto request_it = requests.find(request_key);
+            if (request_it == requests.end()) {
+                uint64_t batch_id = next_batch_id_++;
+                PendingBatch& batch = pending_batches_[batch_id];
+                batch.subscribe = subscribe;
+                batch.sent_at = now;
+                request_it = requests.emplace(request_key, Request{batch_id, {}}).first;
+            }
+            request_it->second.symbols.push_back(std::get<1>(key));
+            pending_batches_[request_it->second.batch_id].keys.push_back(key);
+            state.in_flight = true;
+            state.in_flight_subscribe = subscribe;
+        };
+        
+        auto holdFor = [&](const std::string& exchange_name) {
+            auto it = exchanges.find(exchange_name);
+            int seconds = it != exchanges.end() ? it->second->getMinSubscriptionHoldSeconds() : 0;
+            return std::chrono::seconds(seconds);
+        };
+        
+        // Requests the exchange never answered are retried
+        for (auto it = pending_batches_.begin(); it != pending_batches_.end();) {
+            if (now - it->second.sent_at < confirm_timeout_) {
+                ++it;
+                continue;
+            }
+            LOG_WARN("Subscription request timed out, " + std::to_string(it->second.keys.size()) +
+                     " symbols will be retried");
+            for (const auto& key : it->second.keys) {
+                auto state_it = subscriptions_.find(key);
+                if (state_it == subscriptions_.end()) continue;
+                state_it->second.in_flight = false;
+                dirty_.insert(key);
+            }
+            it = pending_batches_.erase(it);
+        }
+        
+        std::vector<std::pair<Priority, SubscriptionKey>> candidates;
+        for (auto it = dirty_.begin(); it != dirty_.end();) {
+            auto state_it = subscriptions_.find(*it);
+            if (state_it == subscriptions_.end()) {
+                it = dirty_.erase(it);
+                continue;
+            }
+            SubscriptionState& state = state_it->second;
+            // Re-examined when the outstanding request completes
+            if (state.in_flight) {
+                it = dirty_.erase(it);
+                continue;
+            }
+            if (now < state.retry_after) {
+                ++it;
+                continue;
+            }
+            
+            bool wanted = state.ref_count > 0;
+            if (wanted == state.active) {
+                state.deferred = false;
+                if (!wanted) subscriptions_.erase(state_it);
+                it = dirty_.erase(it);
+                continue;
+            }
+            
+            if (!wanted) {
+                // Released feeds stay warm for the linger period, and the
+                // exchange may refuse releases inside its minimum hold
+                auto release_at = std::max(state.subscribed_at + holdFor(std::get<0>(*it)),
+                                           state.last_used + linger_);
+                if (now < release_at) {
+                    state.retry_after = release_at;
+                    ++it;
+                    continue;
+                }
+                queueRequest(*it, state, false);
+                it = dirty_.erase(it);
+                continue;
+            }
+            
+            candidates.emplace_back(priorityOf(*it, state), *it);
+            ++it;
+        }
+        
+        // Highest priority first, most recently requested first within a priority
+        std::sort(candidates.begin(), candidates.end(), [this](const auto& a, const auto& b) {
+            if (a.first != b.first) return a.first > b.first;
+            return subscriptions_[a.second].last_used > subscriptions_[b.second].last_used;
+        });
+        
+        std::map<std::string, int> used;
+        std::map<std::string, int> no_victim_at;   // exchange -> lowest priority that found nothing to evict
+        for (const auto& candidate : candidates) {
+            const Priority priority = candidate.first;
+            const SubscriptionKey& key = candidate.second;
+            const std::string& exchange_name = std::get<0>(key);
+            SubscriptionState& state = subscriptions_[key];
+            
+            auto exchange_it = exchanges.find(exchange_name);
+            int cost = exchange_it != exchanges.end() ? exchange_it->second->getSubscriptionCost(std::get<2>(key)) : 1;
+            int quota = quotas_.count(exchange_name) ? quotas_[exchange_name].quota : -1;
+            if (!used.count(exchange_name)) {
+                used[exchange_name] = unitsInUse(exchange_name);
+            }
+            
+            if (quota >= 0 && used[exchange_name] + cost > quota) {
+                state.deferred = true;
+                auto no_victim = no_victim_at.find(exchange_name);
+                if (no_victim != no_victim_at.end() && priority <= no_victim->second) continue;
+                
+                // Evict least recently used lower-priority feeds past their hold
+                int needed = used[exchange_name] + cost - quota;
+                auto hold = holdFor(exchange_name);
+                while (needed > 0) {
+                    SubscriptionState* victim = nullptr;
+                    const SubscriptionKey* victim_key = nullptr;
+                    Priority victim_priority = kLingering;
+                    for (auto& pair : subscriptions_) {
+                        SubscriptionState& other = pair.second;
+                        if (std::get<0>(pair.first) != exchange_name || !other.active || other.in_flight) continue;
+                        if (now < other.subscribed_at + hold) continue;
+                        Priority other_priority = priorityOf(pair.first, other);
+                        if (other_priority >= priority) continue;
+                        if (victim == nullptr || other_priority < victim_priority ||
+                            (other_priority == victim_priority && other.last_used < victim->last_used)) {
+                            victim = &other;
+                            victim_key = &pair.first;
+                            victim_priority = other_priority;
+                        }
+                    }
+                    if (victim == nullptr) break;
+                    
+                    if (victim->ref_count > 0) {
+                        LOG_WARN_THROTTLED(10, 60000, "Subscription quota full on " + exchange_name + ", evicting " +
+                                           std::get<2>(*victim_key) + " for " + std::get<1>(*victim_key));
+                    }
+                    queueRequest(*victim_key, *victim, false);
+                    used[exchange_name] -= victim->cost;
+                    needed -= victim->cost;
+                }
+                
+                if (needed > 0) {
+                    no_victim_at[exchange_name] = priority;
+                    LOG_WARN_THROTTLED(10, 60000, "Subscription quota exhausted on " + exchange_name + " (" +
+                                       std::to_string(quota) + " units), deferring " + std::get<2>(key) +
+                                       " for " + std::get<1>(key));
+                }
+                // Subscribed on a later flush, once the releases are confirmed
+                continue;
+            }
+            
+            state.deferred = false;
+            state.cost = cost;
+            used[exchange_name] += cost;
+            queueRequest(key, state, true);
+            dirty_.erase(key);
+        }
+    }
     
-    std::stringstream ss;
-    ss << "Unsubscribed KLine: " << symbol;
-    LOG_INFO(ss.str());
+    // Exchange calls are made without holding the lock; completions may run inline
+    for (auto& pair : requests) {
+        bool subscribe = std::get<0>(pair.first);
+        const std::string& exchange_name = std::get<1>(pair.first);
+        const std::string& data_type = std::get<2>(pair.first);
+        uint64_t batch_id = pair.second.batch_id;
+        
+        auto exchange_it = exchanges.find(exchange_name);
+        bool sent = exchange_it != exchanges.end() && exchange_it->second->isConnected() &&
+                    exchange_it->second->updateSubscriptions(pair.second.symbols, data_type, subscribe,
+                                                             [this, batch_id](bool success) {
+                                                                 onSubscriptionResult(batch_id, success);
+                                                             });
+        if (!sent) {
+            onSubscriptionResult(batch_id, false);
+            continue;
+        }
+        
+        LOG_INFO_THROTTLED(20, 60000, std::string(subscribe ? "Subscribing " : "Unsubscribing ") + data_type +
+                           " for " + std::to_string(pair.second.symbols.size()) + " symbols on " + exchange_name);
+    }
 }
 
-bool DataSubscriber::subscribeTick(const std::string& symbol) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void DataSubscriber::resubscribeAll(const std::string& exchange_name) {
+    size_t renewed = 0;
+    {
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        
+        // Answers to these can no longer arrive
+        for (auto it = pending_batches_.begin(); it != pending_batches_.end();) {
+            bool ours = !it->second.keys.empty() && std::get<0>(it->second.keys.front()) == exchange_name;
+            it = ours ? pending_batches_.erase(it) : std::next(it);
+        }
+        
+        for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+            if (std::get<0>(it->first) != exchange_name) {
+                ++it;
+                continue;
+            }
+            if (it->second.ref_count == 0) {
+                dirty_.erase(it->first);
+                it = subscriptions_.erase(it);
+                continue;
+            }
+            SubscriptionState& state = it->second;
+            state.active = false;
+            state.in_flight = false;
+            state.deferred = false;
+            state.failures = 0;
+            state.retry_after = std::chrono::steady_clock::time_point();
+            dirty_.insert(it->first);
+            ++renewed;
+            ++it;
+        }
+        
+        // Other clients' usage may have changed while we were away
+        quotas_[exchange_name].refreshed = false;
+    }
     
-    // TODO: Call Futu API to subscribe to Tick
-    /*
-    FTDC_Quote_API* api = FTDC_Quote_API::getInstance();
-    bool success = api->subscribeTick(symbol);
-    if (!success) {
-        LOG_ERROR("Failed to subscribe Tick for " + symbol);
-        return false;
+    LOG_INFO("Renewing " + std::to_string(renewed) + " subscriptions on " + exchange_name);
+    refreshQuotas();
+    flush();
+}
+
+void DataSubscriber::onSubscriptionResult(uint64_t batch_id, bool success) {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    auto batch_it = pending_batches_.find(batch_id);
+    if (batch_it == pending_batches_.end()) {
+        return;   // timed out and already rescheduled
     }
-    */
     
-    tick_subscriptions_[symbol] = true;
+    auto now = std::chrono::steady_clock::now();
+    const PendingBatch& batch = batch_it->second;
+    for (const auto& key : batch.keys) {
+        auto state_it = subscriptions_.find(key);
+        if (state_it == subscriptions_.end()) continue;
+        SubscriptionState& state = state_it->second;
+        state.in_flight = false;
+        
+        if (success) {
+            state.active = batch.subscribe;
+            state.failures = 0;
+            if (batch.subscribe) state.subscribed_at = now;
+            if (!batch.subscribe) {
+                // No more pushes: kept books and flow would silently go stale
+                SymbolId symbol_id = SymbolRegistry::getInstance().find(std::get<0>(key), std::get<1>(key));
+                if (std::get<2>(key) == kDepthDataType) {
+                    OrderBookEngine::getInstance().remove(symbol_id);
+                } else if (std::get<2>(key) == kTickDataType) {
+                    TradeFlowEngine::getInstance().remove(symbol_id);
+                }
+            }
+        } else {
+            // Back off 1s, 2s, 4s ... up to 60s
+            state.failures = std::min(state.failures + 1, 7);
+            state.retry_after = now + std::chrono::seconds(std::min(60, 1 << (state.failures - 1)));
+        }
+        
+        if ((state.ref_count > 0) != state.active) {
+            dirty_.insert(key);
+        } else if (state.ref_count == 0) {
+            subscriptions_.erase(state_it);
+        }
+    }
     
-    std::stringstream ss;
-    ss << "Subscribed Tick: " << symbol;
-    LOG_INFO(ss.str());
+    // Freed quota may let deferred feeds in
+    if (success && !batch.subscribe) {
+        for (const auto& pair : subscriptions_) {
+            if (pair.second.deferred) dirty_.insert(pair.first);
+        }
+    }
     
-    return true;
+    if (!success) {
+        LOG_WARN_THROTTLED(10, 60000, std::string(batch.subscribe ? "Subscribe" : "Unsubscribe") + " request failed for " +
+                           std::to_string(batch.keys.size()) + " symbols, will retry");
+    }
+    pending_batches_.erase(batch_it);
 }
 
-void DataSubscriber::unsubscribeTick(const std::string& symbol) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // TODO: Call Futu API to unsubscribe
-    /*
-    FTDC_Quote_API* api = FTDC_Quote_API::getInstance();
-    api->unsubscribeTick(symbol);
-    */
+bool DataSubscriber::isSubscribed(const std::string& exchange_name, const std::string& symbol,
+                                  const std::string& data_type) const {
+    std::string type = (data_type == kTickDataType || data_type == kDepthDataType) ? data_type
+                                                                                 : normalizeKLineType(data_type);
+    if (BarAggregator::getInstance().builds(type)) {
+        type = kTickDataType;
+    }
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    auto it = subscriptions_.find(SubscriptionKey(exchange_name, symbol, type));
+    return it != subscriptions_.end() && it->second.active;
+}
+
+size_t DataSubscriber::getActiveSubscriptionCount() const {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    size_t count = 0;
+    for (const auto& pair : subscriptions_) {
+        if (pair.second.active) ++count;
+    }
+    return count;
+}
+
+std::vector<std::pair<std::string, std::string>> DataSubscriber::getActiveFeeds(const std::string& exchange_name) const {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    std::vector<std::pair<std::string, std::string>> feeds;
+    for (const auto& pair : subscriptions_) {
+        if (std::get<0>(pair.first) == exchange_name && pair.second.active && pair.second.ref_count > 0) {
+            feeds.emplace_back(std::get<1>(pair.first), std::get<2>(pair.first));
+        }
+    }
+    return feeds;
+}
+
+std::vector<SubscriptionUsage> DataSubscriber::getSubscriptionUsage() const {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
     
-    tick_subscriptions_.erase(symbol);
+    std::map<std::string, SubscriptionUsage> by_exchange;
+    for (const auto& pair : quotas_) {
+        by_exchange[pair.first].quota = pair.second.quota;
+    }
+    for (const auto& pair : subscriptions_) {
+        const std::string& exchange_name = std::get<0>(pair.first);
+        const SubscriptionState& state = pair.second;
+        SubscriptionUsage& usage = by_exchange[exchange_name];
+        
+        if (state.active) {
+            ++usage.subscribed;
+            if (priorityOf(pair.first, state) == kPosition) ++usage.position_feeds;
+            if (state.ref_count == 0) ++usage.lingering;
+        }
+        if (state.deferred) ++usage.deferred;
+        if (state.in_flight) ++usage.pending;
+    }
     
+    std::vector<SubscriptionUsage> result;
+    for (auto& pair : by_exchange) {
+        pair.second.exchange = pair.first;
+        pair.second.used = unitsInUse(pair.first);
+        result.push_back(pair.second);
+    }
+    return result;
+}
+
+std::string DataSubscriber::getUsageReport() const {
     std::stringstream ss;
-    ss << "Unsubscribed Tick: " << symbol;
-    LOG_INFO(ss.str());
+    for (const auto& usage : getSubscriptionUsage()) {
+        ss << usage.exchange << ": " << usage.used << "/"
+           << (usage.quota < 0 ? std::string("unlimited") : std::to_string(usage.quota)) << " units, "
+           << usage.subscribed << " feeds (" << usage.position_feeds << " position, "
+           << usage.lingering << " lingering), " << usage.deferred << " deferred, "
+           << usage.pending << " pending\n";
+    }
+    return ss.str();
 }
 
 void DataSubscriber::registerKLineCallback(KLineCallback callback) {
@@ -112,15 +666,17 @@ std::vector<KlineData> DataSubscriber::getHistoryKLine(
     
     std::vector<KlineData> klines;
     
-    // TODO: Call Futu API to get historical KLine
-    /*
-    FTDC_Quote_API* api = FTDC_Quote_API::getInstance();
-    api->getHistoryKLine(symbol, kline_type, count, klines);
-    */
+    auto exchange = ExchangeManager::getInstance().getExchange(resolveExchange(symbol));
+    if (!exchange) {
+        LOG_ERROR("Cannot get history KLine for " + symbol + ": unknown exchange");
+        return klines;
+    }
     
-    std::stringstream ss;
-    ss << "Retrieved " << klines.size() << " history KLines for " << symbol << " " << kline_type << " count=" << count;
-    LOG_INFO(ss.str());
+    // Served from memory when the cache covers the request
+    klines = KLineCache::getInstance().getHistoryKLine(exchange, symbol, kline_type, count);
+    
+    LOG_INFO_THROTTLED(20, 60000, "Retrieved " + std::to_string(klines.size()) + " history KLines for " +
+                       symbol + " " + kline_type + " count=" + std::to_string(count));
     
     return klines;
 }
@@ -135,9 +691,7 @@ Snapshot DataSubscriber::getSnapshot(const std::string& symbol) {
     api->getSnapshot(symbol, snapshot);
     */
     
-    std::stringstream ss;
-    ss << "Retrieved snapshot for " << symbol;
-    LOG_INFO(ss.str());
+    LOG_INFO_THROTTLED(20, 60000, "Retrieved snapshot for " + symbol);
     
     return snapshot;
 }
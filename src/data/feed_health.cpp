@@ -0,0 +1,480 @@
+#include "data/feed_health.h"
+#include "data/data_subscriber.h"
+#include "data/bar_aggregator.h"
+#include "data/kline_cache.h"
+#include "data/trading_calendar.h"
+#include "exchange/exchange_manager.h"
+#include "event/event.h"
+#include "utils/exchange_time.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+constexpr int64_t kNsPerSec = exchange_time::kNanosPerSecond;
+
+// A symbol's bars are reloaded at most this often
+constexpr int64_t kBackfillCooldownNs = 300 * kNsPerSec;
+
+// Silence across a whole exchange only means a dead feed with enough feeds to judge by
+constexpr size_t kMinSilentFeeds = 3;
+constexpr int64_t kResyncCooldownNs = 300 * kNsPerSec;
+
+// Reconnect attempts back off 1s, 2s, 4s ... up to this
+constexpr int kMaxReconnectBackoffSec = 30;
+
+} // namespace
+
+FeedHealth& FeedHealth::getInstance() {
+    static FeedHealth instance;
+    return instance;
+}
+
+FeedHealth::~FeedHealth() {
+    stop();
+}
+
+void FeedHealth::initializeEventHandlers(IEventEngine* event_engine) {
+    if (event_engine == nullptr) {
+        LOG_ERROR("Event engine is null");
+        return;
+    }
+
+    event_engine_ = event_engine;
+    tick_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_TICK,
+        [this](const EventPtr& event) { this->onTickEvent(event); }
+    );
+    trade_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_TRADE,
+        [this](const EventPtr& event) { this->onTradeEvent(event); }
+    );
+    depth_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_DEPTH,
+        [this](const EventPtr& event) { this->onDepthEvent(event); }
+    );
+    kline_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_KLINE,
+        [this](const EventPtr& event) { this->onKLineEvent(event); }
+    );
+
+    LOG_INFO("FeedHealth event handlers registered");
+}
+
+void FeedHealth::start(const MarketDataConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stale_ns_ = int64_t(std::max(0, config.feed_stale_seconds)) * kNsPerSec;
+        parallelism_ = static_cast<size_t>(std::max(1, config.feed_backfill_parallelism));
+    }
+    if (running_) return;
+
+    running_ = true;
+    monitor_thread_ = std::thread(&FeedHealth::monitorLoop, this);
+    LOG_INFO("Feed health monitor started, stale after " + std::to_string(config.feed_stale_seconds) +
+             "s, backfill parallelism " + std::to_string(parallelism_));
+}
+
+void FeedHealth::stop() {
+    if (!running_) return;
+
+    {
+        std::lock_guard<std::mutex> lock(monitor_mutex_);
+        running_ = false;
+    }
+    monitor_cv_.notify_all();
+    if (monitor_thread_.joinable()) {
+        monitor_thread_.join();
+    }
+}
+
+void FeedHealth::monitorLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(monitor_mutex_);
+            monitor_cv_.wait_for(lock, std::chrono::seconds(1), [this] { return !running_; });
+        }
+        if (!running_) break;
+
+        check(exchange_time::nowNs());
+    }
+}
+
+// ========== Pushes ==========
+
+void FeedHealth::onTickEvent(const EventPtr& event) {
+    if (!event) return;
+    const TickData* tick = event->getData<TickData>();
+    if (tick != nullptr) onTick(*tick);
+}
+
+void FeedHealth::onTradeEvent(const EventPtr& event) {
+    if (!event) return;
+    const TradePrint* trade = event->getData<TradePrint>();
+    if (trade != nullptr) onTrade(*trade);
+}
+
+void FeedHealth::onDepthEvent(const EventPtr& event) {
+    if (!event) return;
+    const DepthData* depth = event->getData<DepthData>();
+    if (depth != nullptr) onDepth(*depth);
+}
+
+void FeedHealth::onKLineEvent(const EventPtr& event) {
+    if (!event) return;
+    const KlineData* kline = event->getData<KlineData>();
+    if (kline != nullptr) onKLine(*kline);
+}
+
+void FeedHealth::touch(SymbolId symbol_id, int64_t local_ts_ns) {
+    if (symbol_id == kInvalidSymbolId) return;
+    int64_t ts = local_ts_ns != 0 ? local_ts_ns : exchange_time::nowNs();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    FeedStatus& status = symbols_[symbol_id].status;
+    status.last_update_ns = std::max(status.last_update_ns, ts);
+}
+
+void FeedHealth::onTick(const TickData& tick) {
+    touch(SymbolRegistry::getInstance().resolve(tick.symbol_id, tick.exchange, tick.symbol), tick.local_ts_ns);
+}
+
+void FeedHealth::onTrade(const TradePrint& trade) {
+    auto& registry = SymbolRegistry::getInstance();
+    SymbolId symbol_id = registry.resolve(trade.symbol_id, trade.exchange, trade.symbol);
+    if (symbol_id == kInvalidSymbolId) return;
+    touch(symbol_id, trade.local_ts_ns);
+    if (trade.sequence == 0) return;
+
+    // Prints are numbered by the exchange; a skipped number is a lost print,
+    // however quiet the symbol. A lower number starts a new run (next trading day).
+    std::lock_guard<std::mutex> lock(mutex_);
+    SymbolHealth& health = symbols_[symbol_id];
+    if (trade.sequence == health.last_sequence) return;   // replayed print
+    if (health.last_sequence != 0 && trade.sequence > health.last_sequence + 1) {
+        int64_t missed = trade.sequence - health.last_sequence - 1;
+        ++health.status.gaps;
+        health.status.missed_prints += missed;
+        gapped_.insert(symbol_id);
+        LOG_WARN_THROTTLED(10, 60000, "Gap in trade prints of " + registry.code(symbol_id) + ": " +
+                           std::to_string(missed) + " missing, backfilling");
+    }
+    health.last_sequence = trade.sequence;
+}
+
+void FeedHealth::onDepth(const DepthData& depth) {
+    touch(SymbolRegistry::getInstance().resolve(depth.symbol_id, depth.exchange, depth.symbol), depth.local_ts_ns);
+}
+
+void FeedHealth::onKLine(const KlineData& kline) {
+    auto& registry = SymbolRegistry::getInstance();
+    SymbolId symbol_id = registry.resolve(kline.symbol_id, kline.exchange, kline.symbol);
+    if (symbol_id == kInvalidSymbolId) return;
+    touch(symbol_id, kline.local_ts_ns);
+    if (kline.exchange_ts_ns == 0) return;
+
+    const std::string interval = DataSubscriber::normalizeKLineType(kline.interval);
+    int64_t bar_sec = KLineCache::barDuration(interval).count();
+    if (bar_sec <= 0 || bar_sec >= 86400) return;   // daily and longer bars are not pushed bar by bar
+    // Locally built bars skip tradeless time, so a quiet symbol would look
+    // like a gap; their prints are sequence-checked in onTrade instead
+    if (BarAggregator::getInstance().builds(interval)) return;
+
+    // Sessions decide which time should have held bars; the market is
+    // looked up once per exchange, outside the lock
+    const std::string& exchange_name = registry.exchange(symbol_id);
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        known = exchanges_.count(exchange_name) > 0;
+    }
+    std::string market;
+    if (!known) {
+        if (auto exchange = ExchangeManager::getInstance().getExchange(exchange_name)) {
+            market = exchange->getMarket();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ExchangeHealth& exchange_state = exchanges_[exchange_name];
+    if (!known) exchange_state.market = market;
+
+    SymbolHealth& health = symbols_[symbol_id];
+    int64_t& last_bar = health.last_bar_ns[interval];
+    if (kline.exchange_ts_ns <= last_bar) return;   // in-progress update or late bar
+
+    if (last_bar != 0) {
+        // Bars are stamped with their end: the session time between two
+        // consecutive bars is one bar long
+        int64_t covered = TradingCalendar::getInstance().sessionSeconds(exchange_state.market, last_bar,
+                                                                        kline.exchange_ts_ns);
+        int64_t missed = (covered - 1) / bar_sec;
+        if (missed > 0) {
+            ++health.status.gaps;
+            health.status.missed_bars += missed;
+            gapped_.insert(symbol_id);
+            LOG_WARN_THROTTLED(10, 60000, "Gap in " + interval + " bars of " + registry.code(symbol_id) + ": " +
+                               std::to_string(missed) + " missing, backfilling");
+        }
+    }
+    last_bar = kline.exchange_ts_ns;
+}
+
+// ========== Monitor ==========
+
+void FeedHealth::check(int64_t now_ns) {
+    for (auto& exchange : ExchangeManager::getInstance().getAllExchanges()) {
+        checkExchange(exchange, now_ns);
+    }
+
+    // Symbols with bar gaps, each reloaded at most once per cooldown
+    std::vector<BackfillJob> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& registry = SymbolRegistry::getInstance();
+        for (SymbolId symbol_id : gapped_) {
+            SymbolHealth* health = symbols_.find(symbol_id);
+            if (health == nullptr || now_ns - health->last_backfill_ns < kBackfillCooldownNs) continue;
+            health->last_backfill_ns = now_ns;
+            jobs.push_back(BackfillJob{registry.exchange(symbol_id), registry.code(symbol_id), symbol_id});
+        }
+        gapped_.clear();
+    }
+    backfill(jobs);
+}
+
+void FeedHealth::checkExchange(const std::shared_ptr<IExchange>& exchange, int64_t now_ns) {
+    const std::string name = exchange->getName();
+    const std::string market = exchange->getMarket();
+    auto steady_now = std::chrono::steady_clock::now();
+    bool up = exchange->isConnected();
+
+    bool attempt = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ExchangeHealth& state = exchanges_[name];
+        state.market = market;
+        if (!up && state.connected) {
+            state.connected = false;
+            state.down_since_ns = now_ns;
+            state.next_attempt = steady_now;
+            LOG_WARN("Market data connection to " + name + " lost");
+        }
+        // Exchanges that never connected are left to the startup path
+        attempt = !up && state.was_connected && steady_now >= state.next_attempt;
+    }
+
+    if (attempt) {
+        // Blocking exchange call, made without holding the lock
+        up = exchange->reconnect() && exchange->isConnected();
+        if (!up) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ExchangeHealth& state = exchanges_[name];
+            state.failures = std::min(state.failures + 1, 6);
+            int backoff = std::min(kMaxReconnectBackoffSec, 1 << (state.failures - 1));
+            state.next_attempt = std::chrono::steady_clock::now() + std::chrono::seconds(backoff);
+            LOG_WARN_THROTTLED(10, 60000, "Reconnect to " + name + " failed, next attempt in " +
+                               std::to_string(backoff) + "s");
+        }
+    }
+    if (!up) return;
+
+    bool recovered = false;
+    int64_t down_ns = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ExchangeHealth& state = exchanges_[name];
+        recovered = state.was_connected && !state.connected;
+        down_ns = now_ns - state.down_since_ns;
+        state.connected = true;
+        state.was_connected = true;
+        state.failures = 0;
+    }
+    if (recovered) {
+        LOG_INFO("Market data connection to " + name + " restored after " +
+                 std::to_string(down_ns / 1000000) + "ms");
+        resync(name, now_ns);
+        return;
+    }
+
+    // Staleness of the feeds consumers hold
+    auto feeds = DataSubscriber::getInstance().getActiveFeeds(name);
+    std::set<SymbolId> watched;
+    auto& registry = SymbolRegistry::getInstance();
+    for (const auto& feed : feeds) {
+        watched.insert(registry.intern(name, feed.first));
+    }
+
+    const auto& calendar = TradingCalendar::getInstance();
+    bool silent = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t stale = 0;
+        for (SymbolId symbol_id : watched) {
+            SymbolHealth& health = symbols_[symbol_id];
+            if (health.watched_since_ns == 0) health.watched_since_ns = now_ns;
+
+            int64_t since = std::max(health.status.last_update_ns, health.watched_since_ns);
+            bool is_stale = stale_ns_ > 0 &&
+                            calendar.sessionSeconds(market, since, now_ns) * kNsPerSec >= stale_ns_;
+            if (is_stale && !health.status.stale) {
+                LOG_WARN_THROTTLED(10, 60000, "No market data for " + registry.code(symbol_id) + " on " + name +
+                                   " for " + std::to_string(stale_ns_ / kNsPerSec) + "s of session time");
+            }
+            health.status.stale = is_stale;
+            if (is_stale) ++stale;
+        }
+
+        // Released symbols no longer count
+        symbols_.forEach([&](SymbolId symbol_id, SymbolHealth& health) {
+            if (health.watched_since_ns != 0 && !watched.count(symbol_id) && registry.exchange(symbol_id) == name) {
+                health.watched_since_ns = 0;
+                health.status.stale = false;
+            }
+        });
+
+        ExchangeHealth& state = exchanges_[name];
+        state.feeds = watched.size();
+        state.stale = stale;
+        silent = watched.size() >= kMinSilentFeeds && stale == watched.size() &&
+                 now_ns - state.last_resync_ns >= kResyncCooldownNs;
+    }
+
+    if (silent) {
+        LOG_WARN("All " + std::to_string(watched.size()) + " feeds on " + name +
+                 " are silent while connected, resyncing");
+        resync(name, now_ns);
+    }
+}
+
+void FeedHealth::resync(const std::string& name, int64_t now_ns) {
+    auto started = std::chrono::steady_clock::now();
+
+    // Renew the feeds first so pushes resume while history is fetched
+    DataSubscriber::getInstance().resubscribeAll(name);
+
+    std::vector<BackfillJob> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& registry = SymbolRegistry::getInstance();
+        symbols_.forEach([&](SymbolId symbol_id, SymbolHealth& health) {
+            if (registry.exchange(symbol_id) != name) return;
+            health.last_backfill_ns = now_ns;
+            health.status.stale = false;
+            health.watched_since_ns = 0;   // the renewed feed gets a fresh start
+            gapped_.erase(symbol_id);
+            jobs.push_back(BackfillJob{name, registry.code(symbol_id), symbol_id});
+        });
+    }
+    backfill(jobs);
+
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ExchangeHealth& state = exchanges_[name];
+        state.last_resync_ns = now_ns;
+        state.last_resync_ms = elapsed_ms;
+    }
+    LOG_INFO("Resynced " + name + ": " + std::to_string(jobs.size()) + " symbols backfilled in " +
+             std::to_string(elapsed_ms) + "ms");
+}
+
+void FeedHealth::backfill(const std::vector<BackfillJob>& jobs) {
+    if (jobs.empty()) return;
+
+    size_t parallelism = 1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        parallelism = parallelism_;
+    }
+
+    // Workers pull symbols until none are left; each symbol is one history
+    // request per interval it had cached
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        auto& cache = KLineCache::getInstance();
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            const BackfillJob& job = jobs[i];
+            auto exchange = ExchangeManager::getInstance().getExchange(job.exchange);
+            if (!exchange || !exchange->isConnected()) continue;
+
+            for (const auto& cached : cache.invalidate(job.symbol_id)) {
+                if (cached.second == 0) continue;
+                cache.getHistoryKLine(exchange, job.symbol, cached.first, static_cast<int>(cached.second));
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            SymbolHealth* health = symbols_.find(job.symbol_id);
+            if (health != nullptr) ++health->status.backfills;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t count = std::min(parallelism, jobs.size());
+    for (size_t i = 1; i < count; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// ========== Queries ==========
+
+bool FeedHealth::getStatus(SymbolId symbol_id, FeedStatus& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const SymbolHealth* health = symbols_.find(symbol_id);
+    if (health == nullptr || health->status.last_update_ns == 0) return false;
+    out = health->status;
+    return true;
+}
+
+bool FeedHealth::isStale(SymbolId symbol_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const SymbolHealth* health = symbols_.find(symbol_id);
+    return health != nullptr && health->status.stale;
+}
+
+std::vector<SymbolId> FeedHealth::getStaleSymbols() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<SymbolId> stale;
+    symbols_.forEach([&](SymbolId symbol_id, const SymbolHealth& health) {
+        if (health.status.stale) stale.push_back(symbol_id);
+    });
+    return stale;
+}
+
+std::string FeedHealth::getHealthReport() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    struct GapTotals {
+        int64_t gaps = 0;
+        int64_t bars = 0;
+        int64_t prints = 0;
+    };
+    std::map<std::string, GapTotals> gaps;   // by exchange
+    auto& registry = SymbolRegistry::getInstance();
+    symbols_.forEach([&](SymbolId symbol_id, const SymbolHealth& health) {
+        GapTotals& totals = gaps[registry.exchange(symbol_id)];
+        totals.gaps += health.status.gaps;
+        totals.bars += health.status.missed_bars;
+        totals.prints += health.status.missed_prints;
+    });
+
+    std::stringstream ss;
+    for (const auto& pair : exchanges_) {
+        const ExchangeHealth& state = pair.second;
+        const GapTotals& totals = gaps[pair.first];
+        ss << pair.first << ": " << (state.connected ? "connected" : "DISCONNECTED") << ", "
+           << state.stale << "/" << state.feeds << " feeds stale, "
+           << totals.gaps << " gaps (" << totals.bars << " bars, " << totals.prints << " prints)";
+        if (state.last_resync_ns != 0) {
+            ss << ", last resync took " << state.last_resync_ms << "ms";
+        }
+        ss << "\n";
+    }
+    return ss.str();
+}
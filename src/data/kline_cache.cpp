@@ -0,0 +1,209 @@
+#include "data/kline_cache.h"
+#include "data/data_subscriber.h"
+#include "data/bar_store.h"
+#include "exchange/exchange_interface.h"
+#include "event/event.h"
+#include "common/trading_session.h"
+#include "utils/exchange_time.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+KLineCache& KLineCache::getInstance() {
+    static KLineCache instance;
+    return instance;
+}
+
+const KlineData& KLineCache::Series::at(size_t i) const {
+    return bars[(head + i) % bars.size()];
+}
+
+KlineData& KLineCache::Series::back() {
+    return bars[(head + bars.size() - 1) % bars.size()];
+}
+
+void KLineCache::Series::push(const KlineData& bar, size_t capacity) {
+    if (bars.size() < capacity) {
+        bars.push_back(bar);
+        return;
+    }
+    bars[head] = bar;
+    head = (head + 1) % bars.size();
+}
+
+void KLineCache::setCapacity(size_t bars) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = std::max<size_t>(1, bars);
+    series_.clear();
+}
+
+std::vector<std::pair<std::string, size_t>> KLineCache::invalidate(SymbolId symbol_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<std::pair<std::string, size_t>> dropped;
+    auto* by_interval = series_.find(symbol_id);
+    if (by_interval == nullptr) return dropped;
+
+    for (const auto& pair : *by_interval) {
+        dropped.emplace_back(pair.first, pair.second.size());
+    }
+    series_.erase(symbol_id);
+    return dropped;
+}
+
+void KLineCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series_.clear();
+}
+
+void KLineCache::initializeEventHandlers(IEventEngine* event_engine) {
+    if (event_engine == nullptr) {
+        LOG_ERROR("Event engine is null");
+        return;
+    }
+
+    event_engine_ = event_engine;
+    kline_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_KLINE,
+        [this](const EventPtr& event) { this->onKLineEvent(event); }
+    );
+
+    LOG_INFO("KLineCache event handlers registered");
+}
+
+void KLineCache::onKLineEvent(const EventPtr& event) {
+    if (!event) {
+        return;
+    }
+
+    const KlineData* kline = event->getData<KlineData>();
+    if (kline != nullptr) {
+        onKLine(*kline);
+    }
+}
+
+std::chrono::seconds KLineCache::barDuration(const std::string& interval) {
+    static const std::map<std::string, int64_t> durations = {
+        {"1m", 60}, {"3m", 180}, {"5m", 300}, {"15m", 900}, {"30m", 1800}, {"1h", 3600},
+        {"1d", 86400}, {"1w", 7 * 86400}, {"1mon", 30 * 86400},
+    };
+    auto it = durations.find(interval);
+    return std::chrono::seconds(it != durations.end() ? it->second : 60);
+}
+
+bool KLineCache::syncExpired(const std::string& interval, const std::string& market,
+                             int64_t synced_ns, int64_t now_ns) {
+    const std::chrono::seconds bar = barDuration(interval);
+    if (now_ns - synced_ns >= std::chrono::duration_cast<std::chrono::nanoseconds>(bar).count()) {
+        return true;
+    }
+    return bar >= std::chrono::hours(24) && marketDate(market, synced_ns) != marketDate(market, now_ns);
+}
+
+std::vector<KlineData> KLineCache::getHistoryKLine(
+    const std::shared_ptr<IExchange>& exchange,
+    const std::string& symbol,
+    const std::string& kline_type,
+    int count) {
+
+    if (!exchange || count <= 0) {
+        return {};
+    }
+
+    const std::string interval = DataSubscriber::normalizeKLineType(kline_type);
+    SymbolId symbol_id = SymbolRegistry::getInstance().intern(exchange->getName(), symbol);
+    bool cacheable = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cacheable = static_cast<size_t>(count) <= capacity_;
+    }
+
+    std::vector<KlineData> klines;
+    if (cacheable && readCached(symbol_id, interval, exchange->getMarket(), static_cast<size_t>(count), klines)) {
+        return klines;
+    }
+
+    // Miss: read from the on-disk store, which fetches only the bars it lacks
+    klines = BarStore::getInstance().getHistoryKLine(exchange, symbol, kline_type, count);
+    if (cacheable && !klines.empty()) {
+        seed(symbol_id, interval, klines, static_cast<size_t>(count));
+    }
+    return klines;
+}
+
+bool KLineCache::readCached(SymbolId symbol_id, const std::string& interval, const std::string& market,
+                            size_t count, std::vector<KlineData>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto* by_interval = series_.find(symbol_id);
+    if (by_interval == nullptr) return false;
+    auto it = by_interval->find(interval);
+    if (it == by_interval->end()) return false;
+
+    const Series& series = it->second;
+    if (syncExpired(interval, market, series.updated_ns, exchange_time::nowNs())) {
+        return false;   // no pushes for a whole bar or since an earlier day: the tail may be stale
+    }
+    if (series.size() < count && !series.complete) {
+        return false;
+    }
+
+    size_t n = std::min(count, series.size());
+    out.clear();
+    out.reserve(n);
+    for (size_t i = series.size() - n; i < series.size(); ++i) {
+        out.push_back(series.at(i));
+    }
+    return true;
+}
+
+void KLineCache::seed(SymbolId symbol_id, const std::string& interval, const std::vector<KlineData>& history,
+                      size_t requested) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Series& series = series_[symbol_id][interval];
+
+    // Keep pushed bars newer than the fetched history
+    std::vector<KlineData> newer;
+    int64_t last_ts = history.back().exchange_ts_ns;
+    for (size_t i = 0; i < series.size(); ++i) {
+        if (last_ts != 0 && series.at(i).exchange_ts_ns > last_ts) {
+            newer.push_back(series.at(i));
+        }
+    }
+
+    Series fresh;
+    fresh.complete = history.size() < requested;
+    size_t skip = history.size() > capacity_ ? history.size() - capacity_ : 0;
+    for (size_t i = skip; i < history.size(); ++i) {
+        fresh.push(history[i], capacity_);
+    }
+    for (const auto& bar : newer) {
+        fresh.push(bar, capacity_);
+    }
+    fresh.updated_ns = exchange_time::nowNs();
+    series = std::move(fresh);
+}
+
+void KLineCache::onKLine(const KlineData& kline) {
+    const std::string interval = DataSubscriber::normalizeKLineType(kline.interval);
+    SymbolId symbol_id = SymbolRegistry::getInstance().resolve(kline.symbol_id, kline.exchange, kline.symbol);
+    if (symbol_id == kInvalidSymbolId) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Only series that were seeded from history are maintained
+    auto* by_interval = series_.find(symbol_id);
+    if (by_interval == nullptr) return;
+    auto it = by_interval->find(interval);
+    if (it == by_interval->end()) return;
+
+    Series& series = it->second;
+    if (series.size() == 0 || kline.exchange_ts_ns > series.back().exchange_ts_ns) {
+        series.push(kline, capacity_);
+    } else if (kline.exchange_ts_ns == series.back().exchange_ts_ns) {
+        series.back() = kline;   // in-progress bar update
+    } else {
+        return;                  // late update for an older bar
+    }
+    series.updated_ns = exchange_time::nowNs();
+}
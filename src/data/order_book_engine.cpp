@@ -0,0 +1,141 @@
+#include "data/order_book_engine.h"
+#include "event/event.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+OrderBookEngine& OrderBookEngine::getInstance() {
+    static OrderBookEngine instance;
+    return instance;
+}
+
+void OrderBookEngine::initializeEventHandlers(IEventEngine* event_engine) {
+    if (event_engine == nullptr) {
+        LOG_ERROR("Event engine is null");
+        return;
+    }
+
+    event_engine_ = event_engine;
+    depth_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_DEPTH,
+        [this](const EventPtr& event) { this->onDepthEvent(event); }
+    );
+
+    LOG_INFO("OrderBookEngine event handlers registered");
+}
+
+void OrderBookEngine::onDepthEvent(const EventPtr& event) {
+    if (!event) {
+        return;
+    }
+
+    const DepthData* depth = event->getData<DepthData>();
+    if (depth != nullptr) {
+        onDepth(*depth);
+    }
+}
+
+void OrderBookEngine::onDepth(const DepthData& depth) {
+    SymbolId symbol_id = SymbolRegistry::getInstance().resolve(depth.symbol_id, depth.exchange, depth.symbol);
+    if (symbol_id == kInvalidSymbolId) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Book& slot = books_[symbol_id];
+    slot.book = depth.book;
+    slot.exchange_ts_ns = depth.exchange_ts_ns;
+    slot.local_ts_ns = depth.local_ts_ns;
+
+    int64_t bid_total = 0;
+    for (size_t i = 0; i < slot.book.bid_count; ++i) {
+        bid_total += slot.book.bids[i].volume;
+        slot.bid_total[i] = bid_total;
+    }
+    int64_t ask_total = 0;
+    for (size_t i = 0; i < slot.book.ask_count; ++i) {
+        ask_total += slot.book.asks[i].volume;
+        slot.ask_total[i] = ask_total;
+    }
+}
+
+bool OrderBookEngine::getBook(SymbolId symbol_id, DepthBook& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Book* slot = books_.find(symbol_id);
+    if (slot == nullptr) return false;
+    out = slot->book;
+    return true;
+}
+
+bool OrderBookEngine::getMetrics(SymbolId symbol_id, size_t levels, BookMetrics& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Book* slot = books_.find(symbol_id);
+    if (slot == nullptr) return false;
+
+    const DepthBook& book = slot->book;
+    out = BookMetrics();
+    out.exchange_ts_ns = slot->exchange_ts_ns;
+    out.local_ts_ns = slot->local_ts_ns;
+
+    size_t bid_levels = std::min<size_t>(levels, book.bid_count);
+    size_t ask_levels = std::min<size_t>(levels, book.ask_count);
+    out.bid_volume = bid_levels > 0 ? slot->bid_total[bid_levels - 1] : 0;
+    out.ask_volume = ask_levels > 0 ? slot->ask_total[ask_levels - 1] : 0;
+    int64_t total = out.bid_volume + out.ask_volume;
+    out.imbalance = total > 0 ? double(out.bid_volume - out.ask_volume) / double(total) : 0.0;
+
+    if (book.bid_count > 0) out.best_bid = book.bids[0].price;
+    if (book.ask_count > 0) out.best_ask = book.asks[0].price;
+    if (book.bid_count > 0 && book.ask_count > 0) {
+        out.spread = out.best_ask - out.best_bid;
+        out.mid = (out.best_bid + out.best_ask) / 2.0;
+
+        // Weighted by the opposite side's size: a thin ask pulls the price up
+        int64_t bid_size = book.bids[0].volume;
+        int64_t ask_size = book.asks[0].volume;
+        out.microprice = bid_size + ask_size > 0
+            ? (out.best_bid * ask_size + out.best_ask * bid_size) / double(bid_size + ask_size)
+            : out.mid;
+    }
+    return true;
+}
+
+bool OrderBookEngine::getBidAskRatio(SymbolId symbol_id, size_t levels, double& ratio) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Book* slot = books_.find(symbol_id);
+    if (slot == nullptr) return false;
+    ratio = bidAskRatio(*slot, levels);
+    return true;
+}
+
+void OrderBookEngine::getBidAskRatios(const std::vector<SymbolId>& symbol_ids, size_t levels,
+                                      std::vector<double>& ratios) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < symbol_ids.size() && i < ratios.size(); ++i) {
+        const Book* slot = books_.find(symbol_ids[i]);
+        if (slot != nullptr) {
+            ratios[i] = bidAskRatio(*slot, levels);
+        }
+    }
+}
+
+double OrderBookEngine::bidAskRatio(const Book& slot, size_t levels) {
+    size_t bid_levels = std::min<size_t>(levels, slot.book.bid_count);
+    size_t ask_levels = std::min<size_t>(levels, slot.book.ask_count);
+    int64_t bid_volume = bid_levels > 0 ? slot.bid_total[bid_levels - 1] : 0;
+    int64_t ask_volume = ask_levels > 0 ? slot.ask_total[ask_levels - 1] : 0;
+
+    // Same conventions as the level-1 ratio of the scanner
+    if (ask_volume <= 0) {
+        return bid_volume > 0 ? 10.0 : 1.0;
+    }
+    return double(bid_volume) / double(ask_volume);
+}
+
+void OrderBookEngine::remove(SymbolId symbol_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    books_.erase(symbol_id);
+}
+
+void OrderBookEngine::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    books_.clear();
+}
@@ -0,0 +1,170 @@
+#include "data/trade_flow_engine.h"
+#include "data/order_book_engine.h"
+#include "event/event.h"
+#include "utils/exchange_time.h"
+#include "utils/logger.h"
+
+TradeFlowEngine& TradeFlowEngine::getInstance() {
+    static TradeFlowEngine instance;
+    return instance;
+}
+
+void TradeFlowEngine::Totals::add(const Totals& other, int sign) {
+    buy_volume += sign * other.buy_volume;
+    sell_volume += sign * other.sell_volume;
+    volume += sign * other.volume;
+    turnover += sign * other.turnover;
+    prints += sign * other.prints;
+}
+
+void TradeFlowEngine::initializeEventHandlers(IEventEngine* event_engine) {
+    if (event_engine == nullptr) {
+        LOG_ERROR("Event engine is null");
+        return;
+    }
+
+    event_engine_ = event_engine;
+    trade_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_TRADE,
+        [this](const EventPtr& event) { this->onTradeEvent(event); }
+    );
+
+    LOG_INFO("TradeFlowEngine event handlers registered");
+}
+
+void TradeFlowEngine::onTradeEvent(const EventPtr& event) {
+    if (!event) {
+        return;
+    }
+
+    const TradePrint* trade = event->getData<TradePrint>();
+    if (trade != nullptr) {
+        onTrade(*trade);
+    }
+}
+
+void TradeFlowEngine::advance(Flow& flow, int64_t second) {
+    if (second <= flow.last_second) return;
+
+    if (flow.last_second == 0 || second - flow.last_second >= static_cast<int64_t>(kRingSeconds)) {
+        flow.buckets.fill(Totals());
+        flow.windows.fill(Totals());
+        flow.last_second = second;
+        return;
+    }
+
+    for (int64_t t = flow.last_second + 1; t <= second; ++t) {
+        // As `t` becomes the newest second, second t - w leaves window w
+        for (size_t w = 0; w < kWindowCount; ++w) {
+            flow.windows[w].add(flow.buckets[(t - kWindows[w]) % kRingSeconds], -1);
+        }
+        flow.buckets[t % kRingSeconds] = Totals();
+    }
+    flow.last_second = second;
+}
+
+void TradeFlowEngine::onTrade(const TradePrint& trade) {
+    if (trade.price <= 0.0 || trade.volume <= 0) return;
+
+    SymbolId symbol_id = SymbolRegistry::getInstance().resolve(trade.symbol_id, trade.exchange, trade.symbol);
+    if (symbol_id == kInvalidSymbolId) return;
+
+    int64_t ts_ns = trade.exchange_ts_ns != 0 ? trade.exchange_ts_ns : trade.local_ts_ns;
+    int64_t second = ts_ns / exchange_time::kNanosPerSecond;
+    if (second <= 0) return;
+
+    // Quote rule needs the book, read before taking our lock
+    AggressorSide side = trade.side;
+    BookMetrics book;
+    bool have_book = side == AggressorSide::UNKNOWN &&
+                     OrderBookEngine::getInstance().getMetrics(symbol_id, 1, book);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto& slot = flows_[symbol_id];
+    if (!slot) {
+        slot.reset(new Flow());
+    }
+    Flow& flow = *slot;
+
+    if (side == AggressorSide::UNKNOWN) {
+        if (have_book && book.best_ask > 0.0 && trade.price >= book.best_ask) {
+            side = AggressorSide::BUY;
+        } else if (have_book && book.best_bid > 0.0 && trade.price <= book.best_bid) {
+            side = AggressorSide::SELL;
+        } else if (flow.last_price > 0.0 && trade.price != flow.last_price) {
+            side = trade.price > flow.last_price ? AggressorSide::BUY : AggressorSide::SELL;
+        } else {
+            side = flow.last_side;   // zero tick: same side as the previous print
+        }
+    }
+
+    advance(flow, second);
+    if (second <= flow.last_second - static_cast<int64_t>(kRingSeconds)) {
+        return;   // older than every window
+    }
+
+    Totals print;
+    print.volume = trade.volume;
+    print.turnover = trade.turnover > 0.0 ? trade.turnover : trade.price * trade.volume;
+    print.prints = 1;
+    if (side == AggressorSide::BUY) print.buy_volume = trade.volume;
+    if (side == AggressorSide::SELL) print.sell_volume = trade.volume;
+
+    flow.buckets[second % kRingSeconds].add(print, 1);
+    for (size_t w = 0; w < kWindowCount; ++w) {
+        if (second > flow.last_second - kWindows[w]) {
+            flow.windows[w].add(print, 1);
+        }
+    }
+
+    if (ts_ns >= flow.last_print_ns) {
+        flow.last_print_ns = ts_ns;
+        flow.last_price = trade.price;
+        if (side == AggressorSide::BUY || side == AggressorSide::SELL) {
+            flow.last_side = side;
+        }
+    }
+}
+
+bool TradeFlowEngine::getFlow(SymbolId symbol_id, int window_seconds, FlowStats& out, int64_t now_ns) {
+    size_t w = 0;
+    while (w + 1 < kWindowCount && kWindows[w] < window_seconds) {
+        ++w;
+    }
+    if (now_ns == 0) {
+        now_ns = exchange_time::nowNs();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto* slot = flows_.find(symbol_id);
+    if (slot == nullptr || !*slot) return false;
+
+    Flow& flow = **slot;
+    advance(flow, now_ns / exchange_time::kNanosPerSecond);
+
+    const Totals& totals = flow.windows[w];
+    out = FlowStats();
+    out.window_seconds = kWindows[w];
+    out.buy_volume = totals.buy_volume;
+    out.sell_volume = totals.sell_volume;
+    out.volume = totals.volume;
+    out.turnover = totals.turnover;
+    out.prints = totals.prints;
+    out.vwap = totals.volume > 0 ? totals.turnover / double(totals.volume) : 0.0;
+    out.print_rate = double(totals.prints) / kWindows[w];
+    int64_t sided = totals.buy_volume + totals.sell_volume;
+    out.imbalance = sided > 0 ? double(totals.buy_volume - totals.sell_volume) / double(sided) : 0.0;
+    out.last_price = flow.last_price;
+    return true;
+}
+
+void TradeFlowEngine::remove(SymbolId symbol_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flows_.erase(symbol_id);
+}
+
+void TradeFlowEngine::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flows_.clear();
+}
@@ -0,0 +1,240 @@
+#include "data/trading_calendar.h"
+#include "exchange/exchange_interface.h"
+#include "utils/exchange_time.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+int civilDate(int64_t days) {
+    int y = 0;
+    unsigned m = 0;
+    unsigned d = 0;
+    exchange_time::civilFromDays(days, y, m, d);
+    return y * 10000 + static_cast<int>(m) * 100 + static_cast<int>(d);
+}
+
+}  // namespace
+
+TradingCalendar& TradingCalendar::getInstance() {
+    static TradingCalendar instance;
+    return instance;
+}
+
+void TradingCalendar::setCacheDir(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_dir_ = dir;
+}
+
+bool TradingCalendar::load(const std::shared_ptr<IExchange>& exchange, int date) {
+    if (!exchange) {
+        return false;
+    }
+    const std::string market = calendarMarket(exchange->getMarket());
+    if (tradingSessions(market).empty()) {
+        return false;
+    }
+    const int year = date / 10000;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = years_.find(market);
+        if (it != years_.end()) {
+            auto year_it = it->second.find(year);
+            if (year_it != it->second.end() && year_it->second.last_date >= date) {
+                return true;
+            }
+        }
+        path = cachePath(market, year);
+    }
+
+    Year cached;
+    bool have_cache = !path.empty() && loadYear(path, market, cached);
+    if (have_cache && cached.last_date >= date) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        years_[market][year] = std::move(cached);
+        return true;
+    }
+
+    // Blocking exchange call, made without holding the lock
+    std::vector<TradeDay> days;
+    if (!exchange->getTradeDates(year * 10000 + 101, year * 10000 + 1231, days) || days.empty()) {
+        LOG_WARN("No " + market + " trading calendar for " + std::to_string(year) + " from " +
+                 exchange->getName() + ", trading Monday to Friday");
+        if (have_cache) {
+            // Still knows the holidays up to its last date
+            std::lock_guard<std::mutex> lock(mutex_);
+            years_[market][year] = std::move(cached);
+        }
+        return false;
+    }
+
+    // The answer covers the whole year: days after its last trading day are closed
+    Year fetched;
+    fetched.last_date = year * 10000 + 1231;
+    for (const auto& day : days) {
+        if (day.date / 10000 != year || day.type == TradeDayType::kClosed) continue;
+        fetched.days[day.date] = day.type;
+    }
+    if (!path.empty() && !saveYear(path, market, fetched)) {
+        LOG_WARN("Failed to save trading calendar to " + path);
+    }
+    LOG_INFO("Loaded " + std::to_string(fetched.days.size()) + " " + market + " trading days of " +
+             std::to_string(year) + " from " + exchange->getName());
+
+    const bool covered = fetched.last_date >= date;
+    std::lock_guard<std::mutex> lock(mutex_);
+    years_[market][year] = std::move(fetched);
+    return covered;
+}
+
+TradeDayType TradingCalendar::dayType(const std::string& market, int date) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dayTypeLocked(calendarMarket(market), date);
+}
+
+std::vector<SessionWindow> TradingCalendar::sessions(const std::string& market, int date) const {
+    return daySessions(market, dayType(market, date));
+}
+
+MarketPhase TradingCalendar::phase(const std::string& market, int64_t epoch_ns) const {
+    if (tradingSessions(market).empty()) {
+        return MarketPhase::kContinuous;
+    }
+    TradeDayType type = dayType(market, marketDate(market, epoch_ns));
+    return phaseAt(daySessions(market, type), dayAuctions(market, type), marketMinuteOfDay(market, epoch_ns));
+}
+
+int64_t TradingCalendar::untilPhaseChangeNs(const std::string& market, int64_t epoch_ns) const {
+    int64_t local_sec = floorDiv(epoch_ns, exchange_time::kNanosPerSecond) + marketUtcOffset(market, epoch_ns);
+    int64_t sec_of_day = local_sec - floorDiv(local_sec, exchange_time::kSecondsPerDay) * exchange_time::kSecondsPerDay;
+    int next_min = 24 * 60;
+    if (!tradingSessions(market).empty()) {
+        TradeDayType type = dayType(market, marketDate(market, epoch_ns));
+        next_min = nextPhaseChange(daySessions(market, type), dayAuctions(market, type),
+                                   static_cast<int>(sec_of_day / 60));
+    }
+    int64_t sub_second = epoch_ns - floorDiv(epoch_ns, exchange_time::kNanosPerSecond) * exchange_time::kNanosPerSecond;
+    return (int64_t(next_min) * 60 - sec_of_day) * exchange_time::kNanosPerSecond - sub_second;
+}
+
+int64_t TradingCalendar::sessionSeconds(const std::string& market, int64_t from_ns, int64_t to_ns) const {
+    if (to_ns <= from_ns) return 0;
+
+    int32_t utc_offset_sec = marketUtcOffset(market, to_ns);
+    int64_t from = floorDiv(from_ns, exchange_time::kNanosPerSecond) + utc_offset_sec;
+    int64_t to = floorDiv(to_ns, exchange_time::kNanosPerSecond) + utc_offset_sec;
+    if (tradingSessions(market).empty()) return to - from;
+
+    const std::string calendar_market = calendarMarket(market);
+    int64_t last_day = floorDiv(to - 1, exchange_time::kSecondsPerDay);
+    int64_t first_day = std::max(floorDiv(from, exchange_time::kSecondsPerDay), last_day - 31);   // anything longer is plenty
+    int64_t total = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int64_t day = first_day; day <= last_day; ++day) {
+        TradeDayType type = dayTypeLocked(calendar_market, civilDate(day));
+        if (type == TradeDayType::kClosed) continue;
+
+        int64_t midnight = day * exchange_time::kSecondsPerDay;
+        for (const auto& session : daySessions(market, type)) {
+            int64_t lo = std::max(from, midnight + int64_t(session.open_min) * 60);
+            int64_t hi = std::min(to, midnight + int64_t(session.close_min) * 60);
+            if (hi > lo) total += hi - lo;
+        }
+    }
+    return total;
+}
+
+std::string TradingCalendar::calendarMarket(const std::string& market) {
+    return (market == "SH" || market == "SZ") ? "CN" : market;
+}
+
+TradeDayType TradingCalendar::dayTypeLocked(const std::string& market, int date) const {
+    if (tradingSessions(market).empty()) {
+        return TradeDayType::kWhole;
+    }
+    auto it = years_.find(market);
+    if (it != years_.end()) {
+        auto year_it = it->second.find(date / 10000);
+        if (year_it != it->second.end() && date <= year_it->second.last_date) {
+            auto day_it = year_it->second.days.find(date);
+            return day_it != year_it->second.days.end() ? day_it->second : TradeDayType::kClosed;
+        }
+    }
+
+    int64_t days = exchange_time::daysFromCivil(date / 10000, static_cast<unsigned>(date / 100 % 100),
+                                                static_cast<unsigned>(date % 100));
+    int64_t weekday = ((days + 4) % 7 + 7) % 7;   // 1970-01-01 was a Thursday; 0 = Sunday
+    return (weekday == 0 || weekday == 6) ? TradeDayType::kClosed : TradeDayType::kWhole;
+}
+
+std::string TradingCalendar::cachePath(const std::string& market, int year) const {
+    if (cache_dir_.empty()) {
+        return "";
+    }
+    return (std::filesystem::path(cache_dir_) / (market + "_" + std::to_string(year) + ".txt")).string();
+}
+
+bool TradingCalendar::loadYear(const std::string& path, const std::string& market, Year& out) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    Year year;
+    std::string line;
+    bool header = false;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        if (!header) {
+            std::string file_market;
+            if (!(fields >> file_market >> year.last_date) || file_market != market) return false;
+            header = true;
+            continue;
+        }
+        int date = 0;
+        int type = 0;
+        if (!(fields >> date >> type) || type <= static_cast<int>(TradeDayType::kClosed) ||
+            type > static_cast<int>(TradeDayType::kAfternoon)) {
+            return false;
+        }
+        year.days[date] = static_cast<TradeDayType>(type);
+    }
+    if (!header) {
+        return false;
+    }
+    out = std::move(year);
+    return true;
+}
+
+bool TradingCalendar::saveYear(const std::string& path, const std::string& market, const Year& year) {
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out << "# trading days: date, then 1 whole day, 2 morning only, 3 afternoon only\n";
+        out << market << ' ' << year.last_date << '\n';
+        for (const auto& day : year.days) {
+            out << day.first << ' ' << static_cast<int>(day.second) << '\n';
+        }
+        if (!out) {
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
@@ -72,6 +72,12 @@ void ExchangeFactory::load_exchange_class_from_module(std::string module_name)
             auto pGetExchangeClass = lib->get_function<const char* ()>(ExchangeClass);
             std::string exchange_class = pGetExchangeClass();
 
+            // Share the host's symbol ids with the module (optional export)
+            if (lib->has_symbol(ExchangeBindSymbolRegistry)) {
+                auto pBindSymbolRegistry = lib->get_function<void (SymbolRegistry*)>(ExchangeBindSymbolRegistry);
+                pBindSymbolRegistry(&SymbolRegistry::getInstance());
+            }
+
             this->loaded_libraries_[exchange_class] = std::shared_ptr<dylib::library>(lib);
         }
     }
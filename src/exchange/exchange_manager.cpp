@@ -156,9 +156,9 @@ std::string ExchangeManager::placeOrder(
     const std::string& exchange_name,
     const std::string& symbol,
     const std::string& side,
-    int quantity,
+    Quantity quantity,
     const std::string& order_type,
-    double price) {
+    Price price) {
     
     auto exchange = getExchange(exchange_name);
     if (!exchange) {
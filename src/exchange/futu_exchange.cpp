@@ -2,9 +2,11 @@
 #include "event/event_interface.h"
 #include "event/event.h"
 #include "utils/logger_defines.h"
+#include "utils/log_throttle.h"
 #include <sstream>
 #include <chrono>
 #include <ctime>
+#include <cstdio>
 
 #ifdef ENABLE_FUTU
 #include "futu_spi.h"
@@ -115,7 +117,29 @@ bool FutuExchange::disconnect() {
 
 bool FutuExchange::isConnected() const {
     std::lock_guard<std::mutex> lock(mutex_);
+    #ifdef ENABLE_FUTU
+    // The market data connection may drop under us when OpenD restarts
+    return connected_ && spi_ != nullptr && spi_->IsQotConnected();
+    #else
     return connected_;
+    #endif
+}
+
+bool FutuExchange::reconnect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!connected_) {
+        return false;
+    }
+    
+    #ifdef ENABLE_FUTU
+    if (spi_ == nullptr || !spi_->Reconnect()) {
+        writeLog(LogLevel::Warn, "Reconnect to Futu API failed");
+        return false;
+    }
+    #endif
+    
+    return true;
 }
 
 // ========== Internal helper methods ==========
@@ -436,9 +460,9 @@ double FutuExchange::getAvailableFunds() {
 std::string FutuExchange::placeOrder(
     const std::string& symbol,
     const std::string& side,
-    int quantity,
+    Quantity quantity,
     const std::string& order_type,
-    double price) {
+    Price price) {
     
     if (!connected_) {
         writeLog(LogLevel::Error, "Not connected to exchange");
@@ -481,7 +505,7 @@ std::string FutuExchange::placeOrder(
         int order_type_val = Trd_Common::OrderType_Normal;
         if (order_type == "MARKET") {
             order_type_val = Trd_Common::OrderType_Market;
-            price = 0.0;  // Market orders do not need a price
+            price = Price();  // Market orders do not need a price
         }
         
         // Create security object
@@ -490,7 +514,7 @@ std::string FutuExchange::placeOrder(
         Futu::u32_t serial_no = spi_->SendPlaceOrder(acc_id,
             config_.is_simulation ? Trd_Common::TrdEnv_Simulate : Trd_Common::TrdEnv_Real,
             Trd_Common::TrdMarket_HK,
-            security, order_side, order_type_val, quantity, price);
+            security, order_side, order_type_val, quantity.value(), price.toDouble());
         if (serial_no == 0) {
             writeLog(LogLevel::Error, "Failed to send place order request");
             return order_id;
@@ -574,7 +598,7 @@ bool FutuExchange::cancelOrder(const std::string& order_id) {
     #endif
 }
 
-bool FutuExchange::modifyOrder(const std::string& order_id, int new_quantity, double new_price) {
+bool FutuExchange::modifyOrder(const std::string& order_id, Quantity new_quantity, Price new_price) {
     if (!connected_) {
         writeLog(LogLevel::Error, "Not connected to exchange");
         return false;
@@ -597,7 +621,7 @@ bool FutuExchange::modifyOrder(const std::string& order_id, int new_quantity, do
         
         Futu::u32_t serial_no = spi_->SendModifyOrder(acc_id,
             config_.is_simulation ? Trd_Common::TrdEnv_Simulate : Trd_Common::TrdEnv_Real,
-            order_id_num, new_quantity, new_price);
+            order_id_num, new_quantity.value(), new_price.toDouble());
         if (serial_no == 0) {
             writeLog(LogLevel::Error, "Failed to send modify order request");
             return false;
@@ -789,6 +813,223 @@ bool FutuExchange::unsubscribeTick(const std::string& symbol) {
     return true;
 }
 
+bool FutuExchange::updateSubscriptions(const std::vector<std::string>& symbols,
+                                      const std::string& data_type,
+                                      bool subscribe,
+                                      SubscriptionCallback on_complete) {
+    if (!connected_) {
+        return false;
+    }
+    if (symbols.empty()) {
+        if (on_complete) on_complete(true);
+        return true;
+    }
+    
+    #ifdef ENABLE_FUTU
+    if (spi_ == nullptr) {
+        writeLog(LogLevel::Error, "SPI not initialized");
+        return false;
+    }
+    
+    try {
+        std::vector<int> sub_types;
+        if (data_type == kTickDataType) {
+            sub_types.push_back(Qot_Common::SubType_Basic);
+            sub_types.push_back(Qot_Common::SubType_Ticker);
+        } else if (data_type == kDepthDataType) {
+            sub_types.push_back(Qot_Common::SubType_OrderBook);
+        } else {
+            int sub_type = FutuSpi::KLTypeToSubType(convertKLineType(data_type));
+            if (sub_type == 0) {
+                writeLog(LogLevel::Error, "Unsupported subscription data type: " + data_type);
+                return false;
+            }
+            sub_types.push_back(sub_type);
+        }
+        
+        std::vector<Qot_Common::Security> securities;
+        securities.reserve(symbols.size());
+        for (const auto& symbol : symbols) {
+            securities.push_back(convertToSecurity(symbol));
+        }
+        
+        return spi_->SendSubscription(securities, sub_types, subscribe, std::move(on_complete)) != 0;
+        
+    } catch (const std::exception& e) {
+        writeLog(LogLevel::Error, std::string("Exception during update subscriptions: ") + e.what());
+        return false;
+    }
+    #else
+    std::stringstream ss;
+    ss << (subscribe ? "Subscribed " : "Unsubscribed ") << data_type << " (simulation): "
+       << symbols.size() << " symbols";
+    writeLog(LogLevel::Info, ss.str());
+    if (on_complete) on_complete(true);
+    return true;
+    #endif
+}
+
+bool FutuExchange::getSubscriptionQuota(int& used, int& remaining) {
+    if (!connected_) {
+        return false;
+    }
+    
+    #ifdef ENABLE_FUTU
+    if (spi_ == nullptr) {
+        return false;
+    }
+    
+    Futu::u32_t serial_no = spi_->SendGetSubInfo();
+    if (serial_no == 0) {
+        return false;
+    }
+    if (!spi_->WaitForReply(serial_no, 5000)) {
+        writeLog(LogLevel::Error, "Get subscription quota timeout");
+        return false;
+    }
+    
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> lock(spi_->mutex_);
+        auto it = spi_->sub_info_responses_.find(serial_no);
+        if (it != spi_->sub_info_responses_.end()) {
+            const auto& rsp = it->second;
+            if (rsp.rettype() >= 0 && rsp.has_s2c()) {
+                used = rsp.s2c().totalusedquota();
+                remaining = rsp.s2c().remainquota();
+                ok = true;
+            }
+            spi_->sub_info_responses_.erase(it);
+        }
+    }
+    return ok;
+    #else
+    (void)used;
+    (void)remaining;
+    return false;
+    #endif
+}
+
+bool FutuExchange::getHistoryQuota(int& used, int& remaining) {
+    if (!connected_) {
+        return false;
+    }
+    
+    #ifdef ENABLE_FUTU
+    if (spi_ == nullptr) {
+        return false;
+    }
+    
+    Futu::u32_t serial_no = spi_->SendRequestHistoryKLQuota();
+    if (serial_no == 0) {
+        return false;
+    }
+    if (!spi_->WaitForReply(serial_no, 5000)) {
+        writeLog(LogLevel::Error, "Get history KLine quota timeout");
+        return false;
+    }
+    
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> lock(spi_->mutex_);
+        auto it = spi_->history_quota_responses_.find(serial_no);
+        if (it != spi_->history_quota_responses_.end()) {
+            const auto& rsp = it->second;
+            if (rsp.rettype() >= 0 && rsp.has_s2c()) {
+                used = rsp.s2c().usedquota();
+                remaining = rsp.s2c().remainquota();
+                ok = true;
+            }
+            spi_->history_quota_responses_.erase(it);
+        }
+    }
+    return ok;
+    #else
+    (void)used;
+    (void)remaining;
+    return false;
+    #endif
+}
+
+bool FutuExchange::getTradeDates(int begin_date, int end_date, std::vector<TradeDay>& days) {
+    if (!connected_) {
+        return false;
+    }
+    
+    #ifdef ENABLE_FUTU
+    if (spi_ == nullptr) {
+        return false;
+    }
+    
+    int32_t market_type = 0;
+    if (config_.market == "HK") {
+        market_type = Qot_Common::TradeDateMarket_HK;
+    } else if (config_.market == "US") {
+        market_type = Qot_Common::TradeDateMarket_US;
+    } else if (config_.market == "SH" || config_.market == "SZ" || config_.market == "CN") {
+        market_type = Qot_Common::TradeDateMarket_CN;
+    } else {
+        return false;
+    }
+    
+    auto toTime = [](int date) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d", date / 10000, date / 100 % 100, date % 100);
+        return std::string(buf);
+    };
+    Futu::u32_t serial_no = spi_->SendRequestTradeDate(market_type, toTime(begin_date), toTime(end_date));
+    if (serial_no == 0) {
+        return false;
+    }
+    if (!spi_->WaitForReply(serial_no, 5000)) {
+        writeLog(LogLevel::Error, "Request trade dates timeout");
+        return false;
+    }
+    
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> lock(spi_->mutex_);
+        auto it = spi_->trade_date_responses_.find(serial_no);
+        if (it != spi_->trade_date_responses_.end()) {
+            const auto& rsp = it->second;
+            if (rsp.rettype() >= 0 && rsp.has_s2c()) {
+                days.clear();
+                for (int i = 0; i < rsp.s2c().tradedatelist_size(); ++i) {
+                    const auto& trade_date = rsp.s2c().tradedatelist(i);
+                    int y = 0, m = 0, d = 0;
+                    if (std::sscanf(trade_date.time().c_str(), "%d-%d-%d", &y, &m, &d) != 3) continue;
+                    TradeDay day;
+                    day.date = y * 10000 + m * 100 + d;
+                    if (trade_date.has_tradedatetype()) {
+                        if (trade_date.tradedatetype() == Qot_Common::TradeDateType_Morning) {
+                            day.type = TradeDayType::kMorning;
+                        } else if (trade_date.tradedatetype() == Qot_Common::TradeDateType_Afternoon) {
+                            day.type = TradeDayType::kAfternoon;
+                        }
+                    }
+                    days.push_back(day);
+                }
+                ok = true;
+            } else {
+                writeLog(LogLevel::Error, std::string("Request trade dates failed: ") + rsp.retmsg());
+            }
+            spi_->trade_date_responses_.erase(it);
+        }
+    }
+    return ok;
+    #else
+    (void)begin_date;
+    (void)end_date;
+    (void)days;
+    return false;
+    #endif
+}
+
+int FutuExchange::getSubscriptionCost(const std::string& data_type) const {
+    // Each (security, SubType) pair takes one unit; ticks use Basic + Ticker
+    return data_type == kTickDataType ? 2 : 1;
+}
+
 std::vector<KlineData> FutuExchange::getHistoryKLine(
     const std::string& symbol,
     const std::string& kline_type,
@@ -832,6 +1073,9 @@ std::vector<KlineData> FutuExchange::getHistoryKLine(
                 if (rsp.rettype() >= 0 && rsp.has_s2c()) {
                     const auto& s2c = rsp.s2c();
                     int kl_count = s2c.kllist_size();
+                    SymbolId symbol_id = SymbolRegistry::getInstance().intern(getName(), symbol);
+                    const auto& time_zone = FutuMarketTimeZone(security.market());
+                    int64_t received_ns = exchange_time::nowNs();
                     
                     for (int i = 0; i < kl_count; ++i) {
                         const auto& kl = s2c.kllist(i);
@@ -839,7 +1083,9 @@ std::vector<KlineData> FutuExchange::getHistoryKLine(
                         KlineData kline;
                         kline.symbol = symbol;
                         kline.exchange = getName();
-                        kline.datetime = kl.time();
+                        kline.symbol_id = symbol_id;
+                        kline.local_ts_ns = received_ns;
+                        kline.exchange_ts_ns = exchange_time::parse(kl.time(), time_zone, &kline.utc_offset_sec);
                         kline.interval = kline_type;
                         kline.open_price = kl.openprice();
                         kline.high_price = kl.highprice();
@@ -860,7 +1106,8 @@ std::vector<KlineData> FutuExchange::getHistoryKLine(
     }
     #endif
     
-    writeLog(LogLevel::Info, std::string("Got ") + std::to_string(klines.size()) + " history KLines");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 20, 60000,
+                      std::string("Got ") + std::to_string(klines.size()) + " history KLines for " + symbol);
     return klines;
 }
 
@@ -909,7 +1156,11 @@ Snapshot FutuExchange::getSnapshot(const std::string& symbol) {
                         snapshot.symbol = symbol;
                         snapshot.name = basic.name();
                         snapshot.exchange = getName();
-                        snapshot.timestamp = std::chrono::system_clock::now().time_since_epoch().count() / 1000000;
+                        snapshot.symbol_id = SymbolRegistry::getInstance().intern(snapshot.exchange, snapshot.symbol);
+                        snapshot.local_ts_ns = exchange_time::nowNs();
+                        snapshot.exchange_ts_ns = exchange_time::parse(basic.updatetime(),
+                                                                       FutuMarketTimeZone(basic.security().market()),
+                                                                       &snapshot.utc_offset_sec);
                         snapshot.last_price = basic.curprice();
                         snapshot.open_price = basic.openprice();
                         snapshot.high_price = basic.highprice();
@@ -924,6 +1175,7 @@ Snapshot FutuExchange::getSnapshot(const std::string& symbol) {
                         snapshot.bid_price_1 = basic.has_bidprice() ? basic.bidprice() : 0.0;
                         snapshot.ask_volume_1 = basic.has_askvol() ? basic.askvol() : 0.0;
                         snapshot.bid_volume_1 = basic.has_bidvol() ? basic.bidvol() : 0.0;
+                        snapshot.tick_size = basic.pricespread();
                     }
                 }
                 spi_->snapshot_responses_.erase(it);
@@ -1075,39 +1327,7 @@ std::map<std::string, Snapshot> FutuExchange::getBatchSnapshots(
             std::lock_guard<std::mutex> lock(spi_->mutex_);
             auto it = spi_->snapshot_responses_.find(serial_no);
             if (it != spi_->snapshot_responses_.end()) {
-                const auto& rsp = it->second;
-                if (rsp.rettype() >= 0 && rsp.has_s2c()) {
-                    const auto& s2c = rsp.s2c();
-                    int snap_count = s2c.snapshotlist_size();
-                    
-                    for (int i = 0; i < snap_count; ++i) {
-                        const auto& snap = s2c.snapshotlist(i);
-                        const auto& basic = snap.basic();
-                        const auto& sec = basic.security();
-                        
-                        Snapshot snapshot;
-                        snapshot.symbol = sec.code();
-                        snapshot.name = basic.name();
-                        snapshot.exchange = getName();
-                        snapshot.timestamp = std::chrono::system_clock::now().time_since_epoch().count() / 1000000;
-                        snapshot.last_price = basic.curprice();
-                        snapshot.open_price = basic.openprice();
-                        snapshot.high_price = basic.highprice();
-                        snapshot.low_price = basic.lowprice();
-                        snapshot.pre_close = basic.lastcloseprice();
-                        snapshot.volume = basic.volume();
-                        snapshot.turnover = basic.turnover();
-                        snapshot.turnover_rate = basic.turnoverrate();
-                        snapshot.price_change = basic.has_amplitude() ? basic.amplitude() : 0.0;
-                        snapshot.price_change_abs = 0.0;  // Futu API does not provide absolute change value
-                        snapshot.ask_price_1 = basic.has_askprice() ? basic.askprice() : 0.0;
-                        snapshot.bid_price_1 = basic.has_bidprice() ? basic.bidprice() : 0.0;
-                        snapshot.ask_volume_1 = basic.has_askvol() ? basic.askvol() : 0.0;
-                        snapshot.bid_volume_1 = basic.has_bidvol() ? basic.bidvol() : 0.0;
-
-                        snapshots[sec.code()] = snapshot;
-                    }
-                }
+                snapshots = convertSnapshots(it->second);
                 spi_->snapshot_responses_.erase(it);
             }
         }
@@ -1117,9 +1337,103 @@ std::map<std::string, Snapshot> FutuExchange::getBatchSnapshots(
     }
     #endif
     
-    writeLog(LogLevel::Info, std::string("Got ") + std::to_string(snapshots.size()) + " snapshots");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 10, 60000,
+                      std::string("Got ") + std::to_string(snapshots.size()) + " snapshots");
+    return snapshots;
+}
+
+bool FutuExchange::requestBatchSnapshots(const std::vector<std::string>& stock_codes,
+                                         SnapshotBatchCallback on_complete) {
+    if (!connected_) {
+        writeLog(LogLevel::Error, "Not connected to exchange");
+        return false;
+    }
+    
+    #ifdef ENABLE_FUTU
+    if (spi_ == nullptr) {
+        writeLog(LogLevel::Error, "SPI not initialized");
+        return false;
+    }
+    
+    try {
+        std::vector<Qot_Common::Security> securities;
+        for (const auto& code : stock_codes) {
+            securities.push_back(convertToSecurity(code));
+        }
+        
+        // The reply is converted on the API thread and handed straight over
+        Futu::u32_t serial_no = spi_->SendGetSecuritySnapshot(securities,
+            [this, on_complete](const Qot_GetSecuritySnapshot::Response* rsp) {
+                if (rsp == nullptr) {
+                    if (on_complete) on_complete(false, {});
+                    return;
+                }
+                bool success = rsp->rettype() >= 0;
+                if (!success) {
+                    writeLog(LogLevel::Error, std::string("Batch get snapshot failed: ") + rsp->retmsg());
+                }
+                if (on_complete) on_complete(success, convertSnapshots(*rsp));
+            });
+        if (serial_no == 0) {
+            writeLog(LogLevel::Error, "Failed to send batch get snapshot request");
+            return false;
+        }
+        return true;
+        
+    } catch (const std::exception& e) {
+        writeLog(LogLevel::Error, std::string("Exception during batch request snapshots: ") + e.what());
+        return false;
+    }
+    #else
+    return IExchange::requestBatchSnapshots(stock_codes, std::move(on_complete));
+    #endif
+}
+
+#ifdef ENABLE_FUTU
+std::map<std::string, Snapshot> FutuExchange::convertSnapshots(const Qot_GetSecuritySnapshot::Response& rsp) {
+    std::map<std::string, Snapshot> snapshots;
+    if (rsp.rettype() < 0 || !rsp.has_s2c()) {
+        return snapshots;
+    }
+    
+    const auto& s2c = rsp.s2c();
+    int snap_count = s2c.snapshotlist_size();
+    
+    for (int i = 0; i < snap_count; ++i) {
+        const auto& snap = s2c.snapshotlist(i);
+        const auto& basic = snap.basic();
+        const auto& sec = basic.security();
+        
+        Snapshot snapshot;
+        snapshot.symbol = sec.code();
+        snapshot.name = basic.name();
+        snapshot.exchange = getName();
+        snapshot.symbol_id = SymbolRegistry::getInstance().intern(snapshot.exchange, snapshot.symbol);
+        snapshot.local_ts_ns = exchange_time::nowNs();
+        snapshot.exchange_ts_ns = exchange_time::parse(basic.updatetime(),
+                                                       FutuMarketTimeZone(basic.security().market()),
+                                                       &snapshot.utc_offset_sec);
+        snapshot.last_price = basic.curprice();
+        snapshot.open_price = basic.openprice();
+        snapshot.high_price = basic.highprice();
+        snapshot.low_price = basic.lowprice();
+        snapshot.pre_close = basic.lastcloseprice();
+        snapshot.volume = basic.volume();
+        snapshot.turnover = basic.turnover();
+        snapshot.turnover_rate = basic.turnoverrate();
+        snapshot.price_change = basic.has_amplitude() ? basic.amplitude() : 0.0;
+        snapshot.price_change_abs = 0.0;  // Futu API does not provide absolute change value
+        snapshot.ask_price_1 = basic.has_askprice() ? basic.askprice() : 0.0;
+        snapshot.bid_price_1 = basic.has_bidprice() ? basic.bidprice() : 0.0;
+        snapshot.ask_volume_1 = basic.has_askvol() ? basic.askvol() : 0.0;
+        snapshot.bid_volume_1 = basic.has_bidvol() ? basic.bidvol() : 0.0;
+        snapshot.tick_size = basic.pricespread();
+
+        snapshots[sec.code()] = snapshot;
+    }
     return snapshots;
 }
+#endif
 
 
 // ========== Event engine ==========
@@ -1160,6 +1474,10 @@ const char* GetExchangeClass() {
     return CLASS_NAME;
 }
 
+void BindSymbolRegistry(SymbolRegistry* registry) {
+    SymbolRegistry::bind(registry);
+}
+
 IExchange* GetExchangeInstance(IEventEngine* event_engine, const std::map<std::string, std::string>& config) {
 
     FutuConfig futu_config;
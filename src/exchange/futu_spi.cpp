@@ -4,6 +4,7 @@
 #include "event/event_interface.h"
 #include "event/event.h"
 #include "exchange/futu_exchange.h"
+#include "utils/log_throttle.h"
 #include <chrono>
 
 FutuSpi::FutuSpi(FutuExchange* exchange) : exchange_(exchange) {
@@ -178,6 +179,51 @@ bool FutuSpi::IsConnected() const {
     return api_initialized_ && qot_api_ != nullptr && trd_api_ != nullptr;
 }
 
+bool FutuSpi::IsQotConnected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return api_initialized_ && is_qot_connected_;
+}
+
+bool FutuSpi::Reconnect() {
+    std::string host;
+    int port = 0;
+    bool qot_down = false;
+    bool trd_down = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!api_initialized_) {
+            return false;
+        }
+        host = host_;
+        port = port_;
+        qot_down = !is_qot_connected_;
+        trd_down = !is_trd_connected_;
+        reply_flags_.erase(0);
+    }
+
+    try {
+        if (qot_down) {
+            qot_api_->Close();
+            qot_api_->InitConnect(host.c_str(), port, false);
+            WaitForReply(0, 5000);
+        }
+        if (trd_down) {
+            trd_api_->Close();
+            trd_api_->InitConnect(host.c_str(), port, false);
+            WaitForReply(0, 5000);
+        }
+    } catch (const std::exception& e) {
+        writeLog(LogLevel::Error, std::string("Exception during FTAPI reconnect: ") + e.what());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_qot_connected_ && is_trd_connected_) {
+        writeLog(LogLevel::Info, "FTAPI reconnected");
+    }
+    return is_qot_connected_ && is_trd_connected_;
+}
+
 // ========== Trade request helper methods ==========
 
 Futu::u32_t FutuSpi::SendUnlockTrade(const std::string& password) {
@@ -444,8 +490,7 @@ Futu::u32_t FutuSpi::SendSubscribeKLine(const Qot_Common::Security& security, in
         *security_item = security;
         
         // Add subscription type - KLine
-        // Use integer values like 1,2,3... or refer to Qot_Common for specific values
-        c2s->add_subtypelist(1 + kline_type);  // SubType_K_1Min = 1, 1Min=0, 3Min=1 etc.
+        c2s->add_subtypelist(KLTypeToSubType(kline_type));
         
         // Set as subscription
         c2s->set_issuborunsub(true);
@@ -549,7 +594,8 @@ Futu::u32_t FutuSpi::SendGetHistoryKLine(const Qot_Common::Security& security, i
             return 0;
         }
         
-        writeLog(LogLevel::Info, std::string("Sent request history KLine, serial_no=") + std::to_string(serial_no));
+        QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 10, 60000,
+                          std::string("Sent request history KLine, serial_no=") + std::to_string(serial_no));
         return serial_no;
         
     } catch (const std::exception& e) {
@@ -558,7 +604,8 @@ Futu::u32_t FutuSpi::SendGetHistoryKLine(const Qot_Common::Security& security, i
     }
 }
 
-Futu::u32_t FutuSpi::SendGetSecuritySnapshot(const std::vector<Qot_Common::Security>& securities) {
+Futu::u32_t FutuSpi::SendGetSecuritySnapshot(const std::vector<Qot_Common::Security>& securities,
+                                             std::function<void(const Qot_GetSecuritySnapshot::Response*)> on_reply) {
     if (qot_api_ == nullptr) {
         writeLog(LogLevel::Error, "Qot API not initialized");
         return 0;
@@ -573,13 +620,19 @@ Futu::u32_t FutuSpi::SendGetSecuritySnapshot(const std::vector<Qot_Common::Secur
             *sec = security;
         }
         
+        // Register the callback before the reply can arrive on the API thread
+        std::lock_guard<std::mutex> lock(mutex_);
         Futu::u32_t serial_no = qot_api_->GetSecuritySnapshot(req);
         if (serial_no == 0) {
             writeLog(LogLevel::Error, "Failed to send get security snapshot request");
             return 0;
         }
+        if (on_reply) {
+            snapshot_callbacks_[serial_no] = std::move(on_reply);
+        }
         
-        writeLog(LogLevel::Info, std::string("Sent get security snapshot request, serial_no=") + std::to_string(serial_no));
+        QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 10, 60000,
+                          std::string("Sent get security snapshot request, serial_no=") + std::to_string(serial_no));
         return serial_no;
         
     } catch (const std::exception& e) {
@@ -716,6 +769,137 @@ Futu::u32_t FutuSpi::SendUnsubscribeKLine(const Qot_Common::Security& security)
     }
 }
 
+Futu::u32_t FutuSpi::SendSubscription(const std::vector<Qot_Common::Security>& securities,
+                                      const std::vector<int>& sub_types, bool subscribe,
+                                      std::function<void(bool)> on_complete) {
+    if (qot_api_ == nullptr) {
+        writeLog(LogLevel::Error, "Qot API not initialized");
+        return 0;
+    }
+    
+    try {
+        Qot_Sub::Request req;
+        auto* c2s = req.mutable_c2s();
+        
+        for (const auto& security : securities) {
+            *c2s->add_securitylist() = security;
+        }
+        for (int sub_type : sub_types) {
+            c2s->add_subtypelist(sub_type);
+        }
+        
+        c2s->set_issuborunsub(subscribe);
+        c2s->set_isregorunregpush(subscribe);
+        
+        // Register the callback before the reply can arrive on the API thread
+        std::lock_guard<std::mutex> lock(mutex_);
+        Futu::u32_t serial_no = qot_api_->Sub(req);
+        if (serial_no == 0) {
+            writeLog(LogLevel::Error, "Failed to send subscription request");
+            return 0;
+        }
+        if (on_complete) {
+            sub_callbacks_[serial_no] = std::move(on_complete);
+        }
+        
+        QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 10, 60000,
+                          std::string(subscribe ? "Sent subscribe" : "Sent unsubscribe") + " request for " +
+                          std::to_string(securities.size()) + " securities, serial_no=" + std::to_string(serial_no));
+        return serial_no;
+        
+    } catch (const std::exception& e) {
+        writeLog(LogLevel::Error, std::string("Exception during send subscription: ") + e.what());
+        return 0;
+    }
+}
+
+Futu::u32_t FutuSpi::SendRequestHistoryKLQuota() {
+    if (qot_api_ == nullptr) {
+        writeLog(LogLevel::Error, "Qot API not initialized");
+        return 0;
+    }
+    
+    try {
+        Qot_RequestHistoryKLQuota::Request req;
+        req.mutable_c2s()->set_bgetdetail(false);
+        
+        Futu::u32_t serial_no = qot_api_->RequestHistoryKLQuota(req);
+        if (serial_no == 0) {
+            writeLog(LogLevel::Error, "Failed to send history KLine quota request");
+            return 0;
+        }
+        return serial_no;
+        
+    } catch (const std::exception& e) {
+        writeLog(LogLevel::Error, std::string("Exception during send history KLine quota: ") + e.what());
+        return 0;
+    }
+}
+
+Futu::u32_t FutuSpi::SendRequestTradeDate(int market, const std::string& begin_time, const std::string& end_time) {
+    if (qot_api_ == nullptr) {
+        writeLog(LogLevel::Error, "Qot API not initialized");
+        return 0;
+    }
+    
+    try {
+        Qot_RequestTradeDate::Request req;
+        auto* c2s = req.mutable_c2s();
+        c2s->set_market(market);
+        c2s->set_begintime(begin_time);
+        c2s->set_endtime(end_time);
+        
+        Futu::u32_t serial_no = qot_api_->RequestTradeDate(req);
+        if (serial_no == 0) {
+            writeLog(LogLevel::Error, "Failed to send trade date request");
+            return 0;
+        }
+        return serial_no;
+        
+    } catch (const std::exception& e) {
+        writeLog(LogLevel::Error, std::string("Exception during send trade date request: ") + e.what());
+        return 0;
+    }
+}
+
+Futu::u32_t FutuSpi::SendGetSubInfo() {
+    if (qot_api_ == nullptr) {
+        writeLog(LogLevel::Error, "Qot API not initialized");
+        return 0;
+    }
+    
+    try {
+        Qot_GetSubInfo::Request req;
+        req.mutable_c2s()->set_isreqallconn(false);
+        
+        Futu::u32_t serial_no = qot_api_->GetSubInfo(req);
+        if (serial_no == 0) {
+            writeLog(LogLevel::Error, "Failed to send get sub info request");
+            return 0;
+        }
+        return serial_no;
+        
+    } catch (const std::exception& e) {
+        writeLog(LogLevel::Error, std::string("Exception during send get sub info: ") + e.what());
+        return 0;
+    }
+}
+
+int FutuSpi::KLTypeToSubType(int kl_type) {
+    switch (kl_type) {
+        case Qot_Common::KLType_1Min:  return Qot_Common::SubType_KL_1Min;
+        case Qot_Common::KLType_3Min:  return Qot_Common::SubType_KL_3Min;
+        case Qot_Common::KLType_5Min:  return Qot_Common::SubType_KL_5Min;
+        case Qot_Common::KLType_15Min: return Qot_Common::SubType_KL_15Min;
+        case Qot_Common::KLType_30Min: return Qot_Common::SubType_KL_30Min;
+        case Qot_Common::KLType_60Min: return Qot_Common::SubType_KL_60Min;
+        case Qot_Common::KLType_Day:   return Qot_Common::SubType_KL_Day;
+        case Qot_Common::KLType_Week:  return Qot_Common::SubType_KL_Week;
+        case Qot_Common::KLType_Month: return Qot_Common::SubType_KL_Month;
+        default:                       return 0;
+    }
+}
+
 // ========== FTSPI_Conn callbacks ==========
 
 void FutuSpi::OnInitConnect(Futu::FTAPI_Conn* pConn, Futu::i64_t nErrCode, const char* strDesc) {
@@ -736,6 +920,26 @@ void FutuSpi::OnInitConnect(Futu::FTAPI_Conn* pConn, Futu::i64_t nErrCode, const
 
 void FutuSpi::OnDisConnect(Futu::FTAPI_Conn* pConn, Futu::i64_t nErrCode) {
     writeLog(LogLevel::Warn, std::string("FTAPI disconnected: code=") + std::to_string(nErrCode));
+
+    // Subscribe and snapshot replies will not arrive on a dropped connection
+    std::map<Futu::u32_t, std::function<void(bool)>> orphaned;
+    std::map<Futu::u32_t, std::function<void(const Qot_GetSecuritySnapshot::Response*)>> orphaned_snapshots;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pConn == qot_api_) {
+            is_qot_connected_ = false;
+            orphaned.swap(sub_callbacks_);
+            orphaned_snapshots.swap(snapshot_callbacks_);
+        } else if (pConn == trd_api_) {
+            is_trd_connected_ = false;
+        }
+    }
+    for (auto& pair : orphaned) {
+        pair.second(false);
+    }
+    for (auto& pair : orphaned_snapshots) {
+        pair.second(nullptr);
+    }
 }
 
 // ========== FTSPI_Qot callbacks ==========
@@ -746,12 +950,29 @@ void FutuSpi::OnReply_GetGlobalState(Futu::u32_t nSerialNo, const GetGlobalState
 }
 
 void FutuSpi::OnReply_Sub(Futu::u32_t nSerialNo, const Qot_Sub::Response &stRsp) {
-    if (stRsp.rettype() >= 0) {
-        writeLog(LogLevel::Info, "Subscribe successful");
+    bool success = stRsp.rettype() >= 0;
+    if (success) {
+        QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 10, 60000, "Subscribe successful");
     } else {
         writeLog(LogLevel::Error, std::string("Subscribe failed: ") + stRsp.retmsg());
     }
-    NotifyReply(nSerialNo);
+    
+    std::function<void(bool)> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sub_callbacks_.find(nSerialNo);
+        if (it != sub_callbacks_.end()) {
+            callback = std::move(it->second);
+            sub_callbacks_.erase(it);
+        }
+    }
+    
+    // Asynchronous requests have no waiter
+    if (callback) {
+        callback(success);
+    } else {
+        NotifyReply(nSerialNo);
+    }
 }
 
 void FutuSpi::OnReply_RegQotPush(Futu::u32_t nSerialNo, const Qot_RegQotPush::Response &stRsp) {
@@ -760,7 +981,10 @@ void FutuSpi::OnReply_RegQotPush(Futu::u32_t nSerialNo, const Qot_RegQotPush::Re
 }
 
 void FutuSpi::OnReply_GetSubInfo(Futu::u32_t nSerialNo, const Qot_GetSubInfo::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnReply_GetSubInfo");
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sub_info_responses_[nSerialNo] = stRsp;
+    }
     NotifyReply(nSerialNo);
 }
 
@@ -808,12 +1032,15 @@ void FutuSpi::OnReply_RequestHistoryKL(Futu::u32_t nSerialNo, const Qot_RequestH
         std::lock_guard<std::mutex> lock(mutex_);
         history_kline_responses_[nSerialNo] = stRsp;
     }
-    writeLog(LogLevel::Info, "OnReply_RequestHistoryKL");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 10, 60000, "OnReply_RequestHistoryKL");
     NotifyReply(nSerialNo);
 }
 
 void FutuSpi::OnReply_RequestHistoryKLQuota(Futu::u32_t nSerialNo, const Qot_RequestHistoryKLQuota::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnReply_RequestHistoryKLQuota");
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        history_quota_responses_[nSerialNo] = stRsp;
+    }
     NotifyReply(nSerialNo);
 }
 
@@ -832,12 +1059,25 @@ void FutuSpi::OnReply_GetStaticInfo(Futu::u32_t nSerialNo, const Qot_GetStaticIn
 }
 
 void FutuSpi::OnReply_GetSecuritySnapshot(Futu::u32_t nSerialNo, const Qot_GetSecuritySnapshot::Response &stRsp) {
+    std::function<void(const Qot_GetSecuritySnapshot::Response*)> callback;
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        snapshot_responses_[nSerialNo] = stRsp;
+        auto it = snapshot_callbacks_.find(nSerialNo);
+        if (it != snapshot_callbacks_.end()) {
+            callback = std::move(it->second);
+            snapshot_callbacks_.erase(it);
+        } else {
+            snapshot_responses_[nSerialNo] = stRsp;
+        }
+    }
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 10, 60000, "OnReply_GetSecuritySnapshot");
+    
+    // Asynchronous requests have no waiter
+    if (callback) {
+        callback(&stRsp);
+    } else {
+        NotifyReply(nSerialNo);
     }
-    writeLog(LogLevel::Info, "OnReply_GetSecuritySnapshot");
-    NotifyReply(nSerialNo);
 }
 
 void FutuSpi::OnReply_GetPlateSet(Futu::u32_t nSerialNo, const Qot_GetPlateSet::Response &stRsp) {
@@ -920,7 +1160,10 @@ void FutuSpi::OnReply_GetFutureInfo(Futu::u32_t nSerialNo, const Qot_GetFutureIn
 }
 
 void FutuSpi::OnReply_RequestTradeDate(Futu::u32_t nSerialNo, const Qot_RequestTradeDate::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnReply_RequestTradeDate");
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        trade_date_responses_[nSerialNo] = stRsp;
+    }
     NotifyReply(nSerialNo);
 }
 
@@ -955,7 +1198,7 @@ void FutuSpi::OnPush_Notify(const Notify::Response &stRsp) {
 }
 
 void FutuSpi::OnPush_UpdateBasicQot(const Qot_UpdateBasicQot::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnPush_UpdateBasicQot");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 5, 10000, "OnPush_UpdateBasicQot");
     
     try {
         if (stRsp.rettype() != 0) {
@@ -1000,8 +1243,10 @@ void FutuSpi::OnPush_UpdateBasicQot(const Qot_UpdateBasicQot::Response &stRsp) {
             TickData tick_data;
             tick_data.symbol = symbol;
             tick_data.exchange = exchange_->getName();
-            tick_data.timestamp = std::chrono::system_clock::now().time_since_epoch().count() / 1000000;
-            tick_data.datetime = basic.updatetime();
+            tick_data.symbol_id = SymbolRegistry::getInstance().intern(tick_data.exchange, symbol);
+            tick_data.local_ts_ns = exchange_time::nowNs();
+            tick_data.exchange_ts_ns = exchange_time::parse(basic.updatetime(), FutuMarketTimeZone(security.market()),
+                                                            &tick_data.utc_offset_sec);
             
             // Extract price data from basic
             tick_data.last_price = basic.curprice();
@@ -1020,7 +1265,8 @@ void FutuSpi::OnPush_UpdateBasicQot(const Qot_UpdateBasicQot::Response &stRsp) {
             event->setData(tick_data);
             event_engine->putEvent(event);
             
-            writeLog(LogLevel::Info, std::string("Published TICK event (BasicQot): ") + symbol + " price=" + std::to_string(tick_data.last_price));
+            QTS_LOG_SAMPLED(writeLog, LogLevel::Info, 200,
+                            std::string("Published TICK event (BasicQot): ") + symbol + " price=" + std::to_string(tick_data.last_price));
         }
         
     } catch (const std::exception& e) {
@@ -1029,11 +1275,69 @@ void FutuSpi::OnPush_UpdateBasicQot(const Qot_UpdateBasicQot::Response &stRsp) {
 }
 
 void FutuSpi::OnPush_UpdateOrderBook(const Qot_UpdateOrderBook::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnPush_UpdateOrderBook");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 5, 10000, "OnPush_UpdateOrderBook");
+    
+    try {
+        if (stRsp.rettype() != 0) {
+            writeLog(LogLevel::Warn, std::string("OnPush_UpdateOrderBook failed: ") + stRsp.retmsg());
+            return;
+        }
+        
+        if (!stRsp.has_s2c()) {
+            writeLog(LogLevel::Warn, "OnPush_UpdateOrderBook: no s2c data");
+            return;
+        }
+        
+        // Check exchange_ and event_engine_ validity
+        if (exchange_ == nullptr) {
+            writeLog(LogLevel::Error, "OnPush_UpdateOrderBook: exchange is null");
+            return;
+        }
+        
+        IEventEngine* event_engine = exchange_->getEventEngine();
+        if (event_engine == nullptr) {
+            writeLog(LogLevel::Warn, "OnPush_UpdateOrderBook: event engine not set");
+            return;
+        }
+        
+        const auto& s2c = stRsp.s2c();
+        const auto& security = s2c.security();
+        
+        // Each push carries the whole visible book, best level first
+        DepthData depth;
+        depth.symbol = security.code();
+        depth.exchange = exchange_->getName();
+        depth.symbol_id = SymbolRegistry::getInstance().intern(depth.exchange, depth.symbol);
+        depth.local_ts_ns = exchange_time::nowNs();
+        depth.exchange_ts_ns = depth.local_ts_ns;
+        depth.utc_offset_sec = exchange_time::utcOffset(depth.local_ts_ns, FutuMarketTimeZone(security.market()));
+        if (s2c.has_svrrecvtimebidtimestamp()) {
+            depth.exchange_ts_ns = static_cast<int64_t>(s2c.svrrecvtimebidtimestamp() * 1e9);
+        }
+        
+        int bid_levels = std::min<int>(s2c.orderbookbidlist_size(), DepthBook::kMaxDepth);
+        for (int i = 0; i < bid_levels; ++i) {
+            const auto& level = s2c.orderbookbidlist(i);
+            depth.book.setBid(i, level.price(), level.volume());
+        }
+        int ask_levels = std::min<int>(s2c.orderbookasklist_size(), DepthBook::kMaxDepth);
+        for (int i = 0; i < ask_levels; ++i) {
+            const auto& level = s2c.orderbookasklist(i);
+            depth.book.setAsk(i, level.price(), level.volume());
+        }
+        
+        // Publish Depth event
+        auto event = std::make_shared<Event>(EventType::EVENT_DEPTH);
+        event->setData(depth);
+        event_engine->putEvent(event);
+        
+    } catch (const std::exception& e) {
+        writeLog(LogLevel::Error, std::string("Exception in OnPush_UpdateOrderBook: ") + e.what());
+    }
 }
 
 void FutuSpi::OnPush_UpdateTicker(const Qot_UpdateTicker::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnPush_UpdateTicker");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 5, 10000, "OnPush_UpdateTicker");
     
     try {
         if (stRsp.rettype() != 0) {
@@ -1073,28 +1377,44 @@ void FutuSpi::OnPush_UpdateTicker(const Qot_UpdateTicker::Response &stRsp) {
         const auto& security = s2c.security();
         std::string symbol = security.code();
         
+        const std::string exchange_name = exchange_->getName();
+        SymbolId symbol_id = SymbolRegistry::getInstance().intern(exchange_name, symbol);
+        const auto& time_zone = FutuMarketTimeZone(security.market());
+        int64_t received_ns = exchange_time::nowNs();
+        
         // Process each ticker data
         for (int i = 0; i < s2c.tickerlist_size(); ++i) {
             const auto& ticker = s2c.tickerlist(i);
             
-            // Construct TickData object
-            TickData tick_data;
-            tick_data.symbol = symbol;
-            tick_data.exchange = exchange_->getName();
-            tick_data.timestamp = std::chrono::system_clock::now().time_since_epoch().count() / 1000000;
-            tick_data.datetime = ticker.time();
+            // Construct TradePrint object
+            TradePrint trade;
+            trade.symbol = symbol;
+            trade.exchange = exchange_name;
+            trade.symbol_id = symbol_id;
+            trade.local_ts_ns = received_ns;
+            trade.exchange_ts_ns = exchange_time::parse(ticker.time(), time_zone, &trade.utc_offset_sec);
             
             // Extract trade data from ticker
-            tick_data.last_price = ticker.price();           // trade price
-            tick_data.volume = ticker.volume();              // volume
-            tick_data.turnover = ticker.turnover();          // turnover
+            trade.price = ticker.price();
+            trade.volume = ticker.volume();
+            trade.turnover = ticker.turnover();
+            trade.sequence = ticker.sequence();
             
-            // Publish Tick event
-            auto event = std::make_shared<Event>(EventType::EVENT_TICK);
-            event->setData(tick_data);
+            // Futu direction: Bid = active buy (outer disc), Ask = active sell (inner disc)
+            switch (ticker.dir()) {
+                case Qot_Common::TickerDirection_Bid: trade.side = AggressorSide::BUY; break;
+                case Qot_Common::TickerDirection_Ask: trade.side = AggressorSide::SELL; break;
+                case Qot_Common::TickerDirection_Neutral: trade.side = AggressorSide::NEUTRAL; break;
+                default: trade.side = AggressorSide::UNKNOWN; break;
+            }
+            
+            // Publish Trade event
+            auto event = std::make_shared<Event>(EventType::EVENT_TRADE);
+            event->setData(trade);
             event_engine->putEvent(event);
             
-            writeLog(LogLevel::Info, std::string("Published TICK event: ") + symbol + " price=" + std::to_string(tick_data.last_price));
+            QTS_LOG_SAMPLED(writeLog, LogLevel::Info, 200,
+                            std::string("Published TRADE event: ") + symbol + " price=" + std::to_string(trade.price));
         }
         
     } catch (const std::exception& e) {
@@ -1103,7 +1423,7 @@ void FutuSpi::OnPush_UpdateTicker(const Qot_UpdateTicker::Response &stRsp) {
 }
 
 void FutuSpi::OnPush_UpdateKL(const Qot_UpdateKL::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnPush_UpdateKL");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 5, 10000, "OnPush_UpdateKL");
     
     try {
         if (stRsp.rettype() != 0) {
@@ -1178,8 +1498,11 @@ void FutuSpi::OnPush_UpdateKL(const Qot_UpdateKL::Response &stRsp) {
             KlineData kline_data;
             kline_data.symbol = symbol;
             kline_data.exchange = exchange_->getName();
+            kline_data.symbol_id = SymbolRegistry::getInstance().intern(kline_data.exchange, symbol);
             kline_data.interval = kline_interval;
-            kline_data.datetime = kl.time();
+            kline_data.local_ts_ns = exchange_time::nowNs();
+            kline_data.exchange_ts_ns = exchange_time::parse(kl.time(), FutuMarketTimeZone(s2c.security().market()),
+                                                             &kline_data.utc_offset_sec);
             
             // Extract price data from K-line
             kline_data.open_price = kl.openprice();
@@ -1189,10 +1512,6 @@ void FutuSpi::OnPush_UpdateKL(const Qot_UpdateKL::Response &stRsp) {
             kline_data.volume = kl.volume();
             kline_data.turnover = kl.turnover();
             
-            // Parse timestamp (assuming datetime is a string like "2024-02-05 10:00:00")
-            // Temporarily set to system current time; should parse from datetime string in production
-            kline_data.timestamp = std::chrono::system_clock::now().time_since_epoch().count() / 1000000;
-            
             // Set interval_enum based on interval
             if (kline_interval == "1m") {
                 kline_data.interval_enum = KlineInterval::K_1M;
@@ -1219,7 +1538,8 @@ void FutuSpi::OnPush_UpdateKL(const Qot_UpdateKL::Response &stRsp) {
             event->setData(kline_data);
             event_engine->putEvent(event);
             
-            writeLog(LogLevel::Info, std::string("Published KLINE event: ") + symbol + " " + kline_interval + " close=" + std::to_string(kline_data.close_price));
+            QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 10, 10000,
+                              std::string("Published KLINE event: ") + symbol + " " + kline_interval + " close=" + std::to_string(kline_data.close_price));
         }
         
     } catch (const std::exception& e) {
@@ -1228,11 +1548,11 @@ void FutuSpi::OnPush_UpdateKL(const Qot_UpdateKL::Response &stRsp) {
 }
 
 void FutuSpi::OnPush_UpdateRT(const Qot_UpdateRT::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnPush_UpdateRT");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 5, 10000, "OnPush_UpdateRT");
 }
 
 void FutuSpi::OnPush_UpdateBroker(const Qot_UpdateBroker::Response &stRsp) {
-    writeLog(LogLevel::Info, "OnPush_UpdateBroker");
+    QTS_LOG_THROTTLED(writeLog, LogLevel::Info, 5, 10000, "OnPush_UpdateBroker");
 }
 
 void FutuSpi::OnPush_UpdatePriceReminder(const Qot_UpdatePriceReminder::Response &stRsp) {
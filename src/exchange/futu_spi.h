@@ -5,7 +5,9 @@
 #include "FTAPI.h"
 #include "FTSPI.h"
 #include "utils/logger_defines.h"
+#include "utils/exchange_time.h"
 #include <map>
+#include <vector>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
@@ -13,6 +15,12 @@
 // Forward declaration
 class FutuExchange;
 
+// Wall clock of a Futu QotMarket; Futu time strings are exchange-local
+inline const exchange_time::TimeZoneRule& FutuMarketTimeZone(int market) {
+    return market == Qot_Common::QotMarket_US_Security ? exchange_time::usEasternTime()
+                                                       : exchange_time::chinaTime();
+}
+
 // Futu SPI callback handler class
 class FutuSpi : public Futu::FTSPI_Conn, public Futu::FTSPI_Qot, public Futu::FTSPI_Trd {
 public:
@@ -23,6 +31,11 @@ public:
     bool InitApi(const std::string& host, int port);
     void ReleaseApi();
     bool IsConnected() const;
+    bool IsQotConnected() const;
+
+    // Re-run InitConnect on whichever connection OpenD dropped. Futu keeps
+    // subscriptions per connection, so they must be renewed afterwards.
+    bool Reconnect();
 
     // ========== Wait for async replies ==========
     bool WaitForReply(Futu::u32_t serial_no, int timeout_ms = 5000);
@@ -45,12 +58,29 @@ public:
     Futu::u32_t SendSubscribeKLine(const Qot_Common::Security& security, int kline_type);
     Futu::u32_t SendGetKLine(const Qot_Common::Security& security, int kline_type, int count);
     Futu::u32_t SendGetHistoryKLine(const Qot_Common::Security& security, int kline_type, int count);
-    Futu::u32_t SendGetSecuritySnapshot(const std::vector<Qot_Common::Security>& securities);
+    // With `on_reply` set the reply is delivered there (nullptr if the
+    // connection dropped) instead of WaitForReply
+    Futu::u32_t SendGetSecuritySnapshot(const std::vector<Qot_Common::Security>& securities,
+                                        std::function<void(const Qot_GetSecuritySnapshot::Response*)> on_reply = nullptr);
     Futu::u32_t SendGetPlateSecurity(const std::string& plate_code);
     Futu::u32_t SendGetStaticInfo(int market_type, int security_type);
     Futu::u32_t SendSubscribeTick(const Qot_Common::Security& security);
     Futu::u32_t SendUnsubscribeKLine(const Qot_Common::Security& security);
 
+    // One Qot_Sub for many securities; the reply is delivered to `on_complete`
+    // instead of WaitForReply
+    Futu::u32_t SendSubscription(const std::vector<Qot_Common::Security>& securities,
+                                 const std::vector<int>& sub_types, bool subscribe,
+                                 std::function<void(bool)> on_complete);
+
+    Futu::u32_t SendGetSubInfo();
+    Futu::u32_t SendRequestHistoryKLQuota();
+    // Dates are "yyyy-MM-dd"; `market` is a Qot_Common::TradeDateMarket
+    Futu::u32_t SendRequestTradeDate(int market, const std::string& begin_time, const std::string& end_time);
+
+    // Qot_Common::KLType -> Qot_Common::SubType (0 if not subscribable)
+    static int KLTypeToSubType(int kl_type);
+
     // ========== FTSPI_Conn callbacks ==========
     void OnInitConnect(Futu::FTAPI_Conn* pConn, Futu::i64_t nErrCode, const char* strDesc) override;
     void OnDisConnect(Futu::FTAPI_Conn* pConn, Futu::i64_t nErrCode) override;
@@ -136,6 +166,9 @@ public:
     std::map<Futu::u32_t, Qot_RequestHistoryKL::Response> history_kline_responses_;
     std::map<Futu::u32_t, Qot_GetPlateSecurity::Response> plate_security_responses_;
     std::map<Futu::u32_t, Qot_GetStaticInfo::Response> static_info_responses_;
+    std::map<Futu::u32_t, Qot_GetSubInfo::Response> sub_info_responses_;
+    std::map<Futu::u32_t, Qot_RequestHistoryKLQuota::Response> history_quota_responses_;
+    std::map<Futu::u32_t, Qot_RequestTradeDate::Response> trade_date_responses_;
     
     friend class FutuExchange;  // allow FutuExchange to access mutex_ and response data
 
@@ -147,6 +180,8 @@ private:
     mutable std::mutex mutex_;
     std::condition_variable cv_;
     std::map<Futu::u32_t, bool> reply_flags_;
+    std::map<Futu::u32_t, std::function<void(bool)>> sub_callbacks_;   // async Qot_Sub replies
+    std::map<Futu::u32_t, std::function<void(const Qot_GetSecuritySnapshot::Response*)>> snapshot_callbacks_;
     
     // API instance management
     Futu::FTAPI_Qot* qot_api_ = nullptr;
@@ -225,9 +225,9 @@ std::vector<Snapshot> IBKRExchange::getMarketSnapshot(const std::vector<std::str
 std::string IBKRExchange::placeOrder(
     const std::string& symbol,
     const std::string& side,
-    int quantity,
+    Quantity quantity,
     const std::string& order_type,
-    double price) {
+    Price price) {
     std::stringstream ss;
     ss << "Place IBKR order: " << symbol 
        << " " << order_type << " " << quantity;
@@ -243,10 +243,10 @@ std::string IBKRExchange::placeOrder(
     
     ::Order order;
     order.action = (side == "BUY") ? "BUY" : "SELL";
-    order.totalQuantity = quantity;
+    order.totalQuantity = quantity.value();
     order.orderType = (order_type == "MARKET") ? "MKT" : "LMT";
     if (order_type == "LIMIT") {
-        order.lmtPrice = price;
+        order.lmtPrice = price.toDouble();
     }
     
     int order_id = getNextOrderId();
@@ -269,7 +269,7 @@ bool IBKRExchange::cancelOrder(const std::string& order_id) {
     return true;
 }
 
-bool IBKRExchange::modifyOrder(const std::string& order_id, int new_quantity, double new_price) {
+bool IBKRExchange::modifyOrder(const std::string& order_id, Quantity new_quantity, Price new_price) {
     std::stringstream ss;
     ss << "Modify IBKR order: " << order_id << " price=" << price << " qty=" << quantity;
     LOG_INFO(ss.str());
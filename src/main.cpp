@@ -4,6 +4,14 @@
 #include "managers/risk_manager.h"
 #include "managers/strategy_manager.h"
 #include "scanner/market_scanner.h"
+#include "data/data_subscriber.h"
+#include "data/kline_cache.h"
+#include "data/bar_store.h"
+#include "data/bar_aggregator.h"
+#include "data/order_book_engine.h"
+#include "data/trade_flow_engine.h"
+#include "data/feed_health.h"
+#include "data/trading_calendar.h"
 #include "exchange/exchange_manager.h"
 #include "exchange/exchange_interface.h"
 #include "event/event_engine.h"
@@ -12,6 +20,8 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <algorithm>
+#include <filesystem>
 
 // Global flag for graceful shutdown
 std::atomic<bool> g_running(true);
@@ -42,6 +52,16 @@ void printSystemStatus() {
         std::cout << "\n";
     }
     
+    std::string subscription_report = DataSubscriber::getInstance().getUsageReport();
+    if (!subscription_report.empty()) {
+        std::cout << "Subscriptions:\n" << subscription_report;
+    }
+    
+    std::string feed_report = FeedHealth::getInstance().getHealthReport();
+    if (!feed_report.empty()) {
+        std::cout << "Market Data Feeds:\n" << feed_report;
+    }
+    
     std::cout << "Total Positions: " << pos_mgr.getTotalPositions() << "\n";
     std::cout << "Total Market Value: $" << pos_mgr.getTotalMarketValue() << "\n";
     std::cout << "Total P/L: $" << pos_mgr.getTotalProfitLoss() << "\n";
@@ -92,6 +112,15 @@ int main(int argc, char* argv[]) {
     }
     
     const auto& config = config_mgr.getConfig();
+
+    // Apply logging settings before anything is written to the log file
+    RotatingLogFile::Options log_file_options;
+    log_file_options.dir = config.logging.file_dir;
+    log_file_options.segment_bytes = static_cast<size_t>(std::max(1, config.logging.segment_size_mb)) * 1024 * 1024;
+    log_file_options.rotate_interval_seconds = static_cast<int64_t>(config.logging.rotate_interval_hours) * 3600;
+    log_file_options.compress_rotated = config.logging.compress_rotated;
+    Logger::getInstance().configure(stringToLevel(config.logging.level), config.logging.console,
+                                    config.logging.file, log_file_options);
     
     // Display exchange configuration information
     std::cout << "Enabled Exchanges:\n";
@@ -134,6 +163,39 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    // K-line history persisted on disk, so restarts only fetch the missing bars
+    if (!config.market_data.bar_store_dir.empty()) {
+        BarStore::getInstance().open(config.market_data.bar_store_dir);
+    }
+    
+    // Exchange holidays, loaded by the scanner workers once per trading date
+    TradingCalendar::getInstance().setCacheDir(config.market_data.calendar_dir);
+    
+    // K-line cache kept current by EVENT_KLINE pushes
+    auto& kline_cache = KLineCache::getInstance();
+    kline_cache.setCapacity(static_cast<size_t>(std::max(1, config.market_data.kline_cache_bars)));
+    kline_cache.initializeEventHandlers(&event_engine);
+    
+    // L2 books kept current by EVENT_DEPTH pushes
+    OrderBookEngine::getInstance().initializeEventHandlers(&event_engine);
+    
+    // Rolling order flow from EVENT_TRADE prints
+    TradeFlowEngine::getInstance().initializeEventHandlers(&event_engine);
+    
+    // Intraday K-lines built from trade ticks; must be running before subscriptions are taken
+    auto& bar_aggregator = BarAggregator::getInstance();
+    bar_aggregator.initializeEventHandlers(&event_engine);
+    bar_aggregator.start(config.market_data);
+    
+    // Start batched market data subscriptions
+    auto& subscriber = DataSubscriber::getInstance();
+    subscriber.start(config.market_data);
+    
+    // Gap and staleness detection, reconnect and resync of dropped feeds
+    auto& feed_health = FeedHealth::getInstance();
+    feed_health.initializeEventHandlers(&event_engine);
+    feed_health.start(config.market_data);
+    
     // Initialize strategy manager (strategy instances will be created dynamically by scanner)
     auto& strategy_mgr = StrategyManager::getInstance();
     
@@ -144,6 +206,7 @@ int main(int argc, char* argv[]) {
     // Create and start market scanner
     // Scanner will automatically notify strategy manager to create/delete strategy instances
     MarketScanner scanner;
+    scanner.initializeEventHandlers(&event_engine);
     
     // Add all connected exchanges to scanner
     for (auto& exchange : exchanges) {
@@ -158,6 +221,11 @@ int main(int argc, char* argv[]) {
     LOG_INFO("\nSystem is running. Press Ctrl+C to stop.\n");
     LOG_INFO("Status updates will be printed every minute.\n\n");
     
+    // Scanner expressions edited in a JSON config file apply without a restart
+    const bool watch_config = std::filesystem::path(config_file).extension() == ".json";
+    std::error_code config_ec;
+    auto config_write_time = std::filesystem::last_write_time(config_file, config_ec);
+    
     // Main loop
     int status_counter = 0;
     while (g_running) {
@@ -165,6 +233,17 @@ int main(int argc, char* argv[]) {
         
         status_counter++;
         
+        auto write_time = std::filesystem::last_write_time(config_file, config_ec);
+        if (watch_config && !config_ec && write_time != config_write_time) {
+            // A file that does not parse is reported once and read again on its next save
+            config_write_time = write_time;
+            std::string filter;
+            std::string score;
+            if (config_mgr.readScanExpressions(config_file, filter, score)) {
+                scanner.setScanExpressions(filter, score);
+            }
+        }
+        
         // Print status every minute
         if (status_counter >= 60) {
             printSystemStatus();
@@ -183,6 +262,12 @@ int main(int argc, char* argv[]) {
     strategy_mgr.stopAllStrategies();
     LOG_INFO("All strategies stopped");
     
+    // Send the final unsubscribes before the exchanges go away
+    feed_health.stop();
+    subscriber.stop();
+    LOG_INFO("Market data subscriptions stopped");
+    bar_aggregator.stop();
+    
     // Print final status
     printSystemStatus();
     
@@ -7,23 +7,38 @@ PositionManager& PositionManager::getInstance() {
     return instance;
 }
 
-void PositionManager::updatePosition(const std::string& symbol, int quantity, double price) {
+void PositionManager::updatePosition(const std::string& symbol, Quantity quantity, Price price,
+                                     const std::string& exchange) {
+    // Keyed by the same (exchange, code) id the exchange's market data
+    // carries. Without an exchange the code is looked up alone, and a code
+    // never seen before gets a code-only id.
+    auto& registry = SymbolRegistry::getInstance();
+    SymbolId symbol_id = exchange.empty() ? registry.findByCode(symbol) : registry.intern(exchange, symbol);
+    if (symbol_id == kInvalidSymbolId) {
+        symbol_id = registry.intern("", symbol);
+    }
+    if (symbol_id == kInvalidSymbolId) {
+        LOG_ERROR("Symbol registry full, position of " + symbol + " not recorded");
+        return;
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = positions_.find(symbol);
-    if (it == positions_.end()) {
+    Position* existing = positions_.find(symbol_id);
+    if (existing == nullptr) {
         // New position
         Position pos;
+        pos.symbol_id = symbol_id;
         pos.symbol = symbol;
         pos.quantity = quantity;
         pos.avg_price = price;
         pos.current_price = price;
-        pos.cost = quantity * price;
+        pos.cost = price * quantity;
         pos.market_value = pos.cost;
-        pos.side = quantity > 0 ? "LONG" : "SHORT";
+        pos.side = quantity.isPositive() ? "LONG" : "SHORT";
         calculateProfitLoss(pos);
         
-        positions_[symbol] = pos;
+        positions_[symbol_id] = pos;
         
         std::stringstream ss;
         ss << "New position opened: " << symbol << " qty=" << quantity 
@@ -31,23 +46,33 @@ void PositionManager::updatePosition(const std::string& symbol, int quantity, do
         LOG_INFO(ss.str());
     } else {
         // Update position
-        Position& pos = it->second;
+        Position& pos = *existing;
         
-        // Calculate new average cost
-        double total_cost = pos.avg_price * pos.quantity + price * quantity;
-        pos.quantity += quantity;
+        Quantity old_quantity = pos.quantity;
+        Quantity new_quantity = old_quantity + quantity;
         
-        if (pos.quantity == 0) {
+        if (new_quantity.isZero()) {
             // Close position
             std::stringstream ss;
             ss << "Position closed: " << symbol << " P/L=" << pos.profit_loss;
             LOG_INFO(ss.str());
-            positions_.erase(it);
+            positions_.erase(symbol_id);
             return;
         }
         
-        pos.avg_price = total_cost / pos.quantity;
-        pos.cost = pos.avg_price * pos.quantity;
+        // Adding to the position accumulates exact cost; reducing releases cost
+        // pro rata so avg_price is unchanged; crossing zero reopens at `price`
+        if (old_quantity.isPositive() == quantity.isPositive()) {
+            pos.cost += price * quantity;
+        } else if (old_quantity.isPositive() == new_quantity.isPositive()) {
+            pos.cost = scaleAmount(pos.cost, new_quantity, old_quantity);
+        } else {
+            pos.cost = price * new_quantity;
+            pos.side = new_quantity.isPositive() ? "LONG" : "SHORT";
+        }
+        
+        pos.quantity = new_quantity;
+        pos.avg_price = averagePrice(pos.cost, pos.quantity);
         pos.market_value = pos.current_price * pos.quantity;
         calculateProfitLoss(pos);
         
@@ -58,31 +83,38 @@ void PositionManager::updatePosition(const std::string& symbol, int quantity, do
     }
 }
 
-void PositionManager::updateMarketPrice(const std::string& symbol, double price) {
+void PositionManager::updateMarketPrice(const std::string& symbol, Price price) {
+    updateMarketPrice(SymbolRegistry::getInstance().findByCode(symbol), price);
+}
+
+void PositionManager::updateMarketPrice(SymbolId symbol_id, Price price) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = positions_.find(symbol);
-    if (it != positions_.end()) {
-        Position& pos = it->second;
-        pos.current_price = price;
-        pos.market_value = price * pos.quantity;
-        calculateProfitLoss(pos);
+    Position* pos = positions_.find(symbol_id);
+    if (pos != nullptr) {
+        pos->current_price = price;
+        pos->market_value = price * pos->quantity;
+        calculateProfitLoss(*pos);
     }
 }
 
 Position* PositionManager::getPosition(const std::string& symbol) {
+    return getPosition(SymbolRegistry::getInstance().findByCode(symbol));
+}
+
+Position* PositionManager::getPosition(SymbolId symbol_id) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = positions_.find(symbol);
-    if (it != positions_.end()) {
-        return &(it->second);
-    }
-    return nullptr;
+    return positions_.find(symbol_id);
 }
 
 std::map<std::string, Position> PositionManager::getAllPositions() {
     std::lock_guard<std::mutex> lock(mutex_);
-    return positions_;
+    
+    std::map<std::string, Position> result;
+    positions_.forEach([&result](SymbolId, const Position& pos) {
+        result[pos.symbol] = pos;
+    });
+    return result;
 }
 
 int PositionManager::getTotalPositions() const {
@@ -90,29 +122,33 @@ int PositionManager::getTotalPositions() const {
     return positions_.size();
 }
 
-double PositionManager::getTotalMarketValue() const {
+Amount PositionManager::getTotalMarketValue() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    double total = 0.0;
-    for (const auto& pair : positions_) {
-        total += pair.second.market_value;
-    }
+    Amount total;
+    positions_.forEach([&total](SymbolId, const Position& pos) {
+        total += pos.market_value;
+    });
     return total;
 }
 
-double PositionManager::getTotalProfitLoss() const {
+Amount PositionManager::getTotalProfitLoss() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    double total = 0.0;
-    for (const auto& pair : positions_) {
-        total += pair.second.profit_loss;
-    }
+    Amount total;
+    positions_.forEach([&total](SymbolId, const Position& pos) {
+        total += pos.profit_loss;
+    });
     return total;
 }
 
 bool PositionManager::hasPosition(const std::string& symbol) const {
+    return hasPosition(SymbolRegistry::getInstance().findByCode(symbol));
+}
+
+bool PositionManager::hasPosition(SymbolId symbol_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return positions_.find(symbol) != positions_.end();
+    return positions_.contains(symbol_id);
 }
 
 void PositionManager::clearPositions() {
@@ -123,10 +159,6 @@ void PositionManager::clearPositions() {
 
 void PositionManager::calculateProfitLoss(Position& position) {
     position.profit_loss = position.market_value - position.cost;
-    if (position.cost != 0) {
-        position.profit_loss_ratio = position.profit_loss / position.cost;
-    } else {
-        position.profit_loss_ratio = 0.0;
-    }
+    position.profit_loss_ratio = position.profit_loss.ratio(position.cost);
 }
 
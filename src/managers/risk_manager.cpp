@@ -16,7 +16,7 @@ RiskManager::RiskManager() {
     current_capital_ = initial_capital_;
 }
 
-bool RiskManager::checkOrderRisk(const std::string& symbol, int quantity, double price) {
+bool RiskManager::checkOrderRisk(const std::string& symbol, Quantity quantity, Price price) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     const auto& config = ConfigManager::getInstance().getConfig();
@@ -36,9 +36,9 @@ bool RiskManager::checkOrderRisk(const std::string& symbol, int quantity, double
     }
     
     // Check single stock ratio
-    double order_value = std::abs(quantity * price);
-    double total_value = pos_mgr.getTotalMarketValue() + order_value;
-    double ratio = order_value / total_value;
+    Amount order_value = (price * quantity).abs();
+    Amount total_value = pos_mgr.getTotalMarketValue() + order_value;
+    double ratio = order_value.ratio(total_value);
     
     if (ratio > config.trading.single_stock_max_ratio) {
         std::stringstream ss;
@@ -49,7 +49,7 @@ bool RiskManager::checkOrderRisk(const std::string& symbol, int quantity, double
     }
     
     // Check available capital
-    if (order_value > current_capital_ * 0.95) {
+    if (order_value.toDouble() > current_capital_ * 0.95) {
         LOG_WARN("Insufficient capital, order rejected");
         return false;
     }
@@ -57,14 +57,14 @@ bool RiskManager::checkOrderRisk(const std::string& symbol, int quantity, double
     return true;
 }
 
-bool RiskManager::shouldStopLoss(const std::string& symbol, double current_price) {
+bool RiskManager::shouldStopLoss(const std::string& symbol, Price current_price) {
     const auto& config = ConfigManager::getInstance().getConfig();
     auto& pos_mgr = PositionManager::getInstance();
     
     Position* pos = pos_mgr.getPosition(symbol);
     if (!pos) return false;
     
-    double loss_ratio = (current_price - pos->avg_price) / pos->avg_price;
+    double loss_ratio = (current_price - pos->avg_price).ratio(pos->avg_price);
     
     if (loss_ratio <= -config.risk.stop_loss_ratio) {
         std::stringstream ss;
@@ -77,14 +77,14 @@ bool RiskManager::shouldStopLoss(const std::string& symbol, double current_price
     return false;
 }
 
-bool RiskManager::shouldTakeProfit(const std::string& symbol, double current_price) {
+bool RiskManager::shouldTakeProfit(const std::string& symbol, Price current_price) {
     const auto& config = ConfigManager::getInstance().getConfig();
     auto& pos_mgr = PositionManager::getInstance();
     
     Position* pos = pos_mgr.getPosition(symbol);
     if (!pos) return false;
     
-    double profit_ratio = (current_price - pos->avg_price) / pos->avg_price;
+    double profit_ratio = (current_price - pos->avg_price).ratio(pos->avg_price);
     
     if (profit_ratio >= config.risk.take_profit_ratio) {
         std::stringstream ss;
@@ -97,7 +97,7 @@ bool RiskManager::shouldTakeProfit(const std::string& symbol, double current_pri
     return false;
 }
 
-int RiskManager::calculatePositionSize(double stock_price, double available_cash) {
+Quantity RiskManager::calculatePositionSize(Price stock_price, Amount available_cash) {
     const auto& config = ConfigManager::getInstance().getConfig();
     auto& pos_mgr = PositionManager::getInstance();
     
@@ -105,18 +105,18 @@ int RiskManager::calculatePositionSize(double stock_price, double available_cash
     double max_stock_value = config.trading.max_position_size * config.trading.single_stock_max_ratio;
     
     // Consider current total positions
-    double current_total = pos_mgr.getTotalMarketValue();
+    double current_total = pos_mgr.getTotalMarketValue().toDouble();
     double remaining = config.trading.max_position_size - current_total;
     
-    double max_value = std::min({max_stock_value, available_cash * 0.95, remaining});
+    double max_value = std::min({max_stock_value, available_cash.toDouble() * 0.95, remaining});
     
-    if (max_value <= 0 || stock_price <= 0) return 0;
+    if (max_value <= 0 || !stock_price.isPositive()) return Quantity();
     
     // Calculate shares (full lots, minimum 100 shares for HK stocks)
-    int shares = static_cast<int>(max_value / stock_price);
+    int64_t shares = Amount::fromDouble(max_value).raw() / stock_price.raw();
     shares = (shares / 100) * 100;  // Round down to multiple of 100
     
-    return shares;
+    return Quantity(shares);
 }
 
 void RiskManager::updateDailyPnL(double pnl) {
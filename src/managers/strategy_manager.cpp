@@ -2,6 +2,7 @@
 #include "managers/position_manager.h"
 #include "strategies/strategy_base.h"
 #include "strategies/momentum_strategy.h"
+#include "data/data_subscriber.h"
 #include "event/event.h"
 #include "exchange/exchange_interface.h"
 #include "utils/logger.h"
@@ -13,50 +14,50 @@ StrategyManager& StrategyManager::getInstance() {
     return instance;
 }
 
-void StrategyManager::processScanResults(const std::vector<ScanResult>& results) {
+void StrategyManager::processScanResults(const std::string& exchange_name, const std::vector<ScanResult>& results) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     std::stringstream ss;
-    ss << "Processing scan results: " << results.size() << " stocks";
+    ss << "Processing scan results from " << exchange_name << ": " << results.size() << " stocks";
     LOG_INFO(ss.str());
     
-    // 1. Build the set of stock symbols from the current scan
-    std::set<std::string> current_scan_stocks;
+    // 1. Build the set of symbol ids from the current scan
+    std::set<SymbolId> current_scan_stocks;
     for (const auto& result : results) {
-        current_scan_stocks.insert(result.symbol);
+        current_scan_stocks.insert(result.symbol_id);
     }
     
     // 2. Create strategy instances for new symbols (skip if already exists)
     for (const auto& result : results) {
-        if (!hasStrategyInstance(result.symbol)) {
-            createStrategyInstance(result.symbol, result);
+        StrategyInstance* instance = strategy_instances_.find(result.symbol_id);
+        if (instance == nullptr) {
+            createStrategyInstance(result);
         } else {
             // Update scan result for existing strategy
-            auto& instance = strategy_instances_[result.symbol];
-            if (instance.strategy && instance.strategy->isRunning()) {
-                instance.strategy->onScanResult(result);
+            if (instance->strategy && instance->strategy->isRunning()) {
+                instance->strategy->onScanResult(result);
             }
         }
     }
     
-    // 3. Identify strategies to remove (symbols not present in the latest scan)
-    std::vector<std::string> to_remove;
-    for (const auto& pair : strategy_instances_) {
-        const std::string& symbol = pair.first;
-        
+    // 3. Identify strategies to remove (symbols of this exchange not present in the latest scan)
+    std::vector<SymbolId> to_remove;
+    strategy_instances_.forEach([&](SymbolId symbol_id, const StrategyInstance& instance) {
+        // Other exchanges' instances are judged by their own scans
+        if (instance.exchange_name != exchange_name) return;
         // If the symbol is not in the current scan, consider removal
-        if (current_scan_stocks.find(symbol) == current_scan_stocks.end()) {
-            to_remove.push_back(symbol);
+        if (current_scan_stocks.find(symbol_id) == current_scan_stocks.end()) {
+            to_remove.push_back(symbol_id);
         }
-    }
+    });
     
     // 4. Remove strategies that no longer meet criteria (check for positions)
-    for (const auto& symbol : to_remove) {
-        removeStrategyInstance(symbol, false);
+    for (SymbolId symbol_id : to_remove) {
+        removeStrategyInstance(symbol_id, false);
     }
     
     // 5. Update the last scanned symbol set
-    last_scan_stocks_ = current_scan_stocks;
+    last_scan_stocks_[exchange_name] = current_scan_stocks;
     
     ss.str("");
     ss << "Strategy instances: Active=" << getActiveStrategyCount() 
@@ -64,10 +65,64 @@ void StrategyManager::processScanResults(const std::vector<ScanResult>& results)
     LOG_INFO(ss.str());
 }
 
-void StrategyManager::createStrategyInstance(const std::string& symbol, const ScanResult& scan_result) {
+void StrategyManager::processRankingChanges(const std::string& exchange_name,
+                                            const std::vector<ScanResult>& top,
+                                            const std::vector<SymbolId>& entered,
+                                            const std::vector<SymbolId>& left) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto& ranked = last_scan_stocks_[exchange_name];
+    for (SymbolId symbol_id : left) {
+        ranked.erase(symbol_id);
+    }
+    for (SymbolId symbol_id : entered) {
+        ranked.insert(symbol_id);
+    }
+    
+    // 1. Create instances for entering stocks, refresh the ones staying
+    for (const auto& result : top) {
+        StrategyInstance* instance = strategy_instances_.find(result.symbol_id);
+        if (instance == nullptr) {
+            createStrategyInstance(result);
+        } else {
+            // Back in the ranking while still held for a position
+            instance->is_active = true;
+            if (instance->strategy && instance->strategy->isRunning()) {
+                instance->strategy->onScanResult(result);
+            }
+        }
+    }
+    
+    // 2. Remove stocks that left, and retry the ones kept for a position
+    std::vector<SymbolId> to_remove(left.begin(), left.end());
+    strategy_instances_.forEach([&](SymbolId symbol_id, const StrategyInstance& instance) {
+        if (!instance.is_active && instance.exchange_name == exchange_name && ranked.count(symbol_id) == 0) {
+            to_remove.push_back(symbol_id);
+        }
+    });
+    for (SymbolId symbol_id : to_remove) {
+        removeStrategyInstance(symbol_id, false);
+    }
+    
+    if (!entered.empty() || !left.empty()) {
+        std::stringstream ss;
+        ss << "Ranking of " << exchange_name << ": +" << entered.size() << " / -" << left.size()
+           << "; Strategy instances: Active=" << getActiveStrategyCount()
+           << ", Total=" << strategy_instances_.size();
+        LOG_INFO(ss.str());
+    }
+}
+
+void StrategyManager::createStrategyInstance(const ScanResult& scan_result) {
     // No lock needed; caller already holds the lock
     
-    if (hasStrategyInstance(symbol)) {
+    const std::string& symbol = scan_result.symbol;
+    if (scan_result.symbol_id == kInvalidSymbolId) {
+        LOG_ERROR("Scan result without symbol id: " + symbol);
+        return;
+    }
+
+    if (hasStrategyInstance(scan_result.symbol_id)) {
         std::stringstream ss;
         ss << "Strategy instance already exists for " << symbol;
         LOG_WARN(ss.str());
@@ -83,25 +138,28 @@ void StrategyManager::createStrategyInstance(const std::string& symbol, const Sc
         return;
     }
     
-    // Subscribe to market data (using the provided exchange instance)
-    if (scan_result.exchange && scan_result.exchange->isConnected()) {
-        const std::string& exchange_name = scan_result.exchange_name;
-        
-        // Subscribe to KLine data (1 minute)
-        if (!scan_result.exchange->subscribeKLine(symbol, "1m")) {
-            LOG_WARN("Failed to subscribe KLine for " + symbol + " on " + exchange_name);
-        }
-        
-        // Subscribe to Tick data
-        if (!scan_result.exchange->subscribeTick(symbol)) {
-            LOG_WARN("Failed to subscribe Tick for " + symbol + " on " + exchange_name);
-        }
-        
-        LOG_INFO("Subscribed market data for " + symbol + " on " + exchange_name);
-    } else {
-        LOG_WARN("Exchange not ready for " + symbol + ", cannot subscribe market data");
+    // Subscribe to market data; the subscriber batches the exchange requests
+    // and retries until the exchange is ready
+    const std::string& exchange_name = scan_result.exchange_name;
+    auto& subscriber = DataSubscriber::getInstance();
+    
+    // Subscribe to KLine data (1 minute)
+    if (!subscriber.subscribeKLine(exchange_name, symbol, "1m")) {
+        LOG_WARN("Failed to subscribe KLine for " + symbol + " on " + exchange_name);
+    }
+    
+    // Subscribe to Tick data
+    if (!subscriber.subscribeTick(exchange_name, symbol)) {
+        LOG_WARN("Failed to subscribe Tick for " + symbol + " on " + exchange_name);
+    }
+    
+    // Subscribe to the order book (depth-aware liquidity checks)
+    if (!subscriber.subscribeDepth(exchange_name, symbol)) {
+        LOG_WARN("Failed to subscribe Depth for " + symbol + " on " + exchange_name);
     }
     
+    LOG_INFO("Subscribed market data for " + symbol + " on " + exchange_name);
+    
     // Start the strategy
     strategy->start();
     
@@ -110,13 +168,14 @@ void StrategyManager::createStrategyInstance(const std::string& symbol, const Sc
     
     // Save the strategy instance
     StrategyInstance instance;
+    instance.symbol_id = scan_result.symbol_id;
     instance.symbol = symbol;
     instance.strategy = strategy;
     instance.is_active = true;
     instance.exchange_name = scan_result.exchange_name;
     instance.exchange = scan_result.exchange;
     
-    strategy_instances_[symbol] = instance;
+    strategy_instances_[scan_result.symbol_id] = instance;
     
     std::stringstream ss;
     ss << "Created strategy instance for " << symbol 
@@ -128,60 +187,66 @@ void StrategyManager::createStrategyInstance(const std::string& symbol, const Sc
     LOG_INFO(ss.str());
 }
 
-void StrategyManager::removeStrategyInstance(const std::string& symbol, bool force) {
+void StrategyManager::removeStrategyInstance(SymbolId symbol_id, bool force) {
     // No lock needed; caller already holds the lock
     
-    auto it = strategy_instances_.find(symbol);
-    if (it == strategy_instances_.end()) {
+    StrategyInstance* instance = strategy_instances_.find(symbol_id);
+    if (instance == nullptr) {
         return;
     }
+    const std::string symbol = instance->symbol;
     
     // If not force removal, check whether the strategy can be removed
-    if (!force && !canRemoveStrategy(symbol)) {
+    if (!force && !canRemoveStrategy(symbol_id)) {
         std::stringstream ss;
         ss << "Cannot remove strategy for " << symbol 
            << " - has active position, will keep monitoring";
         LOG_WARN(ss.str());
         
         // Mark as inactive but keep the instance to continue monitoring positions
-        it->second.is_active = false;
+        instance->is_active = false;
         return;
     }
     
-    // Unsubscribe using the associated exchange instance
-    const auto& exchange = it->second.exchange;
-    if (exchange && exchange->isConnected()) {
-        exchange->unsubscribeKLine(symbol);
-        exchange->unsubscribeTick(symbol);
-        LOG_INFO("Unsubscribed market data for " + symbol + " from " + it->second.exchange_name);
-    }
+    // Release this instance's market data references
+    auto& subscriber = DataSubscriber::getInstance();
+    subscriber.unsubscribeKLine(instance->exchange_name, symbol, "1m");
+    subscriber.unsubscribeTick(instance->exchange_name, symbol);
+    subscriber.unsubscribeDepth(instance->exchange_name, symbol);
+    LOG_INFO("Unsubscribed market data for " + symbol + " from " + instance->exchange_name);
     
     // Stop the strategy
-    if (it->second.strategy) {
-        it->second.strategy->stop();
+    if (instance->strategy) {
+        instance->strategy->stop();
     }
     
     // Erase the instance
-    strategy_instances_.erase(it);
+    strategy_instances_.erase(symbol_id);
     
     std::stringstream ss;
     ss << "Removed strategy instance for " << symbol;
     LOG_INFO(ss.str());
 }
 
-bool StrategyManager::hasStrategyInstance(const std::string& symbol) const {
+bool StrategyManager::hasStrategyInstance(SymbolId symbol_id) const {
+    // No lock needed; caller already holds the lock
+    return strategy_instances_.contains(symbol_id);
+}
+
+StrategyInstance* StrategyManager::findInstance(SymbolId symbol_id, const std::string& exchange, const std::string& symbol) {
     // No lock needed; caller already holds the lock
-    return strategy_instances_.find(symbol) != strategy_instances_.end();
+    // Adapters stamp symbol_id at ingestion; fall back to a registry lookup for those that don't
+    return strategy_instances_.find(SymbolRegistry::getInstance().resolve(symbol_id, exchange, symbol));
 }
 
 void StrategyManager::startAllStrategies() {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    for (auto& pair : strategy_instances_) {
-        if (pair.second.strategy && !pair.second.strategy->isRunning()) {
-            pair.second.strategy->start();
+    strategy_instances_.forEach([](SymbolId, StrategyInstance& instance) {
+        if (instance.strategy && !instance.strategy->isRunning()) {
+            instance.strategy->start();
         }
-    }
+    });
     
     std::stringstream ss;
     ss << "Started all strategy instances: " << strategy_instances_.size();
@@ -191,11 +256,11 @@ void StrategyManager::startAllStrategies() {
 void StrategyManager::stopAllStrategies() {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    for (auto& pair : strategy_instances_) {
-        if (pair.second.strategy && pair.second.strategy->isRunning()) {
-            pair.second.strategy->stop();
+    strategy_instances_.forEach([](SymbolId, StrategyInstance& instance) {
+        if (instance.strategy && instance.strategy->isRunning()) {
+            instance.strategy->stop();
         }
-    }
+    });
     
     std::stringstream ss;
     ss << "Stopped all strategy instances: " << strategy_instances_.size();
@@ -205,19 +270,22 @@ void StrategyManager::stopAllStrategies() {
 size_t StrategyManager::getActiveStrategyCount() const {
     // No lock needed; caller already holds the lock
     
-    return std::count_if(strategy_instances_.begin(), strategy_instances_.end(),
-        [](const std::pair<std::string, StrategyInstance>& pair) {
-            return pair.second.strategy && pair.second.strategy->isRunning();
-        });
+    size_t count = 0;
+    strategy_instances_.forEach([&count](SymbolId, const StrategyInstance& instance) {
+        if (instance.strategy && instance.strategy->isRunning()) {
+            ++count;
+        }
+    });
+    return count;
 }
 
 std::vector<std::string> StrategyManager::getStrategyStockCodes() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
     std::vector<std::string> codes;
-    for (const auto& pair : strategy_instances_) {
-        codes.push_back(pair.first);
-    }
+    strategy_instances_.forEach([&codes](SymbolId, const StrategyInstance& instance) {
+        codes.push_back(instance.symbol);
+    });
     return codes;
 }
 
@@ -232,22 +300,21 @@ void StrategyManager::printStrategyStatus() const {
     std::stringstream ss;
     ss << "\n=== Strategy Instances (" << strategy_instances_.size() << ") ===";
     
-    for (const auto& pair : strategy_instances_) {
-        const auto& instance = pair.second;
+    strategy_instances_.forEach([&ss](SymbolId, const StrategyInstance& instance) {
         ss << "\n  " << instance.symbol 
            << " - " << (instance.strategy->isRunning() ? "RUNNING" : "STOPPED")
            << " - " << (instance.is_active ? "ACTIVE" : "INACTIVE");
-    }
+    });
     
     LOG_INFO(ss.str());
 }
 
-bool StrategyManager::canRemoveStrategy(const std::string& symbol) const {
+bool StrategyManager::canRemoveStrategy(SymbolId symbol_id) const {
     // No lock needed; caller already holds the lock
 
     // Check for existing positions
     auto& pos_mgr = PositionManager::getInstance();
-    if (pos_mgr.hasPosition(symbol)) {
+    if (pos_mgr.hasPosition(symbol_id)) {
         return false;  // has positions; cannot remove
     }
     
@@ -315,24 +382,24 @@ void StrategyManager::onKLineEvent(const EventPtr& event) {
         return;
     }
     
-    std::string symbol = kline->symbol;
+    const std::string& symbol = kline->symbol;
     
     // Find the corresponding strategy instance and invoke its handler
     {
         std::lock_guard<std::mutex> lock(mutex_);
         
-        auto it = strategy_instances_.find(symbol);
-        if (it == strategy_instances_.end()) {
+        StrategyInstance* instance = findInstance(kline->symbol_id, kline->exchange, symbol);
+        if (instance == nullptr) {
             // No corresponding strategy instance; return early
             return;
         }
         
-        if (!it->second.is_active || !it->second.strategy) {
+        if (!instance->is_active || !instance->strategy) {
             return;
         }
         
         // Call the strategy's onKLine method to handle the data
-        it->second.strategy->onKLine(symbol, *kline);
+        instance->strategy->onKLine(symbol, *kline);
     }
 }
 
@@ -348,24 +415,24 @@ void StrategyManager::onTickEvent(const EventPtr& event) {
         return;
     }
     
-    std::string symbol = tick->symbol;
+    const std::string& symbol = tick->symbol;
     
     // Find the corresponding strategy instance and invoke its handler
     {
         std::lock_guard<std::mutex> lock(mutex_);
         
-        auto it = strategy_instances_.find(symbol);
-        if (it == strategy_instances_.end()) {
+        StrategyInstance* instance = findInstance(tick->symbol_id, tick->exchange, symbol);
+        if (instance == nullptr) {
             // No corresponding strategy instance; return early
             return;
         }
         
-        if (!it->second.is_active || !it->second.strategy) {
+        if (!instance->is_active || !instance->strategy) {
             return;
         }
         
         // Call the strategy's onTick method to handle the data
-        it->second.strategy->onTick(symbol, *tick);
+        instance->strategy->onTick(symbol, *tick);
     }
 }
 
@@ -381,19 +448,19 @@ void StrategyManager::onTradeEvent(const EventPtr& event) {
         return;
     }
     
-    std::string symbol = trade->symbol;
+    const std::string& symbol = trade->symbol;
     
     // Find the corresponding strategy instance
     {
         std::lock_guard<std::mutex> lock(mutex_);
         
-        auto it = strategy_instances_.find(symbol);
-        if (it == strategy_instances_.end()) {
+        StrategyInstance* instance = findInstance(kInvalidSymbolId, trade->exchange, symbol);
+        if (instance == nullptr) {
             // No corresponding strategy instance; return early
             return;
         }
         
-        if (!it->second.is_active || !it->second.strategy) {
+        if (!instance->is_active || !instance->strategy) {
             return;
         }
         
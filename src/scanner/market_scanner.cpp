@@ -1,7 +1,16 @@
 #include "scanner/market_scanner.h"
 #include "managers/strategy_manager.h"
 #include "config/config_manager.h"
+#include "trading/tick_size_table.h"
+#include "data/kline_cache.h"
+#include "data/bar_store.h"
+#include "data/data_subscriber.h"
+#include "data/order_book_engine.h"
+#include "data/trading_calendar.h"
+#include "common/trading_session.h"
+#include "event/event.h"
 #include "utils/logger.h"
+#include "utils/exchange_time.h"
 #include <chrono>
 #include <thread>
 #include <algorithm>
@@ -10,6 +19,8 @@
 #include <mutex>
 #include <cmath>
 #include <sstream>
+#include <fstream>
+#include <filesystem>
 
 MarketScanner::MarketScanner() : running_(false) {
     LOG_INFO("Market scanner initialized");
@@ -17,12 +28,33 @@ MarketScanner::MarketScanner() : running_(false) {
 
 MarketScanner::~MarketScanner() {
     stop();
+    if (event_engine_ != nullptr && tick_handler_id_ >= 0) {
+        event_engine_->unregisterHandler(EventType::EVENT_TICK, tick_handler_id_);
+    }
+}
+
+void MarketScanner::initializeEventHandlers(IEventEngine* event_engine) {
+    if (event_engine == nullptr) {
+        LOG_ERROR("Event engine is null");
+        return;
+    }
+    
+    event_engine_ = event_engine;
+    tick_handler_id_ = event_engine_->registerHandler(
+        EventType::EVENT_TICK,
+        [this](const EventPtr& event) { this->onTickEvent(event); }
+    );
+    
+    LOG_INFO("Market scanner event handlers registered");
 }
 
 void MarketScanner::addExchange(std::shared_ptr<IExchange> exchange) {
     std::lock_guard<std::mutex> lock(exchanges_mutex_);
     if (exchange) {
         exchanges_.push_back(exchange);
+        if (running_) {
+            scan_threads_.emplace_back(&MarketScanner::scanLoop, this, exchange);
+        }
         LOG_INFO("Exchange added: " + exchange->getName());
     }
 }
@@ -39,30 +71,158 @@ void MarketScanner::start() {
              ", breakout_vol_ratio: " + std::to_string(scanner_params_.breakout_volume_ratio_min) +
              ", breakout_change: [" + std::to_string(scanner_params_.breakout_change_ratio_min) + 
              ", " + std::to_string(scanner_params_.breakout_change_ratio_max) + "]");
+    {
+        std::lock_guard<std::mutex> table_lock(table_mutex_);
+        kernel_params_.min_price = scanner_params_.min_price;
+        kernel_params_.max_price = scanner_params_.max_price;
+        kernel_params_.change_min = scanner_params_.breakout_change_ratio_min;
+        kernel_params_.change_max = scanner_params_.breakout_change_ratio_max;
+        kernel_params_.amplitude_min = scanner_params_.breakout_amplitude_min;
+        kernel_params_.min_turnover_rate = scanner_params_.min_turnover_rate;
+        kernel_params_.min_volume = static_cast<double>(scanner_params_.min_volume);
+        kernel_params_.volume_ratio_min = scanner_params_.breakout_volume_ratio_min;
+        kernel_params_.weight_volume = scanner_params_.breakout_score_weight_volume;
+        kernel_params_.weight_change = scanner_params_.breakout_score_weight_change;
+        kernel_params_.weight_speed = scanner_params_.breakout_score_weight_speed;
+        kernel_params_.weight_turnover = scanner_params_.breakout_score_weight_turnover;
+        kernel_params_.filter.reset();
+        kernel_params_.score.reset();
+    }
+    setScanExpressions(scanner_params_.filter_expression, scanner_params_.score_expression);
     
     std::lock_guard<std::mutex> lock(exchanges_mutex_);
     if (exchanges_.empty()) {
         LOG_ERROR("No exchanges configured");
         return;
     }
+    for (const auto& exchange : exchanges_) {
+        loadVolumeCurve(exchange);
+    }
     
     running_ = true;
-    scan_thread_ = std::make_unique<std::thread>(&MarketScanner::scanLoop, this);
+    // Started first: scan workers check it to decide whether to pick push candidates
+    if (scanner_params_.push_enabled) {
+        if (event_engine_ == nullptr) {
+            LOG_WARN("Scanner push mode needs event handlers; polling only");
+        } else {
+            push_thread_ = std::thread(&MarketScanner::pushLoop, this);
+        }
+    }
+    if (scanner_params_.volume_preload) {
+        preload_thread_ = std::thread(&MarketScanner::preloadLoop, this);
+    }
+    for (const auto& exchange : exchanges_) {
+        scan_threads_.emplace_back(&MarketScanner::scanLoop, this, exchange);
+    }
     
-    LOG_INFO("Market scanner started with " + std::to_string(exchanges_.size()) + " exchange(s)");
+    LOG_INFO("Market scanner started with " + std::to_string(exchanges_.size()) + " exchange(s), one worker each" +
+             (push_thread_.joinable() ? ", push mode on" : ""));
 }
 
 void MarketScanner::stop() {
     if (!running_) return;
     
-    running_ = false;
-    if (scan_thread_ && scan_thread_->joinable()) {
-        scan_thread_->join();
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        running_ = false;
+    }
+    stop_cv_.notify_all();
+    
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(exchanges_mutex_);
+        threads.swap(scan_threads_);
+    }
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    
+    // Taking the lock orders the wakeup after the push worker's flag check
+    {
+        std::lock_guard<std::mutex> lock(quotes_mutex_);
+    }
+    quotes_cv_.notify_all();
+    if (push_thread_.joinable()) {
+        push_thread_.join();
+    }
+    releasePushFeeds();
+    
+    {
+        std::lock_guard<std::mutex> lock(preload_mutex_);
+        preload_queue_.clear();
+    }
+    preload_cv_.notify_all();
+    if (preload_thread_.joinable()) {
+        preload_thread_.join();
     }
     
     LOG_INFO("Market scanner stopped");
 }
 
+bool MarketScanner::waitFor(int ms) {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    stop_cv_.wait_for(lock, std::chrono::milliseconds(ms), [this] { return !running_; });
+    return running_;
+}
+
+bool MarketScanner::setScanExpressions(const std::string& filter, const std::string& score) {
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        auto sourceOf = [](const std::shared_ptr<const ScanExpression>& expression) {
+            return expression ? expression->source() : std::string();
+        };
+        if (sourceOf(kernel_params_.filter) == filter && sourceOf(kernel_params_.score) == score) {
+            return true;
+        }
+    }
+    
+    // Compiled outside the lock: scans carry on with the current ones meanwhile
+    const auto constants = expressionConstants();
+    std::shared_ptr<const ScanExpression> compiled[2];
+    const std::string* sources[2] = {&filter, &score};
+    const ScanExpression::Kind kinds[2] = {ScanExpression::Kind::kFilter, ScanExpression::Kind::kScore};
+    for (int i = 0; i < 2; ++i) {
+        if (sources[i]->empty()) continue;
+        std::string error;
+        compiled[i] = ScanExpression::compile(*sources[i], kinds[i], constants, error);
+        if (!compiled[i]) {
+            LOG_ERROR(std::string("Scanner ") + (i == 0 ? "filter" : "score") + " expression rejected, " +
+                      "keeping the current one: " + error);
+            return false;
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        kernel_params_.filter = compiled[0];
+        kernel_params_.score = compiled[1];
+    }
+    auto describe = [](const std::shared_ptr<const ScanExpression>& expression) {
+        return expression ? std::to_string(expression->instructionCount()) + " instructions" : std::string("built in");
+    };
+    LOG_INFO("Scanner expressions set - filter: " + describe(compiled[0]) + ", score: " + describe(compiled[1]));
+    return true;
+}
+
+std::map<std::string, double> MarketScanner::expressionConstants() const {
+    return {
+        {"min_price", scanner_params_.min_price},
+        {"max_price", scanner_params_.max_price},
+        {"min_volume", scanner_params_.min_volume},
+        {"min_turnover_rate", scanner_params_.min_turnover_rate},
+        {"change_min", scanner_params_.breakout_change_ratio_min},
+        {"change_max", scanner_params_.breakout_change_ratio_max},
+        {"amplitude_min", scanner_params_.breakout_amplitude_min},
+        {"volume_ratio_min", scanner_params_.breakout_volume_ratio_min},
+        {"weight_volume", scanner_params_.breakout_score_weight_volume},
+        {"weight_change", scanner_params_.breakout_score_weight_change},
+        {"weight_speed", scanner_params_.breakout_score_weight_speed},
+        {"weight_turnover", scanner_params_.breakout_score_weight_turnover},
+    };
+}
+
 void MarketScanner::setWatchList(const std::string& exchange_name, const std::vector<std::string>& watch_list) {
     std::lock_guard<std::mutex> lock(watch_list_mutex_);
     watch_lists_[exchange_name] = watch_list;
@@ -83,10 +243,21 @@ MarketScanner::ScannerStatus MarketScanner::getStatus() const {
     
     std::vector<std::string> active_exchanges;
     std::map<std::string, int> watch_counts;
+    std::map<std::string, int64_t> last_scan_ms;
+    bool trading = false;
+    bool opening = false;
+    {
+        std::lock_guard<std::mutex> stats_lock(scan_stats_mutex_);
+        last_scan_ms = last_scan_ms_;
+    }
     
     for (const auto& exch : exchanges_) {
         if (exch && exch->isConnected()) {
             active_exchanges.push_back(exch->getName());
+            const std::string market = exch->getMarket();
+            trading = trading ||
+                      TradingCalendar::getInstance().phase(market, exchange_time::nowNs()) == MarketPhase::kContinuous;
+            opening = opening || isInOpeningPeriod(market);
             auto it = watch_lists_.find(exch->getName());
             if (it != watch_lists_.end()) {
                 watch_counts[exch->getName()] = it->second.size();
@@ -98,70 +269,113 @@ MarketScanner::ScannerStatus MarketScanner::getStatus() const {
         running_,
         watch_counts,
         qualified_stocks_,
-        isInTradingTime(),
-        isInOpeningPeriod(),
-        active_exchanges
+        trading,
+        opening,
+        active_exchanges,
+        last_scan_ms
     };
 }
 
-void MarketScanner::scanLoop() {
-    // Initialize watch lists for each exchange (fetched from the exchange)
-    {
-        std::lock_guard<std::mutex> lock(watch_list_mutex_);
-        std::lock_guard<std::mutex> exch_lock(exchanges_mutex_);
-        
-        for (const auto& exchange : exchanges_) {
-            if (!exchange || !exchange->isConnected()) {
+void MarketScanner::scanLoop(std::shared_ptr<IExchange> exchange) {
+    const std::string exch_name = exchange->getName();
+    const std::string market = exchange->getMarket();
+    bool watch_list_ready = false;
+    int trading_date = 0;
+    int calendar_date = 0;
+    MarketPhase last_phase = MarketPhase::kClosed;
+    bool full_scan_due = true;      // every stock is fetched again after a phase change
+    auto& calendar = TradingCalendar::getInstance();
+    
+    // Outlives single scans: the exchange counts requests across them
+    const RequestRateLimit snapshot_limit = exchange->getSnapshotRateLimit();
+    RequestWindow snapshot_window(static_cast<size_t>(std::max(0, snapshot_limit.max_requests)),
+                                  snapshot_limit.window_seconds * 1000LL);
+    
+    while (running_) {
+        try {
+            if (!exchange->isConnected()) {
+                // Other exchanges keep scanning; check back shortly
+                if (!waitFor(1000)) break;
                 continue;
             }
             
-            const auto& exch_name = exchange->getName();
-            if (watch_lists_.find(exch_name) == watch_lists_.end()) {
-                auto stock_list = exchange->getMarketStockList();
+            // Holidays of the market's year, from the cache or the exchange
+            int64_t now_ns = exchange_time::nowNs();
+            int today = marketDate(market, now_ns);
+            if (today != calendar_date) {
+                calendar_date = today;
+                calendar.load(exchange, today);
+            }
+            
+            // Initialize the watch list (fetched from the exchange) unless one was set
+            if (!watch_list_ready) {
+                {
+                    std::lock_guard<std::mutex> lock(watch_list_mutex_);
+                    watch_list_ready = watch_lists_.find(exch_name) != watch_lists_.end();
+                }
+                if (!watch_list_ready) {
+                    auto stock_list = exchange->getMarketStockList();
                     if (!stock_list.empty()) {
-                    watch_lists_[exch_name] = stock_list;
-                    LOG_INFO("Loaded " + std::to_string(stock_list.size()) + " stocks from " + exch_name);
-                    // Volume history will be loaded on-demand during scanning
-                    LOG_INFO("Volume history will be loaded on-demand during scanning");
+                        std::lock_guard<std::mutex> lock(watch_list_mutex_);
+                        watch_lists_.emplace(exch_name, stock_list);
+                        watch_list_ready = true;
+                        LOG_INFO("Loaded " + std::to_string(stock_list.size()) + " stocks from " + exch_name);
+                    }
                 }
             }
-        }
-    }
-    
-    while (running_) {
-        try {
-            if (/*isInTradingTime()*/ true) {
-                // Execute scan for each exchange
-                std::lock_guard<std::mutex> exch_lock(exchanges_mutex_);
-                for (const auto& exchange : exchanges_) {
-                    if (exchange && exchange->isConnected()) {
-                        performScan(exchange);
-                    }
+            
+            // Volume averages hold for one trading date; weekends and
+            // holidays keep the last trading date's averages and curve
+            if (watch_list_ready && today != trading_date &&
+                calendar.dayType(market, today) != TradeDayType::kClosed) {
+                trading_date = today;
+                beginTradingDate(exchange, today);
+            }
+            
+            MarketPhase phase = calendar.phase(market, now_ns);
+            if (phase != last_phase) {
+                LOG_INFO(exch_name + " market phase: " + marketPhaseName(phase));
+                last_phase = phase;
+                full_scan_due = true;
+            }
+            // Never sleep through a phase change
+            int64_t until_change_ms = calendar.untilPhaseChangeNs(market, now_ns) / 1000000 + 1;
+            
+            if (phase == MarketPhase::kContinuous || phase == MarketPhase::kPreOpen) {
+                auto started = std::chrono::steady_clock::now();
+                // Auctions have no activity to tier by yet
+                performScan(exchange, snapshot_window, full_scan_due || phase == MarketPhase::kPreOpen);
+                full_scan_due = false;
+                auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - started).count();
+                {
+                    std::lock_guard<std::mutex> lock(scan_stats_mutex_);
+                    last_scan_ms_[exch_name] = elapsed_ms;
                 }
                 
-                // Choose scan interval based on the time period
-                int interval_ms = isInOpeningPeriod() ? 
-                    OPENING_SCAN_INTERVAL_MS : NORMAL_SCAN_INTERVAL_MS;
-                
-                // Sleep in small increments to respond quickly to stop()
-                auto end_time = std::chrono::steady_clock::now() + 
-                               std::chrono::milliseconds(interval_ms);
-                while (running_ && std::chrono::steady_clock::now() < end_time) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                // Choose scan interval based on this market's time period;
+                // auctions only warm the table up for the open. Tiered scans
+                // come round at the hot tier's pace.
+                int64_t interval_ms = phase == MarketPhase::kPreOpen ? AUCTION_SCAN_INTERVAL_MS :
+                                      isInOpeningPeriod(market) ? OPENING_SCAN_INTERVAL_MS : NORMAL_SCAN_INTERVAL_MS;
+                if (phase == MarketPhase::kContinuous) {
+                    interval_ms /= tierCycles()[static_cast<size_t>(ScanTier::kWarm)];
                 }
+                if (!waitFor(static_cast<int>(std::min(interval_ms, until_change_ms)))) break;
             } else {
-                // Non-trading period, perform low-frequency checks
-                std::this_thread::sleep_for(std::chrono::milliseconds(NON_TRADING_SCAN_INTERVAL_MS));
+                // Break, close or holiday: nothing moves until the next phase
+                if (!waitFor(static_cast<int>(std::min<int64_t>(MAX_IDLE_WAIT_MS, until_change_ms)))) break;
             }
             
         } catch (const std::exception& e) {
-            LOG_ERROR("Scan loop error: " + std::string(e.what()));
-            std::this_thread::sleep_for(std::chrono::seconds(10));
+            LOG_ERROR("Scan loop error on " + exch_name + ": " + std::string(e.what()));
+            if (!waitFor(10000)) break;
         }
     }
 }
 
-void MarketScanner::performScan(const std::shared_ptr<IExchange>& exchange) {
+void MarketScanner::performScan(const std::shared_ptr<IExchange>& exchange, RequestWindow& snapshot_window,
+                                bool full) {
     if (!exchange) {
         return;
     }
@@ -180,28 +394,123 @@ void MarketScanner::performScan(const std::shared_ptr<IExchange>& exchange) {
         watch_list = it->second;
     }
     
-    LOG_INFO("Starting breakout scan for " + exch_name + " (" + std::to_string(watch_list.size()) + " stocks)...");
-    
-    // Fetch market data
-    auto results = batchFetchMarketData(exchange, watch_list);
+    // Ids of the watch list, looked up before the table is locked
+    const auto cycles = tierCycles();
+    std::vector<SymbolId> symbol_ids;
+    if (!full) {
+        symbol_ids.reserve(watch_list.size());
+        for (const auto& symbol : watch_list) {
+            symbol_ids.push_back(SymbolRegistry::getInstance().find(exch_name, symbol));
+        }
+    }
     
-    // Filter stocks that meet breakout criteria
-    std::vector<ScanResult> filtered_results;
-    for (auto& result : results) {
-        if (meetsSelectionCriteria(result)) {
-            filtered_results.push_back(result);
+    uint16_t exchange_index = 0;
+    uint32_t generation = 0;
+    std::vector<std::string> due;
+    std::array<size_t, kScanTiers> tier_counts{};
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        exchange_index = tableIndex(exchange);
+        generation = ++scan_generations_[exchange_index];
+        if (!full) {
+            // Stocks never fetched are due straight away
+            for (size_t i = 0; i < watch_list.size(); ++i) {
+                uint32_t row = 0;
+                if (!table_.findRow(symbol_ids[i], row) || table_.due(row, generation, cycles)) {
+                    due.push_back(watch_list[i]);
+                }
+            }
+            tier_counts = table_.tierCounts(exchange_index);
         }
     }
+    if (!full) {
+        LOG_INFO("Starting breakout scan for " + exch_name + " (" + std::to_string(due.size()) + " of " +
+                 std::to_string(watch_list.size()) + " stocks due; " + std::to_string(tier_counts[0]) + " hot, " +
+                 std::to_string(tier_counts[1]) + " warm, " + std::to_string(tier_counts[2]) + " cold)...");
+        watch_list.swap(due);
+    } else {
+        LOG_INFO("Starting breakout scan for " + exch_name + " (" + std::to_string(watch_list.size()) + " stocks)...");
+    }
     
-    // Sort by breakout score
-    std::sort(filtered_results.begin(), filtered_results.end(),
-        [](const ScanResult& a, const ScanResult& b) {
-            return a.score > b.score;
+    // Fetch market data. Each batch lands in the table, and the volume
+    // history of its stocks that pass every other criterion is loaded while
+    // later batches are still on the way.
+    const bool push = push_thread_.joinable();
+    std::set<SymbolId> history_tried;
+    size_t received = 0;
+    size_t changed = 0;
+    batchFetchMarketData(exchange, watch_list, snapshot_window,
+        [&](const std::map<std::string, Snapshot>& snapshots) {
+            // Only rows whose figures moved can newly need their history
+            std::vector<uint32_t> rows = ingestSnapshots(exch_name, exchange_index, generation, snapshots);
+            received += snapshots.size();
+            changed += rows.size();
+            if (rows.empty()) {
+                return;
+            }
+            std::vector<SymbolId> missing;
+            {
+                std::lock_guard<std::mutex> lock(table_mutex_);
+                missing = table_.prefilter(kernel_params_, exchangeFactors(exchange_index, generation),
+                                           exchange_index, std::move(rows));
+            }
+            loadMissingHistory(exchange, missing, history_tried);
         });
     
-    // Keep only the top_n results
-    if (filtered_results.size() > static_cast<size_t>(scanner_params_.top_n)) {
-        filtered_results.resize(scanner_params_.top_n);
+    // Score this exchange's fresh rows
+    std::vector<std::pair<SymbolId, double>> qualified;
+    std::vector<PushCandidate> push_candidates;
+    size_t universe = 0;
+    int64_t kernel_us = 0;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        auto started = std::chrono::steady_clock::now();
+        auto factors = exchangeFactors(exchange_index, generation);
+        table_.prefilter(kernel_params_, factors, exchange_index);
+        table_.score(kernel_params_, factors);
+        kernel_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        universe = table_.size();
+        
+        for (uint32_t row : table_.select(exchange_index, SnapshotTable::Selection::kQualified)) {
+            qualified.emplace_back(table_.symbolAt(row), table_.scoreAt(row));
+        }
+        
+        // Rising stocks in the price range may still break out before the next poll
+        if (push) {
+            for (uint32_t row : table_.top(exchange_index, SnapshotTable::Selection::kRising,
+                                           static_cast<size_t>(std::max(0, scanner_params_.push_symbols)))) {
+                SymbolId symbol_id = table_.symbolAt(row);
+                push_candidates.push_back({symbol_id, SymbolRegistry::getInstance().code(symbol_id), table_.scoreAt(row)});
+            }
+        }
+        completed_generations_[exchange_index] = generation;
+    }
+    
+    // Move the exchange's ranking to this scan: rescore the stocks that
+    // qualified, drop the ones that no longer do
+    RankingDelta delta;
+    std::vector<SymbolId> top_ids;
+    {
+        std::lock_guard<std::mutex> lock(live_mutex_);
+        auto& ranking = live_rankings_[exch_name].index;
+        ranking.setCapacity(static_cast<size_t>(std::max(0, scanner_params_.top_n)), delta);
+        std::set<SymbolId> current;
+        for (const auto& entry : qualified) {
+            ranking.update(entry.first, entry.second, delta);
+            current.insert(entry.first);
+        }
+        for (SymbolId symbol_id : ranking.symbols()) {
+            if (current.count(symbol_id) == 0) {
+                ranking.remove(symbol_id, delta);
+            }
+        }
+        top_ids = ranking.top();
+    }
+    std::vector<ScanResult> filtered_results = rankedResults(exchange, top_ids);
+    
+    if (push) {
+        updatePushSet(exch_name, push_candidates);
     }
     
     // Print breakout stock details
@@ -224,394 +533,898 @@ void MarketScanner::performScan(const std::shared_ptr<IExchange>& exchange) {
         LOG_INFO(ss.str());
     }
     
+    LOG_INFO("Scan completed for " + exch_name + ": found " + std::to_string(filtered_results.size()) + " breakout stocks (" +
+             std::to_string(qualified.size()) + " qualified, +" + std::to_string(delta.entered.size()) + " / -" +
+             std::to_string(delta.left.size()) + " in top " + std::to_string(scanner_params_.top_n) + "; " +
+             std::to_string(universe) + " stocks ranked in " + std::to_string(kernel_us) + "us; " +
+             std::to_string(changed) + " of " + std::to_string(received) + " snapshots changed)");
+    
+    publishResults(exch_name, filtered_results, delta);
+}
+
+void MarketScanner::publishResults(const std::string& exch_name, const std::vector<ScanResult>& results,
+                                   const RankingDelta& delta) {
     // Update qualified stocks list
     {
         std::lock_guard<std::mutex> lock(qualified_stocks_mutex_);
-        qualified_stocks_[exch_name].clear();
-        for (const auto& result : filtered_results) {
-            qualified_stocks_[exch_name].push_back(result.symbol);
+        auto& symbols = qualified_stocks_[exch_name];
+        symbols.clear();
+        for (const auto& result : results) {
+            symbols.push_back(result.symbol);
         }
     }
     
-    LOG_INFO("Scan completed for " + exch_name + ": found " + std::to_string(filtered_results.size()) + " breakout stocks");
-    
-    // Pass results to the StrategyManager
-    if (!filtered_results.empty()) {
-        StrategyManager::getInstance().processScanResults(filtered_results);
+    // Pass the ranking and its changes to the StrategyManager
+    if (!results.empty() || !delta.empty()) {
+        StrategyManager::getInstance().processRankingChanges(exch_name, results, delta.entered, delta.left);
     }
 }
 
-std::vector<ScanResult> MarketScanner::batchFetchMarketData(const std::shared_ptr<IExchange>& exchange, const std::vector<std::string>& symbols) {
-    std::vector<ScanResult> all_results;
-    
-    if (!exchange || !exchange->isConnected()) {
-        LOG_ERROR("Exchange not connected");
-        return all_results;
+void MarketScanner::onTickEvent(const EventPtr& event) {
+    const TickData* tick = event->getData<TickData>();
+    if (tick == nullptr) {
+        return;
     }
-    
-    // Fetch data in batches
-    for (size_t i = 0; i < symbols.size(); i += BATCH_SIZE) {
-        if (!running_) {
-            break;
+    {
+        std::lock_guard<std::mutex> lock(quotes_mutex_);
+        if (!push_feeds_.contains(tick->symbol_id)) {
+            return;
+        }
+        // Coalesced: only the latest quote of a symbol is evaluated
+        pending_quotes_[tick->symbol_id] = *tick;
+    }
+    quotes_cv_.notify_one();
+}
+
+void MarketScanner::pushLoop() {
+    while (running_) {
+        std::vector<TickData> quotes;
+        {
+            std::unique_lock<std::mutex> lock(quotes_mutex_);
+            quotes_cv_.wait(lock, [this] { return !running_ || !pending_quotes_.empty(); });
+            if (!running_) break;
+            quotes.reserve(pending_quotes_.size());
+            pending_quotes_.forEach([&](SymbolId, TickData& tick) {
+                quotes.push_back(std::move(tick));
+            });
+            pending_quotes_.clear();
         }
         
-        size_t end_idx = std::min(i + BATCH_SIZE, symbols.size());
-        std::vector<std::string> batch(symbols.begin() + i, symbols.begin() + end_idx);
-        
-        try {
-            // Call the exchange's batch snapshot API
-            auto snapshots = exchange->getBatchSnapshots(batch);
-            
-            // Convert to ScanResult and compute breakout metrics and score
-            for (const auto& pair : snapshots) {
-                ScanResult result = convertSnapshotToScanResult(pair.second, exchange->getName(), exchange);
-                result.score = calculateScore(result);
-                all_results.push_back(result);
-                
-                // Update historical data (used for next speed calculation)
-                updateVolumeHistory(result.symbol, pair.second.volume, pair.second.last_price);
-                
-                // Cache the current snapshot (used to calculate speed)
-                {
-                    std::lock_guard<std::mutex> lock(last_snapshots_mutex_);
-                    last_snapshots_[result.symbol] = pair.second;
-                }
+        for (const auto& tick : quotes) {
+            try {
+                evaluateQuote(tick);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Push evaluation error for " + tick.symbol + ": " + std::string(e.what()));
             }
-            
-            // Pause between batches to avoid too many requests
-            std::this_thread::sleep_for(std::chrono::milliseconds(300));
-            
-        } catch (const std::exception& e) {
-            LOG_ERROR("Failed to fetch batch [" + std::to_string(i) + ", " + std::to_string(end_idx) + "): " + std::string(e.what()));
         }
     }
-    
-    return all_results;
 }
 
-ScanResult MarketScanner::convertSnapshotToScanResult(const Snapshot& snapshot, 
-                                                       const std::string& exchange_name,
-                                                       std::shared_ptr<IExchange> exchange) {
-    ScanResult result;
-    result.symbol = snapshot.symbol;
-    result.stock_name = snapshot.name;
-    result.price = snapshot.last_price;
-    result.change_ratio = (snapshot.pre_close > 0) ? 
-        (snapshot.last_price - snapshot.pre_close) / snapshot.pre_close : 0.0;
-    result.volume = snapshot.volume;
-    result.turnover_rate = snapshot.turnover_rate;
-    result.exchange_name = exchange_name;
-    result.exchange = exchange;
-    
-    // === Breakout detection metric calculations ===
+void MarketScanner::evaluateQuote(const TickData& tick) {
+    std::shared_ptr<IExchange> exchange;
+    {
+        std::lock_guard<std::mutex> lock(exchanges_mutex_);
+        for (const auto& exch : exchanges_) {
+            if (exch && exch->getName() == tick.exchange) {
+                exchange = exch;
+                break;
+            }
+        }
+    }
+    if (!exchange) {
+        return;
+    }
     
-    // 1. Volume ratio - lazy-loaded, only calculated for stocks passing basic filters
-    // (avoid fetching K-lines for all stocks)
-    result.volume_ratio = -1.0;  // mark as not calculated
+    // Apply the push to the symbol's row; unchanged quotes are not re-scored
+    uint32_t row = 0;
+    std::vector<SymbolId> missing;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        if (!table_.updateQuote(tick.symbol_id, tick) || !table_.findRow(tick.symbol_id, row)) {
+            return;
+        }
+        missing = table_.prefilter(kernel_params_, exchangeFactors(), tableIndex(exchange), row, row + 1);
+    }
+    std::set<SymbolId> history_tried;
+    loadMissingHistory(exchange, missing, history_tried);
     
-    // 2. Amplitude (intraday volatility)
-    if (snapshot.open_price > 0) {
-        result.amplitude = (snapshot.high_price - snapshot.low_price) / snapshot.open_price;
+    // Scored as in a poll; speed stays relative to the last poll
+    bool qualifies = false;
+    double score = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        auto factors = exchangeFactors();
+        table_.prefilter(kernel_params_, factors, tableIndex(exchange), row, row + 1);
+        table_.score(kernel_params_, factors, row, row + 1);
+        qualifies = table_.qualified(row);
+        score = table_.scoreAt(row);
     }
     
-    // 3. Speed (price change rate compared to last scan)
-    result.speed = calculateSpeed(snapshot.symbol, snapshot.last_price);
+    RankingDelta delta;
+    std::vector<SymbolId> top_ids;
+    {
+        std::lock_guard<std::mutex> lock(live_mutex_);
+        auto it = live_rankings_.find(tick.exchange);
+        if (it == live_rankings_.end()) {
+            return;
+        }
+        auto& ranking = it->second.index;
+        if (qualifies) {
+            ranking.update(tick.symbol_id, score, delta);
+        } else {
+            ranking.remove(tick.symbol_id, delta);
+        }
+        // Moves within the top_n wait for the next poll
+        if (delta.empty()) {
+            return;
+        }
+        top_ids = ranking.top();
+    }
     
-    // 4. Bid/ask volume ratio
-    result.bid_ask_ratio = calculateBidAskRatio(snapshot);
+    for (SymbolId symbol_id : delta.entered) {
+        LOG_INFO(SymbolRegistry::getInstance().code(symbol_id) + " entered the breakout ranking of " + tick.exchange +
+                 " on a quote push of " + tick.symbol + " (score " + std::to_string(score) + ")");
+    }
+    for (SymbolId symbol_id : delta.left) {
+        LOG_INFO(SymbolRegistry::getInstance().code(symbol_id) + " left the breakout ranking of " + tick.exchange +
+                 " on a quote push of " + tick.symbol);
+    }
+    publishResults(tick.exchange, rankedResults(exchange, top_ids), delta);
+}
+
+void MarketScanner::updatePushSet(const std::string& exch_name, const std::vector<PushCandidate>& candidates) {
+    std::vector<std::string> to_subscribe;
+    std::vector<std::string> to_release;
+    {
+        std::lock_guard<std::mutex> lock(live_mutex_);
+        auto& ranking = live_rankings_[exch_name];
+        
+        std::set<SymbolId> wanted;
+        for (const auto& candidate : candidates) {
+            wanted.insert(candidate.symbol_id);
+            if (ranking.pushed.count(candidate.symbol_id) == 0) {
+                to_subscribe.push_back(candidate.symbol);
+            }
+        }
+        for (SymbolId symbol_id : ranking.pushed) {
+            if (wanted.count(symbol_id) == 0) {
+                to_release.push_back(SymbolRegistry::getInstance().code(symbol_id));
+            }
+        }
+        
+        ranking.pushed.swap(wanted);
+        
+        std::lock_guard<std::mutex> quotes_lock(quotes_mutex_);
+        push_feeds_.clear();
+        for (const auto& pair : live_rankings_) {
+            for (SymbolId symbol_id : pair.second.pushed) {
+                push_feeds_[symbol_id] = true;
+            }
+        }
+    }
     
-    // 5. Price information
-    result.open_price = snapshot.open_price;
-    result.high_price = snapshot.high_price;
-    result.low_price = snapshot.low_price;
-    result.pre_close = snapshot.pre_close;
+    // Reference-counted, so feeds other consumers hold are left alone
+    auto& subscriber = DataSubscriber::getInstance();
+    for (const auto& symbol : to_subscribe) {
+        subscriber.subscribeTick(exch_name, symbol);
+    }
+    for (const auto& symbol : to_release) {
+        subscriber.unsubscribeTick(exch_name, symbol);
+    }
     
-    // 6. Ratio to daily high (smaller means closer to new high, indicating lifting)
-    if (snapshot.high_price > 0) {
-        result.price_vs_high = (snapshot.high_price - snapshot.last_price) / snapshot.high_price;
+    if (!to_subscribe.empty() || !to_release.empty()) {
+        LOG_INFO("Push set of " + exch_name + ": " + std::to_string(candidates.size()) + " symbols (+" +
+                 std::to_string(to_subscribe.size()) + " / -" + std::to_string(to_release.size()) + ")");
+    }
+}
+
+void MarketScanner::releasePushFeeds() {
+    std::map<std::string, std::set<SymbolId>> pushed;
+    {
+        std::lock_guard<std::mutex> lock(live_mutex_);
+        for (auto& pair : live_rankings_) {
+            pushed[pair.first].swap(pair.second.pushed);
+        }
+        live_rankings_.clear();
+        
+        std::lock_guard<std::mutex> quotes_lock(quotes_mutex_);
+        push_feeds_.clear();
+        pending_quotes_.clear();
     }
     
-    return result;
+    auto& subscriber = DataSubscriber::getInstance();
+    for (const auto& pair : pushed) {
+        for (SymbolId symbol_id : pair.second) {
+            subscriber.unsubscribeTick(pair.first, SymbolRegistry::getInstance().code(symbol_id));
+        }
+    }
 }
 
-std::pair<int, int> MarketScanner::getCurrentTime() const {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto tm = *std::localtime(&time_t);
-    return {tm.tm_hour, tm.tm_min};
+std::vector<ScanResult> MarketScanner::rankedResults(const std::shared_ptr<IExchange>& exchange,
+                                                     const std::vector<SymbolId>& symbol_ids) {
+    std::vector<ScanResult> results;
+    results.reserve(symbol_ids.size());
+    std::lock_guard<std::mutex> lock(table_mutex_);
+    for (SymbolId symbol_id : symbol_ids) {
+        uint32_t row = 0;
+        if (table_.findRow(symbol_id, row)) {
+            results.push_back(toScanResult(table_.row(row), exchange));
+        }
+    }
+    return results;
 }
 
-bool MarketScanner::isInTradingTime() const {
-    auto time_pair = getCurrentTime();
-    int hour = time_pair.first;
-    int minute = time_pair.second;
-    int current_min = hour * 60 + minute;
+size_t MarketScanner::batchFetchMarketData(const std::shared_ptr<IExchange>& exchange,
+                                           const std::vector<std::string>& symbols,
+                                           RequestWindow& snapshot_window,
+                                           const std::function<void(const std::map<std::string, Snapshot>&)>& on_batch) {
+    if (!exchange || !exchange->isConnected()) {
+        LOG_ERROR("Exchange not connected");
+        return 0;
+    }
     
-    // Hong Kong market: 9:30-12:00 (morning), 13:00-16:00 (afternoon)
-    int morning_open = 9 * 60 + 30;    // 9:30
-    int morning_close = 12 * 60;       // 12:00
-    int afternoon_open = 13 * 60;      // 13:00
-    int afternoon_close = 16 * 60;     // 16:00
+    size_t batch_size = BATCH_SIZE;
+    int max_symbols = exchange->getSnapshotRateLimit().max_symbols;
+    if (max_symbols > 0) {
+        batch_size = std::min(batch_size, static_cast<size_t>(max_symbols));
+    }
+    const size_t window = static_cast<size_t>(std::max(1, scanner_params_.snapshot_requests_in_flight));
+    const size_t batch_count = (symbols.size() + batch_size - 1) / batch_size;
+    
+    // Replies land on exchange threads and are queued here; late ones for a
+    // batch already given up on find it gone from `pending`
+    struct Landed {
+        size_t batch;
+        bool success;
+        std::map<std::string, Snapshot> snapshots;
+    };
+    struct Pipeline {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Landed> landed;
+    };
+    auto pipeline = std::make_shared<Pipeline>();
+    std::map<size_t, std::chrono::steady_clock::time_point> pending;   // batch -> sent at
     
-    bool is_morning = current_min >= morning_open && current_min <= morning_close;
-    bool is_afternoon = current_min >= afternoon_open && current_min <= afternoon_close;
+    auto nowMs = []() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
     
-    return is_morning || is_afternoon;
-}
-
-bool MarketScanner::isInOpeningPeriod() const {
-    auto time_pair = getCurrentTime();
-    int hour = time_pair.first;
-    int minute = time_pair.second;
+    size_t next = 0;
+    size_t received = 0;
+    while (running_ && (next < batch_count || !pending.empty())) {
+        // Top up the window as far as the rate limit allows
+        int64_t wait_ms = 0;
+        while (next < batch_count && pending.size() < window) {
+            wait_ms = snapshot_window.waitMs(nowMs());
+            if (wait_ms > 0) {
+                break;
+            }
+            
+            size_t begin_idx = next * batch_size;
+            size_t end_idx = std::min(begin_idx + batch_size, symbols.size());
+            std::vector<std::string> batch(symbols.begin() + begin_idx, symbols.begin() + end_idx);
+            size_t batch_no = next++;
+            
+            snapshot_window.record(nowMs());
+            pending[batch_no] = std::chrono::steady_clock::now();
+            try {
+                bool sent = exchange->requestBatchSnapshots(batch,
+                    [pipeline, batch_no](bool success, std::map<std::string, Snapshot> snapshots) {
+                        {
+                            std::lock_guard<std::mutex> lock(pipeline->mutex);
+                            pipeline->landed.push_back({batch_no, success, std::move(snapshots)});
+                        }
+                        pipeline->cv.notify_one();
+                    });
+                if (!sent) {
+                    pending.erase(batch_no);
+                    LOG_ERROR("Failed to request batch [" + std::to_string(begin_idx) + ", " + std::to_string(end_idx) + ")");
+                }
+            } catch (const std::exception& e) {
+                pending.erase(batch_no);
+                LOG_ERROR("Failed to fetch batch [" + std::to_string(begin_idx) + ", " + std::to_string(end_idx) + "): " + std::string(e.what()));
+            }
+        }
+        
+        // Wait for a reply, or for the rate limit to admit the next request
+        std::deque<Landed> landed;
+        {
+            std::unique_lock<std::mutex> lock(pipeline->mutex);
+            if (pipeline->landed.empty() && !pending.empty()) {
+                // Short slices keep stop() responsive while replies are outstanding
+                int64_t timeout_ms = wait_ms > 0 ? std::min<int64_t>(wait_ms, 500) : 500;
+                pipeline->cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                                      [&]() { return !pipeline->landed.empty(); });
+            }
+            landed.swap(pipeline->landed);
+        }
+        if (landed.empty() && pending.empty() && wait_ms > 0) {
+            if (!waitFor(static_cast<int>(wait_ms))) break;
+        }
+        
+        for (auto& item : landed) {
+            if (pending.erase(item.batch) == 0) {
+                continue;
+            }
+            if (!item.success) {
+                LOG_ERROR("Snapshot batch " + std::to_string(item.batch) + " of " + exchange->getName() + " failed");
+                continue;
+            }
+            received += item.snapshots.size();
+            on_batch(item.snapshots);
+        }
+        
+        // Give up on batches the exchange never answered
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (now - it->second >= std::chrono::milliseconds(SNAPSHOT_TIMEOUT_MS)) {
+                LOG_ERROR("Snapshot batch " + std::to_string(it->first) + " of " + exchange->getName() + " timed out");
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
     
-    // Opening periods: first 30 minutes after open (9:30-10:00) and after afternoon open (13:00-13:30)
-    // These windows are when breakout stocks are most likely to appear
-    bool morning_opening = (hour == 9 && minute >= 30) || (hour == 10 && minute == 0);
-    bool afternoon_opening = (hour == 13 && minute < 30);
-    return morning_opening || afternoon_opening;
+    return received;
 }
 
-bool MarketScanner::meetsSelectionCriteria(ScanResult& result) {
-    // ===== Breakout stock selection criteria for HK market =====
-    // Core idea: find stocks with sudden volume surge and rapid price increase
+std::vector<uint32_t> MarketScanner::ingestSnapshots(const std::string& exch_name, uint16_t exchange_index,
+                                                      uint32_t generation,
+                                                      const std::map<std::string, Snapshot>& snapshots) {
+    // Rows are keyed by id; an adapter that left it unstamped gets it interned here
+    std::map<std::string, Snapshot> stamped;
+    const std::map<std::string, Snapshot>* batch = &snapshots;
+    for (const auto& pair : snapshots) {
+        if (pair.second.symbol_id != kInvalidSymbolId) continue;
+        if (batch == &snapshots) {
+            stamped = snapshots;
+            batch = &stamped;
+        }
+        Snapshot& snapshot = stamped[pair.first];
+        snapshot.symbol_id = SymbolRegistry::getInstance().intern(exch_name, pair.first);
+        if (snapshot.symbol_id == kInvalidSymbolId) {
+            stamped.erase(pair.first);   // registry full
+        }
+    }
     
-    // 1. Price filter (avoid penny stocks and extremely large-cap stocks)
-    if (result.price < scanner_params_.min_price || result.price > scanner_params_.max_price) {
-        return false;
+    // Book ratios and tick sizes go to their own engines before the table
+    // is locked, each under one lock for the whole batch
+    std::vector<SymbolId> symbol_ids;
+    std::vector<double> book_ratios;
+    std::vector<std::pair<SymbolId, Price>> tick_sizes;
+    symbol_ids.reserve(batch->size());
+    book_ratios.reserve(batch->size());
+    for (const auto& pair : *batch) {
+        if (pair.second.tick_size > 0) {
+            tick_sizes.emplace_back(pair.second.symbol_id, Price::fromDouble(pair.second.tick_size));
+        }
+        symbol_ids.push_back(pair.second.symbol_id);
+        book_ratios.push_back(calculateBidAskRatio(pair.second));
+    }
+    // The full book, where one is subscribed, outweighs level 1
+    OrderBookEngine::getInstance().getBidAskRatios(symbol_ids, BOOK_RATIO_LEVELS, book_ratios);
+    if (!tick_sizes.empty()) {
+        TickSizeTable::getInstance().setTickSizes(tick_sizes);
     }
     
-    // 2. Change range: must be positive
-    //    Too low (<2%) = not strong enough, too high (>10%) = high risk of chasing a peak
-    if (result.change_ratio < scanner_params_.breakout_change_ratio_min || 
-        result.change_ratio > scanner_params_.breakout_change_ratio_max) {
-        return false;
+    std::vector<uint32_t> changed;
+    std::lock_guard<std::mutex> lock(table_mutex_);
+    size_t i = 0;
+    for (const auto& pair : *batch) {
+        uint32_t row = 0;
+        if (table_.update(exchange_index, generation, pair.second, book_ratios[i++], row)) {
+            changed.push_back(row);
+        }
     }
+    return changed;
+}
+
+ScanResult MarketScanner::toScanResult(const ScanRow& row, const std::shared_ptr<IExchange>& exchange) const {
+    ScanResult result;
+    result.symbol_id = row.symbol_id;
+    result.symbol = SymbolRegistry::getInstance().code(row.symbol_id);
+    result.stock_name = row.name;
+    result.price = row.price;
+    result.change_ratio = row.change_ratio;
+    result.volume = row.volume;
+    result.turnover_rate = row.turnover_rate;
+    result.score = row.score;
+    result.exchange_name = exchange ? exchange->getName() : SymbolRegistry::getInstance().exchange(row.symbol_id);
+    result.exchange = exchange;
     
-    // 3. Volume ratio condition: lazy load - calculate only for stocks passing basic filters
-    //    Abnormal volume surge is the core breakout signal
-    if (result.volume_ratio < 0) {
-        // Lazy-load volume ratio; use exchange pointer in result to avoid extra locking
-        result.volume_ratio = calculateVolumeRatio(result.symbol, result.volume, result.exchange);
+    // === Breakout detection metrics ===
+    result.volume_ratio = row.volume_ratio;
+    result.amplitude = row.amplitude;
+    result.speed = row.speed;
+    result.bid_ask_ratio = row.bid_ask_ratio;
+    result.open_price = row.open_price;
+    result.high_price = row.high_price;
+    result.low_price = row.low_price;
+    result.pre_close = row.pre_close;
+    result.price_vs_high = row.price_vs_high;
+    return result;
+}
+
+uint16_t MarketScanner::tableIndex(const std::shared_ptr<IExchange>& exchange) {
+    uint16_t index = table_.exchangeIndex(exchange->getName());
+    if (index >= table_markets_.size()) {
+        table_markets_.resize(index + 1);
+        scan_generations_.resize(index + 1, 0);
+        completed_generations_.resize(index + 1, 0);
+        table_curves_.resize(index + 1);
     }
-    if (result.volume_ratio < scanner_params_.breakout_volume_ratio_min) {
-        return false;
+    table_markets_[index] = exchange->getMarket();
+    return index;
+}
+
+std::array<uint32_t, kScanTiers> MarketScanner::tierCycles() const {
+    std::array<uint32_t, kScanTiers> cycles;
+    cycles.fill(1);
+    if (scanner_params_.tiered_scan) {
+        uint32_t warm = static_cast<uint32_t>(std::max(1, scanner_params_.tier_hot_speedup));
+        cycles[static_cast<size_t>(ScanTier::kWarm)] = warm;
+        cycles[static_cast<size_t>(ScanTier::kCold)] = warm * static_cast<uint32_t>(std::max(1, scanner_params_.tier_cold_slowdown));
     }
-    
-    // 4. Amplitude condition: require volatility to provide trading space
-    if (result.amplitude < scanner_params_.breakout_amplitude_min) {
-        return false;
+    return cycles;
+}
+
+std::vector<ScanExchangeFactors> MarketScanner::exchangeFactors(int scanning_index, uint32_t generation) const {
+    int64_t now_ns = exchange_time::nowNs();
+    const auto& calendar = TradingCalendar::getInstance();
+    const auto cycles = tierCycles();
+    std::vector<ScanExchangeFactors> factors(table_markets_.size());
+    for (size_t i = 0; i < factors.size(); ++i) {
+        // A scan only ranks rows it has refreshed or that are not due yet in
+        // their tier; elsewhere the last finished scan's view still counts
+        factors[i].min_generation = static_cast<int>(i) == scanning_index ? generation : completed_generations_[i];
+        factors[i].tier_cycles = cycles;
+        
+        const VolumeCurve& curve = table_curves_[i];
+        const std::string& market = table_markets_[i];
+        if (curve.valid()) {
+            // A half day is expected to trade only the share of its own minutes
+            auto sessions = calendar.sessions(market, marketDate(market, now_ns));
+            int elapsed = elapsedSessionMinutes(sessions, marketMinuteOfDay(market, now_ns));
+            int day_minutes = sessionMinutes(sessions);
+            factors[i].volume_thresholds = curve.thresholds();
+            for (size_t b = 0; b < kVolumeBuckets; ++b) {
+                factors[i].volume_extrapolation[b] = curve.expectedShare(b, day_minutes) / curve.expectedShare(b, elapsed);
+            }
+        } else {
+            factors[i].volume_extrapolation.fill(volumeExtrapolation(market, now_ns));
+        }
+        // Breakouts at the open are likelier to sustain
+        factors[i].score_multiplier = isInOpeningPeriod(market) ? 1.1 : 1.0;
     }
-    
-    // 5. Turnover rate: market attention and liquidity
-    if (result.turnover_rate < scanner_params_.min_turnover_rate) {
-        return false;
+    return factors;
+}
+
+void MarketScanner::loadMissingHistory(const std::shared_ptr<IExchange>& exchange,
+                                       const std::vector<SymbolId>& symbol_ids,
+                                       std::set<SymbolId>& tried) {
+    for (SymbolId symbol_id : symbol_ids) {
+        if (!running_) break;
+        // Symbols without history are not asked for again within one scan
+        if (!tried.insert(symbol_id).second) continue;
+        double avg_volume = loadAverageVolume(symbol_id, SymbolRegistry::getInstance().code(symbol_id), exchange);
+        if (avg_volume > 0) {
+            std::lock_guard<std::mutex> lock(table_mutex_);
+            table_.setAverageVolume(symbol_id, avg_volume);
+        }
+    }
+}
+
+bool MarketScanner::isInOpeningPeriod(const std::string& market) const {
+    int64_t now_ns = exchange_time::nowNs();
+    auto sessions = TradingCalendar::getInstance().sessions(market, marketDate(market, now_ns));
+    int current_min = marketMinuteOfDay(market, now_ns);
+    for (const auto& session : sessions) {
+        if (current_min >= session.open_min && current_min < session.open_min + 30) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double MarketScanner::loadAverageVolume(SymbolId symbol_id, const std::string& symbol,
+                                        const std::shared_ptr<IExchange>& exchange) {
+    if (!exchange) {
+        return 0.0;
     }
+    int trading_date = marketDate(exchange->getMarket(), exchange_time::nowNs());
     
-    // 6. Absolute volume filter
-    if (result.volume < scanner_params_.min_volume) {
-        return false;
+    // Preloaded or loaded earlier today
+    {
+        std::lock_guard<std::mutex> lock(volume_history_mutex_);
+        const VolumeHistory* history = volume_history_.find(symbol_id);
+        if (history != nullptr && history->trading_date == trading_date && history->avg_volume > 0) {
+            return static_cast<double>(history->avg_volume);
+        }
     }
     
-    // 7. Buy/sell force: bids should be stronger than asks
-    if (result.bid_ask_ratio < 0.8) {
-        return false;  // Selling pressure is too high; not suitable for chasing
+    if (!exchange->isConnected()) {
+        return 0.0;
     }
     
-    // 8. Distance to daily high: avoid stocks that have pulled back significantly
-    //    Price near intraday high => major players still pushing up
-    if (result.price_vs_high > 0.05) {
-        return false;  // More than 5% from high; may have pulled back
+    int64_t avg_volume = fetchAverageVolume(exchange, symbol, trading_date);
+    if (avg_volume > 0) {
+        std::lock_guard<std::mutex> lock(volume_history_mutex_);
+        volume_history_[symbol_id] = {avg_volume, trading_date};
+    }
+    return static_cast<double>(avg_volume);
+}
+
+int64_t MarketScanner::fetchAverageVolume(const std::shared_ptr<IExchange>& exchange, const std::string& symbol,
+                                          int trading_date) {
+    try {
+        auto klines = KLineCache::getInstance().getHistoryKLine(exchange, symbol, "K_DAY", VOLUME_HISTORY_DAYS + 1);
+        
+        // Only completed sessions count: before the open the last bar is the
+        // previous session, during it today's partial bar
+        const std::string market = exchange->getMarket();
+        int64_t total = 0;
+        int days = 0;
+        for (auto it = klines.rbegin(); it != klines.rend() && days < VOLUME_HISTORY_DAYS; ++it) {
+            bool current = it->exchange_ts_ns > 0 ? marketDate(market, it->exchange_ts_ns) >= trading_date
+                                                  : it == klines.rbegin();
+            if (current) continue;
+            total += it->volume;
+            ++days;
+        }
+        return days > 0 ? total / days : 0;
+    } catch (const std::exception& e) {
+        LOG_WARN("Failed to load volume history for " + symbol + ": " + e.what());
+        return 0;
+    }
+}
+
+double MarketScanner::volumeExtrapolation(const std::string& market, int64_t now_ns) {
+    // The opening minutes would extrapolate wildly; one minute is the floor
+    int minute = marketMinuteOfDay(market, now_ns);
+    if (tradingSessions(market).empty()) {
+        return 24.0 * 60.0 / std::max(1, minute);
+    }
+    // Trading minutes only, on the calendar's sessions for the day
+    auto sessions = TradingCalendar::getInstance().sessions(market, marketDate(market, now_ns));
+    int day_minutes = sessionMinutes(sessions);
+    if (day_minutes <= 0) {
+        return 1.0;
+    }
+    return static_cast<double>(day_minutes) / std::max(1, elapsedSessionMinutes(sessions, minute));
+}
+
+double MarketScanner::calculateBidAskRatio(const Snapshot& snapshot) const {
+    if (snapshot.ask_volume_1 <= 0) {
+        return (snapshot.bid_volume_1 > 0) ? 10.0 : 1.0;
+    }
+    return (double)snapshot.bid_volume_1 / snapshot.ask_volume_1;
+}
+
+void MarketScanner::beginTradingDate(const std::shared_ptr<IExchange>& exchange, int trading_date) {
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        table_.resetAverageVolumes(tableIndex(exchange));
     }
     
-    return true;
+    if (!preload_thread_.joinable()) {
+        return;
+    }
+    PreloadRequest request;
+    request.exchange = exchange;
+    request.trading_date = trading_date;
+    {
+        std::lock_guard<std::mutex> lock(watch_list_mutex_);
+        auto it = watch_lists_.find(exchange->getName());
+        if (it != watch_lists_.end()) {
+            request.symbols = it->second;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(preload_mutex_);
+        preload_queue_.push_back(std::move(request));
+    }
+    preload_cv_.notify_one();
 }
 
-double MarketScanner::calculateScore(const ScanResult& result) const {
-    // ===== Composite scoring algorithm for HK market breakouts =====
-    // Normalize each dimension to [0, 1] and compute weighted sum
-    double score = 0.0;
+void MarketScanner::preloadLoop() {
+    while (true) {
+        PreloadRequest request;
+        {
+            std::unique_lock<std::mutex> lock(preload_mutex_);
+            preload_cv_.wait(lock, [this] { return !running_ || !preload_queue_.empty(); });
+            if (!running_) break;
+            request = std::move(preload_queue_.front());
+            preload_queue_.pop_front();
+        }
+        
+        try {
+            preloadVolumeHistory(request);
+            refreshVolumeCurve(request);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Volume history preload failed for " + request.exchange->getName() + ": " + e.what());
+        }
+    }
+}
+
+void MarketScanner::preloadVolumeHistory(const PreloadRequest& request) {
+    const auto& exchange = request.exchange;
+    const std::string exch_name = exchange->getName();
+    const int trading_date = request.trading_date;
+    auto started = std::chrono::steady_clock::now();
+    auto elapsedMs = [&started]() {
+        return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count());
+    };
     
-    // 1. Volume ratio score (weight 35%): higher is better, diminishing returns after 10x
-    double volume_score = std::min(1.0, result.volume_ratio / 10.0);
-    score += volume_score * scanner_params_.breakout_score_weight_volume;
+    size_t cached = loadVolumeCache(exch_name, trading_date);
     
-    // 2. Change score (weight 25%): 3-6% is the sweet spot
-    double change_score = 0.0;
-    if (result.change_ratio >= 0.03 && result.change_ratio <= 0.06) {
-        change_score = 1.0;  // sweet spot
-    } else if (result.change_ratio > 0.06) {
-        change_score = std::max(0.0, 1.0 - (result.change_ratio - 0.06) / 0.04);
-    } else {
-        change_score = result.change_ratio / 0.03;
+    // Watch list symbols the cache lacks
+    std::vector<std::pair<SymbolId, std::string>> missing;
+    {
+        auto& registry = SymbolRegistry::getInstance();
+        std::lock_guard<std::mutex> lock(volume_history_mutex_);
+        for (const auto& symbol : request.symbols) {
+            SymbolId symbol_id = registry.intern(exch_name, symbol);
+            const VolumeHistory* history = volume_history_.find(symbol_id);
+            if (history == nullptr || history->trading_date != trading_date) {
+                missing.emplace_back(symbol_id, symbol);
+            }
+        }
+    }
+    if (missing.empty()) {
+        LOG_INFO("Volume history of " + exch_name + " for " + std::to_string(trading_date) + ": " +
+                 std::to_string(cached) + " averages loaded from cache in " + elapsedMs() + "ms");
+        return;
     }
-    score += change_score * scanner_params_.breakout_score_weight_change;
     
-    // 3. Speed score (weight 25%): faster speed indicates stronger momentum
-    double speed_score = std::min(1.0, std::max(0.0, result.speed * 100.0));
-    score += speed_score * scanner_params_.breakout_score_weight_speed;
+    // Every symbol fetched may count against the exchange's history quota;
+    // what does not fit is left to on-demand loads of scan candidates
+    int used = 0;
+    int remaining = 0;
+    if (exchange->getHistoryQuota(used, remaining) && static_cast<size_t>(std::max(0, remaining)) < missing.size()) {
+        LOG_WARN("History quota of " + exch_name + " has " + std::to_string(remaining) + " symbols left (" +
+                 std::to_string(used) + " used); preloading " + std::to_string(std::max(0, remaining)) + " of " +
+                 std::to_string(missing.size()));
+        missing.resize(static_cast<size_t>(std::max(0, remaining)));
+    }
     
-    // 4. Turnover score (weight 15%)
-    double turnover_score = std::min(1.0, result.turnover_rate / 0.10);
-    score += turnover_score * scanner_params_.breakout_score_weight_turnover;
+    LOG_INFO("Preloading volume history of " + exch_name + ": " + std::to_string(cached) + " cached, " +
+             std::to_string(missing.size()) + " to fetch");
+    
+    // Workers share the exchange's request window and pull symbols until
+    // none are left
+    const RequestRateLimit limit = exchange->getHistoryRateLimit();
+    RequestWindow window(static_cast<size_t>(std::max(0, limit.max_requests)), limit.window_seconds * 1000LL);
+    std::mutex window_mutex;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> fetched{0};
+    auto work = [&]() {
+        for (size_t i = next++; i < missing.size() && running_; i = next++) {
+            while (running_) {
+                int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                int64_t wait_ms = 0;
+                {
+                    std::lock_guard<std::mutex> lock(window_mutex);
+                    wait_ms = window.waitMs(now_ms);
+                    if (wait_ms == 0) {
+                        window.record(now_ms);
+                    }
+                }
+                if (wait_ms == 0) break;
+                waitFor(static_cast<int>(std::min<int64_t>(wait_ms, 1000)));
+            }
+            if (!running_) break;
+            
+            int64_t avg_volume = fetchAverageVolume(exchange, missing[i].second, trading_date);
+            if (avg_volume > 0) {
+                std::lock_guard<std::mutex> lock(volume_history_mutex_);
+                volume_history_[missing[i].first] = {avg_volume, trading_date};
+                ++fetched;
+            }
+        }
+    };
     
-    // 5. Bonus: overwhelming bid advantage
-    if (result.bid_ask_ratio > 2.0) {
-        score += 5.0;
+    std::vector<std::thread> workers;
+    size_t count = std::min(static_cast<size_t>(std::max(1, scanner_params_.volume_preload_parallelism)),
+                            missing.size());
+    for (size_t i = 1; i < count; ++i) {
+        workers.emplace_back(work);
     }
-    
-    // 6. Bonus: near intraday high (indicates strong buying pressure)
-    if (result.price_vs_high < 0.01) {
-        score += 5.0;
+    work();
+    for (auto& worker : workers) {
+        worker.join();
     }
     
-    // 7. Opening period bonus (breakouts at open are likelier to sustain)
-    if (isInOpeningPeriod()) {
-        score *= 1.1;
+    saveVolumeCache(exch_name, trading_date);
+    LOG_INFO("Volume history of " + exch_name + " for " + std::to_string(trading_date) + ": " +
+             std::to_string(cached) + " cached, " + std::to_string(fetched.load()) + " of " +
+             std::to_string(missing.size()) + " fetched in " + elapsedMs() + "ms" + (running_ ? "" : " (stopped)"));
+}
+
+std::string MarketScanner::volumeCachePath(const std::string& exchange_name, int trading_date) const {
+    if (scanner_params_.volume_cache_dir.empty()) {
+        return std::string();
     }
-    
-    return score;
+    std::filesystem::path path(scanner_params_.volume_cache_dir);
+    path /= exchange_name;
+    path /= "avg_volume_" + std::to_string(trading_date) + ".txt";
+    return path.string();
+}
+
+std::string MarketScanner::volumeCurvePath(const std::string& exchange_name) const {
+    if (scanner_params_.volume_cache_dir.empty()) {
+        return std::string();
+    }
+    std::filesystem::path path(scanner_params_.volume_cache_dir);
+    path /= exchange_name;
+    path /= "volume_curve.txt";
+    return path.string();
 }
 
-// ===== Core breakout detection methods =====
+void MarketScanner::loadVolumeCurve(const std::shared_ptr<IExchange>& exchange) {
+    const std::string market = exchange->getMarket();
+    VolumeCurve curve = VolumeCurve::uniform(market);
+    const std::string path = volumeCurvePath(exchange->getName());
+    if (curve.valid() && !path.empty() && curve.load(path, market)) {
+        LOG_INFO("Loaded volume curve of " + exchange->getName() + " built on " + std::to_string(curve.builtDate()));
+    }
+    
+    std::lock_guard<std::mutex> lock(table_mutex_);
+    table_curves_[tableIndex(exchange)] = std::move(curve);
+}
 
-double MarketScanner::calculateVolumeRatio(const std::string& symbol, int64_t current_volume, 
-                                            const std::shared_ptr<IExchange>& exchange) {
-    // Check for existing historical data; lazy-load if missing
-    bool need_load = false;
+void MarketScanner::refreshVolumeCurve(const PreloadRequest& request) {
+    const auto& exchange = request.exchange;
+    const std::string exch_name = exchange->getName();
+    const std::string market = exchange->getMarket();
+    const int minutes = sessionMinutes(tradingSessions(market));
+    if (minutes <= 0 || !BarStore::getInstance().isOpen()) {
+        return;
+    }
     {
-        std::lock_guard<std::mutex> lock(volume_history_mutex_);
-        auto it = volume_history_.find(symbol);
-        if (it == volume_history_.end() || it->second.avg_volume <= 0) {
-            need_load = true;
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        if (table_curves_[tableIndex(exchange)].builtDate() >= request.trading_date) {
+            return;
         }
     }
+    auto started = std::chrono::steady_clock::now();
     
-    if (need_load && exchange && exchange->isConnected()) {
-            // Lazy load: fetch daily K-line when first encountering a symbol
-        try {
-            auto klines = exchange->getHistoryKLine(symbol, "K_DAY", VOLUME_HISTORY_DAYS + 1);
-            if (klines.size() >= 2) {
-                std::lock_guard<std::mutex> lock(volume_history_mutex_);
-                auto& history = volume_history_[symbol];
-                history.daily_volumes.clear();
-                for (size_t j = 0; j < klines.size() - 1; ++j) {
-                    history.daily_volumes.push_back(klines[j].volume);
-                }
-                int64_t total = 0;
-                for (auto v : history.daily_volumes) total += v;
-                history.avg_volume = total / (int64_t)history.daily_volumes.size();
-                history.last_price = klines.back().close_price;
+    // Buckets split the watch list by the date's averages
+    std::vector<double> averages(request.symbols.size(), 0.0);
+    {
+        auto& registry = SymbolRegistry::getInstance();
+        std::lock_guard<std::mutex> lock(volume_history_mutex_);
+        for (size_t i = 0; i < request.symbols.size(); ++i) {
+            const VolumeHistory* history = volume_history_.find(registry.find(exch_name, request.symbols[i]));
+            if (history != nullptr && history->trading_date == request.trading_date) {
+                averages[i] = static_cast<double>(history->avg_volume);
             }
-        } catch (...) {}
+        }
     }
-    
-    // Calculate volume ratio
-    std::lock_guard<std::mutex> lock(volume_history_mutex_);
-    auto it = volume_history_.find(symbol);
-    if (it == volume_history_.end() || it->second.avg_volume <= 0) {
-        return 1.0;  // No historical data; default volume ratio = 1
+    VolumeCurve::Builder builder(market, VolumeCurve::Builder::quantiles(averages));
+    
+    // Bars of the opening and closing auctions come on top of the session minutes
+    const int bar_count = (VOLUME_CURVE_DAYS + 1) * (minutes + 2);
+    size_t symbols = 0;
+    for (size_t i = 0; i < request.symbols.size() && running_; ++i) {
+        if (averages[i] <= 0) continue;
+        auto bars = BarStore::getInstance().readStored(exch_name, request.symbols[i], "K_1M", bar_count);
+        symbols += builder.addSymbol(averages[i], bars, request.trading_date) > 0 ? 1 : 0;
+    }
+    if (!running_) {
+        return;
     }
     
-    // Estimate volume based on elapsed trading minutes
-    // HK trading hours: 9:30-12:00 + 13:00-16:00 = 330 minutes
-    auto time_pair = getCurrentTime();
-    int current_min = time_pair.first * 60 + time_pair.second;
-    
-    int elapsed_minutes = 0;
-    int morning_open = 9 * 60 + 30;
-    int morning_close = 12 * 60;
-    int afternoon_open = 13 * 60;
+    VolumeCurve curve;
+    if (!builder.build(request.trading_date, VOLUME_CURVE_MIN_DAYS, curve)) {
+        LOG_INFO("Volume curve of " + exch_name + " kept: " + std::to_string(builder.days()) +
+                 " full days of 1-minute bars stored, " + std::to_string(VOLUME_CURVE_MIN_DAYS) + " needed");
+        return;
+    }
     
-    if (current_min <= morning_close) {
-        elapsed_minutes = std::max(1, current_min - morning_open);
-    } else if (current_min < afternoon_open) {
-        elapsed_minutes = morning_close - morning_open;  // 150 minutes
-    } else {
-        elapsed_minutes = (morning_close - morning_open) + std::max(1, current_min - afternoon_open);
+    const std::string path = volumeCurvePath(exch_name);
+    if (!path.empty() && !curve.save(path)) {
+        LOG_ERROR("Failed to write volume curve " + path);
     }
     
-    // Extrapolate to estimate full-day volume based on elapsed minutes
-    double total_trading_minutes = 330.0;
-    double estimated_daily_volume = (double)current_volume * total_trading_minutes / elapsed_minutes;
+    std::string samples;
+    for (size_t b = 0; b < kVolumeBuckets; ++b) {
+        samples += (b > 0 ? "/" : "") + std::to_string(curve.samples(b));
+    }
+    LOG_INFO("Volume curve of " + exch_name + " rebuilt from " + std::to_string(builder.days()) + " days of " +
+             std::to_string(symbols) + " stocks (" + samples + " by liquidity) in " +
+             std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - started).count()) + "ms");
     
-    return estimated_daily_volume / it->second.avg_volume;
+    std::lock_guard<std::mutex> lock(table_mutex_);
+    table_curves_[tableIndex(exchange)] = std::move(curve);
 }
 
-double MarketScanner::calculateSpeed(const std::string& symbol, double current_price) const {
-    std::lock_guard<std::mutex> lock(last_snapshots_mutex_);
-    
-    auto it = last_snapshots_.find(symbol);
-    if (it == last_snapshots_.end() || it->second.last_price <= 0) {
-        return 0.0;
+size_t MarketScanner::loadVolumeCache(const std::string& exchange_name, int trading_date) {
+    const std::string path = volumeCachePath(exchange_name, trading_date);
+    if (path.empty()) {
+        return 0;
+    }
+    std::ifstream in(path);
+    if (!in) {
+        return 0;
     }
     
-    // Speed = (current_price - last_price) / last_price
-    return (current_price - it->second.last_price) / it->second.last_price;
-}
-
-double MarketScanner::calculateBidAskRatio(const Snapshot& snapshot) const {
-    if (snapshot.ask_volume_1 <= 0) {
-        return (snapshot.bid_volume_1 > 0) ? 10.0 : 1.0;
+    std::vector<std::pair<std::string, int64_t>> entries;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string symbol;
+        int64_t avg_volume = 0;
+        if (fields >> symbol >> avg_volume && avg_volume > 0) {
+            entries.emplace_back(std::move(symbol), avg_volume);
+        }
     }
-    return (double)snapshot.bid_volume_1 / snapshot.ask_volume_1;
-}
-
-void MarketScanner::updateVolumeHistory(const std::string& symbol, int64_t volume, double price) {
+    
+    auto& registry = SymbolRegistry::getInstance();
     std::lock_guard<std::mutex> lock(volume_history_mutex_);
-    auto& history = volume_history_[symbol];
-    history.last_price = price;
-    history.last_scan_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (const auto& entry : entries) {
+        volume_history_[registry.intern(exchange_name, entry.first)] = {entry.second, trading_date};
+    }
+    return entries.size();
 }
 
-void MarketScanner::initVolumeHistory(
-    const std::shared_ptr<IExchange>& exchange, 
-    const std::vector<std::string>& symbols) {
-    
-    if (!exchange || !exchange->isConnected()) return;
+void MarketScanner::saveVolumeCache(const std::string& exchange_name, int trading_date) {
+    const std::string path = volumeCachePath(exchange_name, trading_date);
+    if (path.empty()) {
+        return;
+    }
     
-    LOG_INFO("Initializing volume history for breakout detection (" + 
-             std::to_string(symbols.size()) + " symbols)...");
+    std::vector<std::pair<std::string, int64_t>> entries;
+    {
+        auto& registry = SymbolRegistry::getInstance();
+        std::lock_guard<std::mutex> lock(volume_history_mutex_);
+        volume_history_.forEach([&](SymbolId symbol_id, const VolumeHistory& history) {
+            if (history.trading_date == trading_date && registry.exchange(symbol_id) == exchange_name) {
+                entries.emplace_back(registry.code(symbol_id), history.avg_volume);
+            }
+        });
+    }
     
-    int count = 0;
+    std::error_code ec;
+    const std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    std::filesystem::create_directories(dir, ec);
     
-    for (const auto& symbol : symbols) {
-        if (!running_) break;
-        
-        try {
-            // Fetch recent N days of daily K-line data
-            auto klines = exchange->getHistoryKLine(symbol, "K_DAY", VOLUME_HISTORY_DAYS + 1);
-            
-            if (klines.size() >= 2) {
-                std::lock_guard<std::mutex> lock(volume_history_mutex_);
-                auto& history = volume_history_[symbol];
-                history.daily_volumes.clear();
-                
-                // Skip today's data (last entry), use previous historical entries
-                for (size_t j = 0; j < klines.size() - 1; ++j) {
-                    history.daily_volumes.push_back(klines[j].volume);
-                }
-                
-                // Compute average volume
-                if (!history.daily_volumes.empty()) {
-                    int64_t total = 0;
-                    for (auto v : history.daily_volumes) total += v;
-                    history.avg_volume = total / (int64_t)history.daily_volumes.size();
-                }
-                
-                history.last_price = klines.back().close_price;
-                count++;
-            }
-        } catch (const std::exception& e) {
-            // Silently skip stocks that fail
-            (void)e;
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) {
+            LOG_ERROR("Failed to write volume cache " + tmp);
+            return;
         }
-        
-        if (count % 50 == 0 && count > 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        out << "# average daily volume of the " << VOLUME_HISTORY_DAYS << " sessions before "
+            << trading_date << "\n";
+        for (const auto& entry : entries) {
+            out << entry.first << ' ' << entry.second << '\n';
         }
+        if (!out) {
+            LOG_ERROR("Failed to write volume cache " + tmp);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        LOG_ERROR("Failed to replace volume cache " + path + ": " + ec.message());
+        return;
     }
     
-    LOG_INFO("Volume history initialized for " + std::to_string(count) + " stocks");
+    // Earlier dates are never read again
+    const std::string current = std::filesystem::path(path).filename().string();
+    for (const auto& file : std::filesystem::directory_iterator(dir, ec)) {
+        const std::string name = file.path().filename().string();
+        if (name != current && name.rfind("avg_volume_", 0) == 0) {
+            std::filesystem::remove(file.path(), ec);
+        }
+    }
 }
 
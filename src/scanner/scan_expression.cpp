@@ -0,0 +1,460 @@
+#include "scanner/scan_expression.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+// Rows per evaluation block: a register of them stays in L1
+constexpr size_t kBlockRows = 256;
+
+const char* const kColumnNames[kScanColumnCount] = {
+    "price", "pre_close", "open", "high", "low", "volume", "turnover_rate", "bid_ask_ratio",
+    "avg_volume", "change", "amplitude", "speed", "price_vs_high", "volume_ratio",
+};
+
+} // namespace
+
+struct ScanExpression::Node {
+    enum class Type { kConstant, kColumn, kOp };
+
+    Type type = Type::kConstant;
+    double value = 0.0;
+    ScanColumn column = ScanColumn::kPrice;
+    Op op = Op::kAdd;
+    std::vector<std::unique_ptr<Node>> args;
+};
+
+// Recursive descent over the grammar, lowest precedence first:
+//   ternary    := or ('?' ternary ':' ternary)?
+//   or         := and ('||' and)*
+//   and        := comparison ('&&' comparison)*
+//   comparison := additive (('<' | '<=' | '>' | '>=' | '==' | '!=') additive)?
+//   additive   := term (('+' | '-') term)*
+//   term       := unary (('*' | '/') unary)*
+//   unary      := ('-' | '!') unary | primary
+//   primary    := number | name | name '(' ternary (',' ternary)* ')' | '(' ternary ')'
+class ScanExpression::Parser {
+public:
+    using NodePtr = std::unique_ptr<Node>;
+
+    Parser(const std::string& source, Kind kind, const std::map<std::string, double>& constants)
+        : source_(source), kind_(kind), constants_(constants) {}
+
+    NodePtr parse(std::string& error) {
+        NodePtr root = ternary();
+        skipSpace();
+        if (root && pos_ < source_.size()) {
+            fail("unexpected '" + std::string(1, source_[pos_]) + "'");
+            root.reset();
+        }
+        error = error_;
+        return error_.empty() ? std::move(root) : nullptr;
+    }
+
+private:
+    NodePtr fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message + " at column " + std::to_string(pos_ + 1);
+        }
+        return nullptr;
+    }
+
+    void skipSpace() {
+        while (pos_ < source_.size() && std::isspace(static_cast<unsigned char>(source_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    // Consumes `token` if it comes next; "<" does not match the start of "<="
+    bool match(const char* token) {
+        skipSpace();
+        size_t length = std::char_traits<char>::length(token);
+        if (source_.compare(pos_, length, token) != 0) {
+            return false;
+        }
+        if (length == 1 && pos_ + 1 < source_.size() && source_[pos_ + 1] == '=' &&
+            (token[0] == '<' || token[0] == '>' || token[0] == '!')) {
+            return false;
+        }
+        pos_ += length;
+        return true;
+    }
+
+    NodePtr ternary() {
+        NodePtr condition = orExpr();
+        if (!condition || !match("?")) {
+            return condition;
+        }
+        NodePtr then_value = ternary();
+        if (!then_value) return nullptr;
+        if (!match(":")) return fail("expected ':'");
+        NodePtr else_value = ternary();
+        if (!else_value) return nullptr;
+        return makeOp(Op::kSelect, std::move(condition), std::move(then_value), std::move(else_value));
+    }
+
+    NodePtr orExpr() {
+        NodePtr left = andExpr();
+        while (left && match("||")) {
+            NodePtr right = andExpr();
+            if (!right) return nullptr;
+            left = makeOp(Op::kOr, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    NodePtr andExpr() {
+        NodePtr left = comparison();
+        while (left && match("&&")) {
+            NodePtr right = comparison();
+            if (!right) return nullptr;
+            left = makeOp(Op::kAnd, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    NodePtr comparison() {
+        NodePtr left = additive();
+        if (!left) return nullptr;
+        static const std::pair<const char*, Op> operators[] = {
+            {"<=", Op::kLe}, {">=", Op::kGe}, {"==", Op::kEq}, {"!=", Op::kNe}, {"<", Op::kLt}, {">", Op::kGt},
+        };
+        for (const auto& entry : operators) {
+            if (match(entry.first)) {
+                NodePtr right = additive();
+                if (!right) return nullptr;
+                return makeOp(entry.second, std::move(left), std::move(right));
+            }
+        }
+        return left;
+    }
+
+    NodePtr additive() {
+        NodePtr left = term();
+        while (left) {
+            Op op;
+            if (match("+")) op = Op::kAdd;
+            else if (match("-")) op = Op::kSub;
+            else break;
+            NodePtr right = term();
+            if (!right) return nullptr;
+            left = makeOp(op, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    NodePtr term() {
+        NodePtr left = unary();
+        while (left) {
+            Op op;
+            if (match("*")) op = Op::kMul;
+            else if (match("/")) op = Op::kDiv;
+            else break;
+            NodePtr right = unary();
+            if (!right) return nullptr;
+            left = makeOp(op, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    NodePtr unary() {
+        if (match("-")) {
+            NodePtr operand = unary();
+            return operand ? makeOp(Op::kNeg, std::move(operand)) : nullptr;
+        }
+        if (match("!")) {
+            NodePtr operand = unary();
+            return operand ? makeOp(Op::kNot, std::move(operand)) : nullptr;
+        }
+        return primary();
+    }
+
+    NodePtr primary() {
+        skipSpace();
+        if (pos_ >= source_.size()) {
+            return fail("unexpected end of expression");
+        }
+        if (match("(")) {
+            NodePtr inner = ternary();
+            if (!inner) return nullptr;
+            if (!match(")")) return fail("expected ')'");
+            return inner;
+        }
+
+        char c = source_[pos_];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char* begin = source_.c_str() + pos_;
+            char* end = nullptr;
+            double value = std::strtod(begin, &end);
+            if (end == begin) return fail("malformed number");
+            pos_ += static_cast<size_t>(end - begin);
+            return constant(value);
+        }
+        if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_') {
+            return fail("unexpected '" + std::string(1, c) + "'");
+        }
+
+        size_t start = pos_;
+        while (pos_ < source_.size() &&
+               (std::isalnum(static_cast<unsigned char>(source_[pos_])) || source_[pos_] == '_')) {
+            ++pos_;
+        }
+        const std::string name = source_.substr(start, pos_ - start);
+        if (match("(")) {
+            return call(name, start);
+        }
+
+        for (size_t i = 0; i < kScanColumnCount; ++i) {
+            if (name == kColumnNames[i]) {
+                if (static_cast<ScanColumn>(i) == ScanColumn::kVolumeRatio && kind_ == Kind::kFilter) {
+                    pos_ = start;
+                    return fail("volume_ratio is not known when the filter runs");
+                }
+                auto node = std::make_unique<Node>();
+                node->type = Node::Type::kColumn;
+                node->column = static_cast<ScanColumn>(i);
+                return node;
+            }
+        }
+        auto it = constants_.find(name);
+        if (it != constants_.end()) {
+            return constant(it->second);
+        }
+        pos_ = start;
+        return fail("unknown name '" + name + "'");
+    }
+
+    NodePtr call(const std::string& name, size_t start) {
+        std::vector<NodePtr> args;
+        if (!match(")")) {
+            do {
+                NodePtr arg = ternary();
+                if (!arg) return nullptr;
+                args.push_back(std::move(arg));
+            } while (match(","));
+            if (!match(")")) return fail("expected ')'");
+        }
+
+        size_t expected = name == "abs" ? 1 : name == "clamp" ? 3 : 2;
+        if (name != "min" && name != "max" && name != "abs" && name != "clamp") {
+            pos_ = start;
+            return fail("unknown function '" + name + "'");
+        }
+        if (args.size() != expected) {
+            pos_ = start;
+            return fail(name + " takes " + std::to_string(expected) + " argument" + (expected > 1 ? "s" : ""));
+        }
+
+        if (name == "abs") return makeOp(Op::kAbs, std::move(args[0]));
+        if (name == "min") return makeOp(Op::kMin, std::move(args[0]), std::move(args[1]));
+        if (name == "max") return makeOp(Op::kMax, std::move(args[0]), std::move(args[1]));
+        // clamp(x, lo, hi) = min(max(x, lo), hi)
+        NodePtr lower = makeOp(Op::kMax, std::move(args[0]), std::move(args[1]));
+        return makeOp(Op::kMin, std::move(lower), std::move(args[2]));
+    }
+
+    static NodePtr constant(double value) {
+        auto node = std::make_unique<Node>();
+        node->type = Node::Type::kConstant;
+        node->value = value;
+        return node;
+    }
+
+    // Folds operations on constants, and selects on a constant condition
+    static NodePtr makeOp(Op op, NodePtr a, NodePtr b = nullptr, NodePtr c = nullptr) {
+        bool constant_args = a->type == Node::Type::kConstant &&
+                             (!b || b->type == Node::Type::kConstant) &&
+                             (!c || c->type == Node::Type::kConstant);
+        if (constant_args) {
+            return constant(apply(op, a->value, b ? b->value : 0.0, c ? c->value : 0.0));
+        }
+        if (op == Op::kSelect && a->type == Node::Type::kConstant) {
+            return a->value != 0 ? std::move(b) : std::move(c);
+        }
+
+        auto node = std::make_unique<Node>();
+        node->type = Node::Type::kOp;
+        node->op = op;
+        node->args.push_back(std::move(a));
+        if (b) node->args.push_back(std::move(b));
+        if (c) node->args.push_back(std::move(c));
+        return node;
+    }
+
+    const std::string& source_;
+    Kind kind_;
+    const std::map<std::string, double>& constants_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+std::shared_ptr<const ScanExpression> ScanExpression::compile(const std::string& source, Kind kind,
+                                                              const std::map<std::string, double>& constants,
+                                                              std::string& error) {
+    Parser parser(source, kind, constants);
+    std::unique_ptr<Node> root = parser.parse(error);
+    if (!root) {
+        return nullptr;
+    }
+
+    auto expression = std::make_shared<ScanExpression>();
+    expression->source_ = source;
+
+    // Constants take the slots after the columns, registers the ones after them
+    auto& constant_values = expression->constants_;
+    auto constantIndex = [&constant_values](double value) {
+        for (size_t i = 0; i < constant_values.size(); ++i) {
+            if (constant_values[i] == value || (std::isnan(value) && std::isnan(constant_values[i]))) {
+                return i;
+            }
+        }
+        return constant_values.size();
+    };
+    std::vector<const Node*> pending = {root.get()};
+    while (!pending.empty()) {
+        const Node* node = pending.back();
+        pending.pop_back();
+        if (node->type == Node::Type::kConstant && constantIndex(node->value) == constant_values.size()) {
+            constant_values.push_back(node->value);
+        }
+        for (const auto& arg : node->args) {
+            pending.push_back(arg.get());
+        }
+    }
+    const size_t register_base = kScanColumnCount + constant_values.size();
+
+    // Registers are released as soon as their value is consumed, so a
+    // program needs about as many as the tree is deep
+    std::vector<uint16_t> free_registers;
+    std::function<uint16_t(const Node&)> lower = [&](const Node& node) -> uint16_t {
+        switch (node.type) {
+        case Node::Type::kColumn:
+            return static_cast<uint16_t>(node.column);
+        case Node::Type::kConstant:
+            return static_cast<uint16_t>(kScanColumnCount + constantIndex(node.value));
+        case Node::Type::kOp:
+            break;
+        }
+
+        uint16_t operands[3] = {0, 0, 0};
+        for (size_t i = 0; i < node.args.size(); ++i) {
+            operands[i] = lower(*node.args[i]);
+        }
+        for (size_t i = 0; i < node.args.size(); ++i) {
+            if (operands[i] >= register_base) {
+                free_registers.push_back(static_cast<uint16_t>(operands[i] - register_base));
+            }
+        }
+
+        uint16_t dst;
+        if (!free_registers.empty()) {
+            dst = free_registers.back();
+            free_registers.pop_back();
+        } else {
+            dst = static_cast<uint16_t>(expression->registers_++);
+        }
+        expression->code_.push_back({node.op, dst, operands[0], operands[1], operands[2]});
+        return static_cast<uint16_t>(register_base + dst);
+    };
+    expression->result_ = lower(*root);
+    return expression;
+}
+
+void ScanExpression::evaluate(const double* const* columns, size_t begin, size_t end,
+                              std::vector<double>& out) const {
+    const size_t rows = end > begin ? end - begin : 0;
+    out.resize(rows);
+    if (rows == 0) {
+        return;
+    }
+
+    // Constants are broadcast once; column slots move with each block
+    const size_t block = std::min(kBlockRows, rows);
+    const size_t register_base = kScanColumnCount + constants_.size();
+    std::vector<double> scratch((constants_.size() + registers_) * block);
+    std::vector<const double*> slots(register_base + registers_);
+    for (size_t k = 0; k < constants_.size(); ++k) {
+        std::fill_n(scratch.data() + k * block, block, constants_[k]);
+        slots[kScanColumnCount + k] = scratch.data() + k * block;
+    }
+    for (size_t r = 0; r < registers_; ++r) {
+        slots[register_base + r] = scratch.data() + (constants_.size() + r) * block;
+    }
+
+    for (size_t start = begin; start < end; start += block) {
+        const size_t n = std::min(block, end - start);
+        for (size_t c = 0; c < kScanColumnCount; ++c) {
+            slots[c] = columns[c] + start;
+        }
+
+        for (const Instruction& ins : code_) {
+            double* dst = scratch.data() + (constants_.size() + ins.dst) * block;
+            run(ins.op, dst, slots[ins.a], slots[ins.b], slots[ins.c], n);
+        }
+        std::copy_n(slots[result_], n, out.data() + (start - begin));
+    }
+}
+
+// One instruction over a block. Kept out of evaluate's loops so each case is
+// a single loop the compiler can vectorize.
+void ScanExpression::run(Op op, double* dst, const double* a, const double* b, const double* c,
+                         size_t n) {
+    switch (op) {
+    case Op::kAdd: for (size_t i = 0; i < n; ++i) dst[i] = a[i] + b[i]; break;
+    case Op::kSub: for (size_t i = 0; i < n; ++i) dst[i] = a[i] - b[i]; break;
+    case Op::kMul: for (size_t i = 0; i < n; ++i) dst[i] = a[i] * b[i]; break;
+    case Op::kDiv: for (size_t i = 0; i < n; ++i) dst[i] = a[i] / b[i]; break;
+    case Op::kMin: for (size_t i = 0; i < n; ++i) dst[i] = std::min(a[i], b[i]); break;
+    case Op::kMax: for (size_t i = 0; i < n; ++i) dst[i] = std::max(a[i], b[i]); break;
+    case Op::kNeg: for (size_t i = 0; i < n; ++i) dst[i] = -a[i]; break;
+    case Op::kAbs: for (size_t i = 0; i < n; ++i) dst[i] = std::fabs(a[i]); break;
+    case Op::kNot: for (size_t i = 0; i < n; ++i) dst[i] = a[i] == 0 ? 1.0 : 0.0; break;
+    case Op::kLt: for (size_t i = 0; i < n; ++i) dst[i] = a[i] < b[i] ? 1.0 : 0.0; break;
+    case Op::kLe: for (size_t i = 0; i < n; ++i) dst[i] = a[i] <= b[i] ? 1.0 : 0.0; break;
+    case Op::kGt: for (size_t i = 0; i < n; ++i) dst[i] = a[i] > b[i] ? 1.0 : 0.0; break;
+    case Op::kGe: for (size_t i = 0; i < n; ++i) dst[i] = a[i] >= b[i] ? 1.0 : 0.0; break;
+    case Op::kEq: for (size_t i = 0; i < n; ++i) dst[i] = a[i] == b[i] ? 1.0 : 0.0; break;
+    case Op::kNe: for (size_t i = 0; i < n; ++i) dst[i] = a[i] != b[i] ? 1.0 : 0.0; break;
+    case Op::kAnd: for (size_t i = 0; i < n; ++i) dst[i] = (a[i] != 0) & (b[i] != 0) ? 1.0 : 0.0; break;
+    case Op::kOr: for (size_t i = 0; i < n; ++i) dst[i] = (a[i] != 0) | (b[i] != 0) ? 1.0 : 0.0; break;
+    case Op::kSelect:
+        for (size_t i = 0; i < n; ++i) {
+            const double if_true = b[i];
+            const double if_false = c[i];
+            dst[i] = a[i] != 0 ? if_true : if_false;
+        }
+        break;
+    }
+}
+
+const char* ScanExpression::columnName(ScanColumn column) {
+    size_t index = static_cast<size_t>(column);
+    return index < kScanColumnCount ? kColumnNames[index] : "";
+}
+
+double ScanExpression::apply(Op op, double a, double b, double c) {
+    switch (op) {
+    case Op::kAdd: return a + b;
+    case Op::kSub: return a - b;
+    case Op::kMul: return a * b;
+    case Op::kDiv: return a / b;
+    case Op::kMin: return std::min(a, b);
+    case Op::kMax: return std::max(a, b);
+    case Op::kNeg: return -a;
+    case Op::kAbs: return std::fabs(a);
+    case Op::kNot: return a == 0 ? 1.0 : 0.0;
+    case Op::kLt: return a < b ? 1.0 : 0.0;
+    case Op::kLe: return a <= b ? 1.0 : 0.0;
+    case Op::kGt: return a > b ? 1.0 : 0.0;
+    case Op::kGe: return a >= b ? 1.0 : 0.0;
+    case Op::kEq: return a == b ? 1.0 : 0.0;
+    case Op::kNe: return a != b ? 1.0 : 0.0;
+    case Op::kAnd: return (a != 0 && b != 0) ? 1.0 : 0.0;
+    case Op::kOr: return (a != 0 || b != 0) ? 1.0 : 0.0;
+    case Op::kSelect: return a != 0 ? b : c;
+    }
+    return 0.0;
+}
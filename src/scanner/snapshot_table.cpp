@@ -0,0 +1,356 @@
+#include "scanner/snapshot_table.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+uint16_t SnapshotTable::exchangeIndex(const std::string& exchange_name) {
+    for (size_t i = 0; i < exchange_names_.size(); ++i) {
+        if (exchange_names_[i] == exchange_name) {
+            return static_cast<uint16_t>(i);
+        }
+    }
+    exchange_names_.push_back(exchange_name);
+    return static_cast<uint16_t>(exchange_names_.size() - 1);
+}
+
+uint32_t SnapshotTable::rowOf(SymbolId symbol_id) {
+    uint32_t* existing = rows_.find(symbol_id);
+    if (existing != nullptr) {
+        return *existing;
+    }
+
+    uint32_t row = static_cast<uint32_t>(symbol_ids_.size());
+    rows_[symbol_id] = row;
+    symbol_ids_.push_back(symbol_id);
+    exchange_.push_back(0);
+    generation_.push_back(0);
+    names_.emplace_back();
+    for (auto* column : {&price_, &pre_close_, &open_, &high_, &low_, &volume_, &turnover_rate_,
+                         &bid_ask_ratio_, &prev_price_, &avg_volume_, &change_, &amplitude_,
+                         &speed_, &price_vs_high_, &volume_ratio_, &score_}) {
+        column->push_back(0.0);
+    }
+    basic_.push_back(0);
+    rising_.push_back(0);
+    qualified_.push_back(0);
+    tier_.push_back(static_cast<uint8_t>(ScanTier::kHot));
+    return row;
+}
+
+bool SnapshotTable::update(uint16_t exchange_index, uint32_t generation, const Snapshot& snapshot,
+                           double bid_ask_ratio, uint32_t& row) {
+    const size_t rows_before = size();
+    row = rowOf(snapshot.symbol_id);
+    const bool known = row < rows_before && exchange_[row] == exchange_index;
+    exchange_[row] = exchange_index;
+    generation_[row] = generation;
+
+    // Quiet stocks poll the same figures scan after scan; once the speed
+    // reference has caught up nothing derived from them can change
+    const double volume = static_cast<double>(snapshot.volume);
+    if (known && price_[row] == snapshot.last_price && prev_price_[row] == snapshot.last_price &&
+        volume_[row] == volume && high_[row] == snapshot.high_price && low_[row] == snapshot.low_price &&
+        open_[row] == snapshot.open_price && pre_close_[row] == snapshot.pre_close &&
+        turnover_rate_[row] == snapshot.turnover_rate && bid_ask_ratio_[row] == bid_ask_ratio) {
+        return false;
+    }
+
+    if (names_[row] != snapshot.name) {
+        names_[row] = snapshot.name;
+    }
+    prev_price_[row] = price_[row];
+    price_[row] = snapshot.last_price;
+    pre_close_[row] = snapshot.pre_close;
+    open_[row] = snapshot.open_price;
+    high_[row] = snapshot.high_price;
+    low_[row] = snapshot.low_price;
+    volume_[row] = volume;
+    turnover_rate_[row] = snapshot.turnover_rate;
+    bid_ask_ratio_[row] = bid_ask_ratio;
+    return true;
+}
+
+bool SnapshotTable::updateQuote(SymbolId symbol_id, const TickData& tick) {
+    const uint32_t* found = rows_.find(symbol_id);
+    if (found == nullptr) {
+        return false;
+    }
+    uint32_t row = *found;
+    double volume = static_cast<double>(tick.volume);
+    if (price_[row] == tick.last_price && volume_[row] == volume &&
+        high_[row] == tick.high_price && low_[row] == tick.low_price) {
+        return false;
+    }
+    price_[row] = tick.last_price;
+    pre_close_[row] = tick.pre_close;
+    open_[row] = tick.open_price;
+    high_[row] = tick.high_price;
+    low_[row] = tick.low_price;
+    volume_[row] = volume;
+    turnover_rate_[row] = tick.turnover_rate;
+    return true;
+}
+
+void SnapshotTable::setAverageVolume(SymbolId symbol_id, double avg_volume) {
+    const uint32_t* found = rows_.find(symbol_id);
+    if (found != nullptr) {
+        avg_volume_[*found] = avg_volume;
+    }
+}
+
+void SnapshotTable::resetAverageVolumes(uint16_t exchange_index) {
+    for (size_t i = 0; i < size(); ++i) {
+        if (exchange_[i] == exchange_index) {
+            avg_volume_[i] = 0.0;
+        }
+    }
+}
+
+bool SnapshotTable::findRow(SymbolId symbol_id, uint32_t& row) const {
+    const uint32_t* found = rows_.find(symbol_id);
+    if (found == nullptr) {
+        return false;
+    }
+    row = *found;
+    return true;
+}
+
+// Both kernels make a single pass over the columns they read: at a few
+// thousand rows per market the table outgrows the L2 cache and the loops
+// are bound by memory traffic, not arithmetic. Selects instead of branches
+// leave vectorization to the compiler where it can prove it safe.
+
+std::vector<SymbolId> SnapshotTable::prefilter(const ScanKernelParams& params,
+                                               const std::vector<ScanExchangeFactors>& factors,
+                                               uint16_t exchange_index,
+                                               size_t begin, size_t end) {
+    end = std::min(end, size());
+
+    // Criteria as locals: through the reference every store to a column
+    // would force them to be reloaded
+    const double min_price = params.min_price;
+    const double max_price = params.max_price;
+    const double change_min = params.change_min;
+    const double change_max = params.change_max;
+    const double amplitude_min = params.amplitude_min;
+    const double min_turnover_rate = params.min_turnover_rate;
+    const double min_volume = params.min_volume;
+    const double min_bid_ask_ratio = params.min_bid_ask_ratio;
+    const double max_price_vs_high = params.max_price_vs_high;
+
+    for (size_t i = begin; i < end; ++i) {
+        double price = price_[i];
+        double pre_close = pre_close_[i];
+        double open = open_[i];
+        double high = high_[i];
+        double prev = prev_price_[i];
+
+        // Divisors are substituted rather than the divisions made conditional
+        double change = (price - pre_close) / (pre_close > 0 ? pre_close : 1.0);
+        double amplitude = (high - low_[i]) / (open > 0 ? open : 1.0);
+        double speed = (price - prev) / (prev > 0 ? prev : 1.0);
+        double vs_high = (high - price) / (high > 0 ? high : 1.0);
+        change = pre_close > 0 ? change : 0.0;
+        amplitude = open > 0 ? amplitude : 0.0;
+        speed = prev > 0 ? speed : 0.0;
+        vs_high = high > 0 ? vs_high : 0.0;
+        change_[i] = change;
+        amplitude_[i] = amplitude;
+        speed_[i] = speed;
+        price_vs_high_[i] = vs_high;
+
+        // Non-short-circuit & keeps every comparison in one block
+        uint8_t priced = (price >= min_price) & (price <= max_price);
+        uint8_t pass = (change >= change_min) & (change <= change_max) &
+                       (amplitude >= amplitude_min) &
+                       (turnover_rate_[i] >= min_turnover_rate) &
+                       (volume_[i] >= min_volume) &
+                       (bid_ask_ratio_[i] >= min_bid_ask_ratio) &
+                       (vs_high <= max_price_vs_high);
+
+        // Tier: 0 hot, 1 warm, 2 cold
+        uint8_t liquid = priced & (volume_[i] >= 0.5 * min_volume) & (turnover_rate_[i] >= 0.5 * min_turnover_rate);
+        uint8_t hot = (priced & pass) | (liquid & (change >= 0.5 * change_min));
+        uint8_t tier = static_cast<uint8_t>((1 - hot) * (2 - liquid));
+        tier_[i] = tier;
+
+        // Rows an exchange's scans should have refreshed by now drop out
+        const ScanExchangeFactors& f = factors[exchange_[i]];
+        uint8_t current = generation_[i] + f.tier_cycles[tier] > f.min_generation;
+        uint8_t in_range = current & priced;
+        rising_[i] = in_range & (change > 0);
+        basic_[i] = in_range & pass;
+    }
+
+    // A configured filter runs over the derived columns just written
+    if (params.filter && begin < end) {
+        params.filter->evaluate(expressionColumns().data(), begin, end, expression_out_);
+        for (size_t i = begin; i < end; ++i) {
+            const ScanExchangeFactors& f = factors[exchange_[i]];
+            double v = expression_out_[i - begin];
+            uint8_t pass = std::isfinite(v) && v != 0;
+            tier_[i] = pass ? static_cast<uint8_t>(ScanTier::kHot) : tier_[i];
+            uint8_t current = generation_[i] + f.tier_cycles[tier_[i]] > f.min_generation;
+            basic_[i] = current & pass;
+        }
+    }
+
+    std::vector<SymbolId> missing_history;
+    for (size_t i = begin; i < end; ++i) {
+        if (basic_[i] && exchange_[i] == exchange_index && avg_volume_[i] <= 0) {
+            missing_history.push_back(symbol_ids_[i]);
+        }
+    }
+    return missing_history;
+}
+
+std::vector<SymbolId> SnapshotTable::prefilter(const ScanKernelParams& params,
+                                               const std::vector<ScanExchangeFactors>& factors,
+                                               uint16_t exchange_index,
+                                               std::vector<uint32_t> rows) {
+    std::sort(rows.begin(), rows.end());
+    std::vector<SymbolId> missing_history;
+    size_t i = 0;
+    while (i < rows.size()) {
+        size_t j = i + 1;
+        while (j < rows.size() && rows[j] <= rows[j - 1] + 1) {
+            ++j;
+        }
+        auto missing = prefilter(params, factors, exchange_index, rows[i], size_t(rows[j - 1]) + 1);
+        missing_history.insert(missing_history.end(), missing.begin(), missing.end());
+        i = j;
+    }
+    return missing_history;
+}
+
+void SnapshotTable::score(const ScanKernelParams& params, const std::vector<ScanExchangeFactors>& factors,
+                          size_t begin, size_t end) {
+    end = std::min(end, size());
+
+    const double weight_volume = params.weight_volume;
+    const double weight_change = params.weight_change;
+    const double weight_speed = params.weight_speed;
+    const double weight_turnover = params.weight_turnover;
+    const double volume_ratio_min = params.volume_ratio_min;
+
+    for (size_t i = begin; i < end; ++i) {
+        const ScanExchangeFactors& f = factors[exchange_[i]];
+
+        // Without history the ratio is neutral
+        double avg_volume = avg_volume_[i];
+        size_t bucket = 0;
+        for (size_t b = 0; b + 1 < kVolumeBuckets; ++b) {
+            bucket += avg_volume > f.volume_thresholds[b] ? 1 : 0;
+        }
+        double ratio = volume_[i] * f.volume_extrapolation[bucket] / (avg_volume > 0 ? avg_volume : 1.0);
+        ratio = avg_volume > 0 ? ratio : 1.0;
+        volume_ratio_[i] = ratio;
+
+        // Volume: diminishing returns after 10x
+        double volume_score = std::min(1.0, ratio / 10.0);
+
+        // Change: 3-6% is the sweet spot
+        double c = change_[i];
+        double above = std::max(0.0, 1.0 - (c - 0.06) / 0.04);
+        double below = c >= 0.03 ? 1.0 : c / 0.03;
+        double change_score = c > 0.06 ? above : below;
+
+        double speed_score = std::min(1.0, std::max(0.0, speed_[i] * 100.0));
+        double turnover_score = std::min(1.0, turnover_rate_[i] / 0.10);
+
+        double s = volume_score * weight_volume +
+                   change_score * weight_change +
+                   speed_score * weight_speed +
+                   turnover_score * weight_turnover;
+        s += bid_ask_ratio_[i] > 2.0 ? 5.0 : 0.0;      // overwhelming bid advantage
+        s += price_vs_high_[i] < 0.01 ? 5.0 : 0.0;     // pinned to the intraday high
+        score_[i] = s * f.score_multiplier;
+
+        qualified_[i] = basic_[i] & (ratio >= volume_ratio_min);
+    }
+
+    if (params.score && begin < end) {
+        params.score->evaluate(expressionColumns().data(), begin, end, expression_out_);
+        // NaN would break the ranking's ordering; such rows rank last
+        const double unranked = -std::numeric_limits<double>::infinity();
+        for (size_t i = begin; i < end; ++i) {
+            double s = expression_out_[i - begin];
+            score_[i] = std::isfinite(s) ? s * factors[exchange_[i]].score_multiplier : unranked;
+        }
+    }
+}
+
+std::vector<uint32_t> SnapshotTable::select(uint16_t exchange_index, Selection selection) const {
+    const std::vector<uint8_t>& mask = selection == Selection::kQualified ? qualified_ : rising_;
+    std::vector<uint32_t> rows;
+    for (size_t i = 0; i < size(); ++i) {
+        if (mask[i] && exchange_[i] == exchange_index) {
+            rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return rows;
+}
+
+std::vector<uint32_t> SnapshotTable::top(uint16_t exchange_index, Selection selection, size_t limit) const {
+    std::vector<uint32_t> rows = select(exchange_index, selection);
+
+    auto by_score = [this](uint32_t a, uint32_t b) { return score_[a] > score_[b]; };
+    if (limit > 0 && rows.size() > limit) {
+        std::partial_sort(rows.begin(), rows.begin() + limit, rows.end(), by_score);
+        rows.resize(limit);
+    } else {
+        std::sort(rows.begin(), rows.end(), by_score);
+    }
+    return rows;
+}
+
+std::array<size_t, kScanTiers> SnapshotTable::tierCounts(uint16_t exchange_index) const {
+    std::array<size_t, kScanTiers> counts{};
+    for (size_t i = 0; i < size(); ++i) {
+        if (exchange_[i] == exchange_index) {
+            ++counts[tier_[i]];
+        }
+    }
+    return counts;
+}
+
+std::array<const double*, kScanColumnCount> SnapshotTable::expressionColumns() const {
+    std::array<const double*, kScanColumnCount> columns{};
+    columns[static_cast<size_t>(ScanColumn::kPrice)] = price_.data();
+    columns[static_cast<size_t>(ScanColumn::kPreClose)] = pre_close_.data();
+    columns[static_cast<size_t>(ScanColumn::kOpen)] = open_.data();
+    columns[static_cast<size_t>(ScanColumn::kHigh)] = high_.data();
+    columns[static_cast<size_t>(ScanColumn::kLow)] = low_.data();
+    columns[static_cast<size_t>(ScanColumn::kVolume)] = volume_.data();
+    columns[static_cast<size_t>(ScanColumn::kTurnoverRate)] = turnover_rate_.data();
+    columns[static_cast<size_t>(ScanColumn::kBidAskRatio)] = bid_ask_ratio_.data();
+    columns[static_cast<size_t>(ScanColumn::kAvgVolume)] = avg_volume_.data();
+    columns[static_cast<size_t>(ScanColumn::kChange)] = change_.data();
+    columns[static_cast<size_t>(ScanColumn::kAmplitude)] = amplitude_.data();
+    columns[static_cast<size_t>(ScanColumn::kSpeed)] = speed_.data();
+    columns[static_cast<size_t>(ScanColumn::kPriceVsHigh)] = price_vs_high_.data();
+    columns[static_cast<size_t>(ScanColumn::kVolumeRatio)] = volume_ratio_.data();
+    return columns;
+}
+
+ScanRow SnapshotTable::row(uint32_t row) const {
+    ScanRow r;
+    r.symbol_id = symbol_ids_[row];
+    r.exchange_index = exchange_[row];
+    r.name = names_[row];
+    r.price = price_[row];
+    r.pre_close = pre_close_[row];
+    r.open_price = open_[row];
+    r.high_price = high_[row];
+    r.low_price = low_[row];
+    r.volume = volume_[row];
+    r.turnover_rate = turnover_rate_[row];
+    r.bid_ask_ratio = bid_ask_ratio_[row];
+    r.change_ratio = change_[row];
+    r.amplitude = amplitude_[row];
+    r.speed = speed_[row];
+    r.price_vs_high = price_vs_high_[row];
+    r.volume_ratio = volume_ratio_[row];
+    r.score = score_[row];
+    return r;
+}
@@ -0,0 +1,123 @@
+#include "scanner/top_n_ranking.h"
+#include <algorithm>
+
+void TopNRanking::setCapacity(size_t capacity, RankingDelta& delta) {
+    if (capacity == capacity_) {
+        return;
+    }
+    capacity_ = capacity;
+    rebalance(delta);
+}
+
+void TopNRanking::update(SymbolId symbol_id, double score, RankingDelta& delta) {
+    double* current = scores_.find(symbol_id);
+    if (current != nullptr) {
+        if (*current == score) {
+            return;
+        }
+        Entry old{*current, symbol_id};
+        if (top_.erase(old) > 0) {
+            noteLeft(symbol_id, delta);
+        } else {
+            rest_.erase(old);
+        }
+        *current = score;
+    } else {
+        scores_[symbol_id] = score;
+    }
+
+    // Enters through rest_; rebalance promotes it if it ranks high enough
+    rest_.insert({score, symbol_id});
+    rebalance(delta);
+}
+
+void TopNRanking::remove(SymbolId symbol_id, RankingDelta& delta) {
+    const double* current = scores_.find(symbol_id);
+    if (current == nullptr) {
+        return;
+    }
+    Entry old{*current, symbol_id};
+    scores_.erase(symbol_id);
+    if (top_.erase(old) > 0) {
+        noteLeft(symbol_id, delta);
+        rebalance(delta);
+    } else {
+        rest_.erase(old);
+    }
+}
+
+void TopNRanking::clear() {
+    top_.clear();
+    rest_.clear();
+    scores_.clear();
+}
+
+bool TopNRanking::inTop(SymbolId symbol_id) const {
+    const double* current = scores_.find(symbol_id);
+    return current != nullptr && top_.count({*current, symbol_id}) > 0;
+}
+
+std::vector<SymbolId> TopNRanking::top() const {
+    std::vector<SymbolId> ids;
+    ids.reserve(top_.size());
+    for (const auto& entry : top_) {
+        ids.push_back(entry.symbol_id);
+    }
+    return ids;
+}
+
+std::vector<SymbolId> TopNRanking::symbols() const {
+    std::vector<SymbolId> ids;
+    ids.reserve(size());
+    for (const auto& entry : top_) {
+        ids.push_back(entry.symbol_id);
+    }
+    for (const auto& entry : rest_) {
+        ids.push_back(entry.symbol_id);
+    }
+    return ids;
+}
+
+void TopNRanking::rebalance(RankingDelta& delta) {
+    // Each loop runs at most once per update or removal; only a capacity
+    // change moves several entries
+    while (top_.size() > capacity_) {
+        auto worst = std::prev(top_.end());
+        noteLeft(worst->symbol_id, delta);
+        rest_.insert(*worst);
+        top_.erase(worst);
+    }
+    while (top_.size() < capacity_ && !rest_.empty()) {
+        noteEntered(rest_.begin()->symbol_id, delta);
+        top_.insert(*rest_.begin());
+        rest_.erase(rest_.begin());
+    }
+    while (!top_.empty() && !rest_.empty() && *rest_.begin() < *std::prev(top_.end())) {
+        auto worst = std::prev(top_.end());
+        noteLeft(worst->symbol_id, delta);
+        noteEntered(rest_.begin()->symbol_id, delta);
+        Entry demoted = *worst;
+        top_.erase(worst);
+        top_.insert(*rest_.begin());
+        rest_.erase(rest_.begin());
+        rest_.insert(demoted);
+    }
+}
+
+void TopNRanking::noteEntered(SymbolId symbol_id, RankingDelta& delta) {
+    auto it = std::find(delta.left.begin(), delta.left.end(), symbol_id);
+    if (it != delta.left.end()) {
+        delta.left.erase(it);
+    } else {
+        delta.entered.push_back(symbol_id);
+    }
+}
+
+void TopNRanking::noteLeft(SymbolId symbol_id, RankingDelta& delta) {
+    auto it = std::find(delta.entered.begin(), delta.entered.end(), symbol_id);
+    if (it != delta.entered.end()) {
+        delta.entered.erase(it);
+    } else {
+        delta.left.push_back(symbol_id);
+    }
+}
@@ -0,0 +1,246 @@
+#include "scanner/volume_curve.h"
+#include "common/trading_session.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Minutes a day may lack at the open or the close before it counts as partial
+constexpr int kEdgeMinutes = 5;
+// Closing auctions trade after the last session closes
+constexpr int kAuctionMinutes = 10;
+// Floor of expectedShare(): caps the extrapolation at 1000x
+constexpr double kMinShare = 0.001;
+
+size_t bucketFor(const VolumeCurve::Thresholds& thresholds, double avg_volume) {
+    size_t bucket = 0;
+    for (double threshold : thresholds) {
+        bucket += avg_volume > threshold ? 1 : 0;
+    }
+    return bucket;
+}
+
+} // namespace
+
+VolumeCurve VolumeCurve::uniform(const std::string& market) {
+    VolumeCurve curve;
+    curve.market_ = market;
+    curve.minutes_ = sessionMinutes(tradingSessions(market));
+    for (auto& shares : curve.shares_) {
+        shares.resize(static_cast<size_t>(curve.minutes_));
+        for (int i = 0; i < curve.minutes_; ++i) {
+            shares[static_cast<size_t>(i)] = static_cast<double>(i + 1) / curve.minutes_;
+        }
+    }
+    return curve;
+}
+
+size_t VolumeCurve::bucketOf(double avg_volume) const {
+    return bucketFor(thresholds_, avg_volume);
+}
+
+double VolumeCurve::expectedShare(size_t bucket, int elapsed_minutes) const {
+    if (!valid()) {
+        return 1.0;
+    }
+    int minute = std::min(std::max(elapsed_minutes, 1), minutes_);
+    return std::max(kMinShare, shares_[bucket][static_cast<size_t>(minute - 1)]);
+}
+
+bool VolumeCurve::load(const std::string& path, const std::string& market) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    VolumeCurve curve;
+    std::string line;
+    size_t bucket = 0;
+    bool header = false;
+    bool thresholds = false;
+    while (std::getline(in, line) && bucket < kVolumeBuckets) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        if (!header) {
+            if (!(fields >> curve.market_ >> curve.minutes_ >> curve.built_date_)) return false;
+            header = true;
+        } else if (!thresholds) {
+            std::string key;
+            fields >> key;
+            for (double& threshold : curve.thresholds_) {
+                fields >> threshold;
+            }
+            if (key != "thresholds" || !fields) return false;
+            thresholds = true;
+        } else {
+            std::string key;
+            size_t index = 0;
+            fields >> key >> index >> curve.samples_[bucket];
+            if (key != "bucket" || index != bucket || !fields) return false;
+            auto& shares = curve.shares_[bucket];
+            shares.resize(static_cast<size_t>(curve.minutes_));
+            for (double& share : shares) {
+                fields >> share;
+            }
+            if (!fields) return false;
+            ++bucket;
+        }
+    }
+
+    // A curve of another session layout would be read at the wrong minutes
+    if (bucket < kVolumeBuckets || curve.market_ != market ||
+        curve.minutes_ != sessionMinutes(tradingSessions(market)) || curve.minutes_ <= 0) {
+        return false;
+    }
+    *this = std::move(curve);
+    return true;
+}
+
+bool VolumeCurve::save(const std::string& path) const {
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out << "# cumulative share of the day's volume by minute of continuous trading\n";
+        out << market_ << ' ' << minutes_ << ' ' << built_date_ << '\n';
+        out << "thresholds";
+        for (double threshold : thresholds_) {
+            out << ' ' << threshold;
+        }
+        out << '\n';
+        for (size_t bucket = 0; bucket < kVolumeBuckets; ++bucket) {
+            out << "bucket " << bucket << ' ' << samples_[bucket];
+            for (double share : shares_[bucket]) {
+                out << ' ' << share;
+            }
+            out << '\n';
+        }
+        if (!out) {
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+VolumeCurve::Builder::Builder(const std::string& market, const Thresholds& thresholds)
+    : market_(market), thresholds_(thresholds), minutes_(sessionMinutes(tradingSessions(market))) {
+    for (auto& sums : share_sums_) {
+        sums.assign(static_cast<size_t>(minutes_), 0.0);
+    }
+    pooled_sums_.assign(static_cast<size_t>(minutes_), 0.0);
+}
+
+size_t VolumeCurve::Builder::addSymbol(double avg_volume, const std::vector<KlineData>& bars, int before_date) {
+    const auto& sessions = tradingSessions(market_);
+    if (minutes_ <= 0 || bars.empty()) {
+        return 0;
+    }
+    const size_t bucket = bucketFor(thresholds_, avg_volume);
+    const int first_open = sessions.front().open_min;
+    const int last_close = sessions.back().close_min;
+    std::vector<double> minute_volume(static_cast<size_t>(minutes_), 0.0);
+    int date = 0;
+    int first_minute = minutes_;
+    int last_minute = -1;
+    size_t added = 0;
+
+    auto finishDay = [&]() {
+        if (date != 0 && first_minute <= kEdgeMinutes && last_minute >= minutes_ - 1 - kEdgeMinutes) {
+            added += addDay(bucket, minute_volume) ? 1 : 0;
+        }
+        std::fill(minute_volume.begin(), minute_volume.end(), 0.0);
+        first_minute = minutes_;
+        last_minute = -1;
+    };
+
+    for (const auto& bar : bars) {
+        if (bar.exchange_ts_ns == 0) continue;
+        int bar_date = marketDate(market_, bar.exchange_ts_ns);
+        if (bar_date >= before_date) break;
+        if (bar_date != date) {
+            finishDay();
+            date = bar_date;
+        }
+
+        // Extended hours trade outside the sessions and are not in the
+        // snapshot volume; the opening auction is stamped at the open
+        int minute_of_day = marketMinuteOfDay(market_, bar.exchange_ts_ns);
+        if (minute_of_day < first_open || minute_of_day > last_close + kAuctionMinutes) continue;
+        int minute = std::min(std::max(elapsedSessionMinutes(sessions, minute_of_day) - 1, 0), minutes_ - 1);
+        minute_volume[static_cast<size_t>(minute)] += static_cast<double>(bar.volume);
+        first_minute = std::min(first_minute, minute);
+        last_minute = std::max(last_minute, minute);
+    }
+    finishDay();
+    return added;
+}
+
+bool VolumeCurve::Builder::addDay(size_t bucket, const std::vector<double>& minute_volume) {
+    double total = 0.0;
+    for (double volume : minute_volume) {
+        total += volume;
+    }
+    if (total <= 0) {
+        return false;
+    }
+
+    // Each day weighs the same, however much it traded
+    double cumulative = 0.0;
+    for (size_t i = 0; i < minute_volume.size(); ++i) {
+        cumulative += minute_volume[i];
+        share_sums_[bucket][i] += cumulative / total;
+        pooled_sums_[i] += cumulative / total;
+    }
+    ++days_[bucket];
+    ++pooled_days_;
+    return true;
+}
+
+bool VolumeCurve::Builder::build(int built_date, size_t min_days, VolumeCurve& out) const {
+    if (minutes_ <= 0 || pooled_days_ == 0 || pooled_days_ < min_days) {
+        return false;
+    }
+
+    VolumeCurve curve;
+    curve.market_ = market_;
+    curve.minutes_ = minutes_;
+    curve.built_date_ = built_date;
+    curve.thresholds_ = thresholds_;
+    for (size_t bucket = 0; bucket < kVolumeBuckets; ++bucket) {
+        bool own = days_[bucket] > 0 && days_[bucket] >= min_days;
+        const std::vector<double>& sums = own ? share_sums_[bucket] : pooled_sums_;
+        double days = static_cast<double>(own ? days_[bucket] : pooled_days_);
+
+        auto& shares = curve.shares_[bucket];
+        shares.resize(sums.size());
+        for (size_t i = 0; i < sums.size(); ++i) {
+            shares[i] = sums[i] / days;
+        }
+        shares.back() = 1.0;
+        curve.samples_[bucket] = days_[bucket];
+    }
+    out = std::move(curve);
+    return true;
+}
+
+VolumeCurve::Thresholds VolumeCurve::Builder::quantiles(std::vector<double> averages) {
+    averages.erase(std::remove_if(averages.begin(), averages.end(), [](double v) { return v <= 0; }),
+                   averages.end());
+    Thresholds thresholds{};
+    if (averages.empty()) {
+        return thresholds;
+    }
+    std::sort(averages.begin(), averages.end());
+    for (size_t i = 0; i < thresholds.size(); ++i) {
+        thresholds[i] = averages[(i + 1) * averages.size() / kVolumeBuckets];
+    }
+    return thresholds;
+}
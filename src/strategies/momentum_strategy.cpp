@@ -2,6 +2,7 @@
 #include "managers/position_manager.h"
 #include "managers/risk_manager.h"
 #include "config/config_manager.h"
+#include "data/trading_calendar.h"
 #include "utils/logger.h"
 #include <cmath>
 #include <sstream>
@@ -20,7 +21,7 @@ void MomentumStrategy::onScanResult(const ScanResult& result) {
     auto& pos_mgr = PositionManager::getInstance();
     
     // Skip if already holding a position
-    if (pos_mgr.hasPosition(result.symbol)) {
+    if (pos_mgr.hasPosition(result.symbol_id)) {
         return;
     }
     
@@ -28,7 +29,7 @@ void MomentumStrategy::onScanResult(const ScanResult& result) {
     auto positions = pos_mgr.getAllPositions();
     int active_count = 0;
     for (const auto& p : positions) {
-        if (p.second.quantity > 0) active_count++;
+        if (p.second.quantity.isPositive()) active_count++;
     }
     if (active_count >= 5) {
         return;  // maximum 5 concurrent positions
@@ -57,18 +58,19 @@ void MomentumStrategy::onScanResult(const ScanResult& result) {
         subscribeStock(result.symbol);
         
         // Calculate buy quantity
-        int quantity = calculateQuantity(result.symbol, result.price);
+        Quantity quantity = calculateQuantity(result.symbol, Price::fromDouble(result.price));
         
-        if (quantity > 0) {
+        if (quantity.isPositive()) {
             // Enter with market order
-            if (buy(result.symbol, quantity, 0.0)) {
+            if (buy(result.symbol, quantity, Price(), result.exchange_name)) {
                 std::lock_guard<std::mutex> lock(chase_mutex_);
-                auto& entry = chase_entries_[result.symbol];
+                auto& entry = chase_entries_[result.symbol_id];
                 entry.entry_price = result.price;
                 entry.high_water_mark = result.price;
                 entry.entry_volume_ratio = result.volume_ratio;
                 entry.entry_score = result.score;
                 entry.entry_time_ms = currentTimeMs();
+                entry.market = result.exchange ? result.exchange->getMarket() : "";
                 
                 std::stringstream log_ss;
                 log_ss << "CHASE ENTER: " << result.symbol 
@@ -88,15 +90,16 @@ void MomentumStrategy::onKLine(const std::string& symbol, const KlineData& kline
     if (!running_) return;
     
     const auto& params = ConfigManager::getInstance().getConfig().strategy.momentum;
+    SymbolId symbol_id = SymbolRegistry::getInstance().resolve(kline.symbol_id, kline.exchange, symbol);
     auto& pos_mgr = PositionManager::getInstance();
-    Position* pos = pos_mgr.getPosition(symbol);
-    if (!pos || pos->quantity <= 0) return;
+    Position* pos = pos_mgr.getPosition(symbol_id);
+    if (!pos || !pos->quantity.isPositive()) return;
     
     std::lock_guard<std::mutex> lock(chase_mutex_);
-    auto it = chase_entries_.find(symbol);
-    if (it == chase_entries_.end()) return;
+    ChaseEntry* tracked = chase_entries_.find(symbol_id);
+    if (tracked == nullptr) return;
     
-    auto& entry = it->second;
+    auto& entry = *tracked;
     double current_price = kline.close_price;
     
     // Update high-water mark
@@ -105,7 +108,9 @@ void MomentumStrategy::onKLine(const std::string& symbol, const KlineData& kline
     // Compute various exit metrics
     double pnl_ratio = (current_price - entry.entry_price) / entry.entry_price;
     double drawdown_from_high = (entry.high_water_mark - current_price) / entry.high_water_mark;
-    double elapsed_min = (currentTimeMs() - entry.entry_time_ms) / 60000.0;
+    // Only session time counts: a position held over lunch or overnight is not stale
+    double elapsed_min = TradingCalendar::getInstance().sessionSeconds(
+        entry.market, entry.entry_time_ms * 1000000, currentTimeMs() * 1000000) / 60.0;
     
     bool should_exit = false;
     std::string exit_reason;
@@ -147,7 +152,7 @@ void MomentumStrategy::onKLine(const std::string& symbol, const KlineData& kline
     }
     
     if (should_exit) {
-        sell(symbol, pos->quantity, 0.0);
+        sell(symbol, pos->quantity, Price(), SymbolRegistry::getInstance().exchange(symbol_id));
         unsubscribeStock(symbol);
         
         std::stringstream ss;
@@ -158,7 +163,7 @@ void MomentumStrategy::onKLine(const std::string& symbol, const KlineData& kline
            << " pnl=" << (pnl_ratio * 100) << "%";
         LOG_INFO(ss.str());
         
-        chase_entries_.erase(it);
+        chase_entries_.erase(symbol_id);
     }
 }
 
@@ -168,10 +173,11 @@ void MomentumStrategy::onTick(const std::string& symbol, const TickData& tick) {
     if (!running_) return;
     
     // Update high-water mark on Tick level (higher-frequency tracking)
+    SymbolId symbol_id = SymbolRegistry::getInstance().resolve(tick.symbol_id, tick.exchange, symbol);
     std::lock_guard<std::mutex> lock(chase_mutex_);
-    auto it = chase_entries_.find(symbol);
-    if (it != chase_entries_.end()) {
-        it->second.high_water_mark = std::max(it->second.high_water_mark, tick.last_price);
+    ChaseEntry* entry = chase_entries_.find(symbol_id);
+    if (entry != nullptr) {
+        entry->high_water_mark = std::max(entry->high_water_mark, tick.last_price);
     }
 }
 
@@ -180,20 +186,21 @@ void MomentumStrategy::onSnapshot(const Snapshot& snapshot) {
 
     if (!running_) return;
     
+    SymbolId symbol_id = SymbolRegistry::getInstance().resolve(snapshot.symbol_id, snapshot.exchange, snapshot.symbol);
     auto& pos_mgr = PositionManager::getInstance();
-    pos_mgr.updateMarketPrice(snapshot.symbol, snapshot.last_price);
+    pos_mgr.updateMarketPrice(symbol_id, Price::fromDouble(snapshot.last_price));
     
     // Real-time checks for chase positions
-    Position* pos = pos_mgr.getPosition(snapshot.symbol);
-    if (!pos || pos->quantity <= 0) return;
+    Position* pos = pos_mgr.getPosition(symbol_id);
+    if (!pos || !pos->quantity.isPositive()) return;
     
     const auto& params = ConfigManager::getInstance().getConfig().strategy.momentum;
     
     std::lock_guard<std::mutex> lock(chase_mutex_);
-    auto it = chase_entries_.find(snapshot.symbol);
-    if (it == chase_entries_.end()) return;
+    ChaseEntry* tracked = chase_entries_.find(symbol_id);
+    if (tracked == nullptr) return;
     
-    auto& entry = it->second;
+    auto& entry = *tracked;
     double current_price = snapshot.last_price;
     
         // Update high-water mark
@@ -203,7 +210,7 @@ void MomentumStrategy::onSnapshot(const Snapshot& snapshot) {
     
     // Real-time hard stop check (snapshot is timelier than K-line)
     if (pnl_ratio <= -params.chase_hard_stop_loss) {
-        sell(snapshot.symbol, pos->quantity, 0.0);
+        sell(snapshot.symbol, pos->quantity, Price(), SymbolRegistry::getInstance().exchange(symbol_id));
         unsubscribeStock(snapshot.symbol);
         
         std::stringstream ss;
@@ -212,7 +219,7 @@ void MomentumStrategy::onSnapshot(const Snapshot& snapshot) {
            << " loss=" << (pnl_ratio * 100) << "%";
         LOG_INFO(ss.str());
         
-        chase_entries_.erase(it);
+        chase_entries_.erase(symbol_id);
     }
 }
 
@@ -270,14 +277,14 @@ bool MomentumStrategy::shouldEnter(const ScanResult& result, const std::vector<K
     return true;
 }
 
-bool MomentumStrategy::shouldChaseExit(const std::string& symbol, double current_price, double speed) {
+bool MomentumStrategy::shouldChaseExit(SymbolId symbol_id, double current_price, double speed) {
     const auto& params = ConfigManager::getInstance().getConfig().strategy.momentum;
     
     std::lock_guard<std::mutex> lock(chase_mutex_);
-    auto it = chase_entries_.find(symbol);
-    if (it == chase_entries_.end()) return false;
+    const ChaseEntry* tracked = chase_entries_.find(symbol_id);
+    if (tracked == nullptr) return false;
     
-    auto& entry = it->second;
+    const auto& entry = *tracked;
     double pnl_ratio = (current_price - entry.entry_price) / entry.entry_price;
     double drawdown = (entry.high_water_mark - current_price) / entry.high_water_mark;
     
@@ -294,7 +301,7 @@ bool MomentumStrategy::shouldChaseExit(const std::string& symbol, double current
     return false;
 }
 
-int MomentumStrategy::calculateQuantity(const std::string& symbol, double price) {
+Quantity MomentumStrategy::calculateQuantity(const std::string& symbol, Price price) {
     (void)symbol;
     
     auto& risk_mgr = RiskManager::getInstance();
@@ -303,13 +310,13 @@ int MomentumStrategy::calculateQuantity(const std::string& symbol, double price)
     // Allocate 20% of the allowed position budget to a single stock
     double position_budget = config.trading.max_position_size * 0.2;
     
-    int quantity = risk_mgr.calculatePositionSize(price, position_budget);
+    int64_t quantity = risk_mgr.calculatePositionSize(price, Amount::fromDouble(position_budget)).value();
     
     // Hong Kong minimum lot size is 100 shares
     quantity = (quantity / 100) * 100;
     if (quantity < 100) quantity = 100;
     
-    return quantity;
+    return Quantity(quantity);
 }
 
 int64_t MomentumStrategy::currentTimeMs() const {
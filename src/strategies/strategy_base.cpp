@@ -35,7 +35,7 @@ void StrategyBase::stop() {
     // Unsubscribe from all subscriptions
     auto& subscriber = DataSubscriber::getInstance();
     for (const auto& pair : subscribed_stocks_) {
-        subscriber.unsubscribeKLine(pair.first);
+        subscriber.unsubscribeKLine(pair.first, "K_5M");
         subscriber.unsubscribeTick(pair.first);
     }
     subscribed_stocks_.clear();
@@ -50,7 +50,7 @@ void StrategyBase::onKLine(const std::string& symbol, const KlineData& kline) {
     (void)symbol;
     (void)kline;
 
-    LOG_INFO("Strategy " + name_ + " received KLine data for " + symbol);
+    LOG_INFO_THROTTLED(10, 60000, "Strategy " + name_ + " received KLine data for " + symbol);
 }
 
 void StrategyBase::onTick(const std::string& symbol, const TickData& tick) {
@@ -58,14 +58,14 @@ void StrategyBase::onTick(const std::string& symbol, const TickData& tick) {
     (void)symbol;
     (void)tick;
 
-    LOG_INFO("Strategy " + name_ + " received Tick data for " + symbol);
+    LOG_INFO_EVERY_N(500, "Strategy " + name_ + " received Tick data for " + symbol);
 }
 
 void StrategyBase::onSnapshot(const Snapshot& snapshot) {
     // Default implementation is empty; subclasses may override
     (void)snapshot;
 
-    LOG_INFO("Strategy " + name_ + " received Snapshot data");
+    LOG_INFO_THROTTLED(10, 60000, "Strategy " + name_ + " received Snapshot data");
 }
 
 void StrategyBase::subscribeStock(const std::string& symbol) {
@@ -93,7 +93,7 @@ void StrategyBase::unsubscribeStock(const std::string& symbol) {
     }
     
     auto& subscriber = DataSubscriber::getInstance();
-    subscriber.unsubscribeKLine(symbol);
+    subscriber.unsubscribeKLine(symbol, "K_5M");
     subscriber.unsubscribeTick(symbol);
     
     subscribed_stocks_.erase(it);
@@ -103,18 +103,19 @@ void StrategyBase::unsubscribeStock(const std::string& symbol) {
     LOG_INFO(ss.str());
 }
 
-bool StrategyBase::buy(const std::string& symbol, int quantity, double price) {
+bool StrategyBase::buy(const std::string& symbol, Quantity quantity, Price price, const std::string& exchange) {
     auto& executor = OrderExecutor::getInstance();
     
     // Use market order if price is 0
-    OrderType order_type = (price == 0.0) ? OrderType::MARKET : OrderType::LIMIT;
+    OrderType order_type = price.isZero() ? OrderType::MARKET : OrderType::LIMIT;
     
     std::string order_id = executor.placeOrder(
         symbol,
         OrderSide::BUY,
         quantity,
         order_type,
-        price
+        price,
+        exchange
     );
     
     if (order_id.empty()) {
@@ -131,18 +132,19 @@ bool StrategyBase::buy(const std::string& symbol, int quantity, double price) {
     return true;
 }
 
-bool StrategyBase::sell(const std::string& symbol, int quantity, double price) {
+bool StrategyBase::sell(const std::string& symbol, Quantity quantity, Price price, const std::string& exchange) {
     auto& executor = OrderExecutor::getInstance();
     
     // Use market order if price is 0
-    OrderType order_type = (price == 0.0) ? OrderType::MARKET : OrderType::LIMIT;
+    OrderType order_type = price.isZero() ? OrderType::MARKET : OrderType::LIMIT;
     
     std::string order_id = executor.placeOrder(
         symbol,
         OrderSide::SELL,
         quantity,
         order_type,
-        price
+        price,
+        exchange
     );
     
     if (order_id.empty()) {
@@ -1,6 +1,7 @@
 #include "trading/order_executor.h"
 #include "managers/position_manager.h"
 #include "managers/risk_manager.h"
+#include "trading/tick_size_table.h"
 #include "utils/logger.h"
 #include <sstream>
 #include <chrono>
@@ -17,15 +18,22 @@ OrderExecutor& OrderExecutor::getInstance() {
 std::string OrderExecutor::placeOrder(
     const std::string& symbol,
     OrderSide side,
-    int quantity,
+    Quantity quantity,
     OrderType type,
-    double price) {
+    Price price,
+    const std::string& exchange) {
     
     std::lock_guard<std::mutex> lock(mutex_);
     
+    // Limit prices must sit on the instrument's tick grid
+    if (type == OrderType::LIMIT) {
+        SymbolId symbol_id = SymbolRegistry::getInstance().resolve(kInvalidSymbolId, exchange, symbol);
+        price = TickSizeTable::getInstance().round(symbol_id, price);
+    }
+    
     // Risk check
     auto& risk_mgr = RiskManager::getInstance();
-    int signed_qty = (side == OrderSide::BUY) ? quantity : -quantity;
+    Quantity signed_qty = (side == OrderSide::BUY) ? quantity : -quantity;
     
     if (!risk_mgr.checkOrderRisk(symbol, signed_qty, price)) {
         LOG_ERROR("Order rejected by risk manager");
@@ -36,12 +44,13 @@ std::string OrderExecutor::placeOrder(
     OrderData order;
     order.order_id = generateOrderId();
     order.symbol = symbol;
+    order.exchange = exchange;
     order.type = type;
     order.direction = (side == OrderSide::BUY) ? Direction::LONG : Direction::SHORT;
     order.volume = quantity;
     order.price = price;
     order.status = OrderStatus::SUBMITTING;
-    order.traded_volume = 0;
+    order.traded_volume = Quantity();
     
     auto now = std::chrono::system_clock::now();
     order.create_time = std::chrono::system_clock::to_time_t(now) * 1000;
@@ -135,10 +144,10 @@ void OrderExecutor::onOrderUpdate(const OrderData& order) {
         order.status == OrderStatus::PARTIAL_FILLED) {
         
         auto& pos_mgr = PositionManager::getInstance();
-        int signed_qty = (order.direction == Direction::LONG) ? 
+        Quantity signed_qty = (order.direction == Direction::LONG) ? 
             order.traded_volume : -order.traded_volume;
         
-        pos_mgr.updatePosition(order.symbol, signed_qty, order.price);
+        pos_mgr.updatePosition(order.symbol, signed_qty, order.price, order.exchange);
         
         std::stringstream ss;
         ss << "Order filled: " << order.order_id << " " << order.traded_volume 
@@ -0,0 +1,92 @@
+#include "trading/tick_size_table.h"
+#include "exchange/exchange_manager.h"
+
+namespace {
+
+// Market of the exchange the symbol was interned under; empty if unknown
+std::string symbolMarket(SymbolId symbol_id) {
+    auto& registry = SymbolRegistry::getInstance();
+    if (!registry.valid(symbol_id) || registry.exchange(symbol_id).empty()) {
+        return "";
+    }
+    auto exchange = ExchangeManager::getInstance().getExchange(registry.exchange(symbol_id));
+    return exchange ? exchange->getMarket() : "";
+}
+
+}  // namespace
+
+TickSizeTable& TickSizeTable::getInstance() {
+    static TickSizeTable instance;
+    return instance;
+}
+
+void TickSizeTable::setTickSize(SymbolId symbol_id, Price tick) {
+    if (symbol_id == kInvalidSymbolId || !tick.isPositive()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ticks_[symbol_id] = tick;
+}
+
+void TickSizeTable::setTickSizes(const std::vector<std::pair<SymbolId, Price>>& ticks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : ticks) {
+        if (entry.first == kInvalidSymbolId || !entry.second.isPositive()) continue;
+        ticks_[entry.first] = entry.second;
+    }
+}
+
+Price TickSizeTable::tickSize(SymbolId symbol_id, Price price) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Price* tick = ticks_.find(symbol_id);
+        if (tick != nullptr) {
+            return *tick;
+        }
+    }
+    return marketTickSize(symbolMarket(symbol_id), price);
+}
+
+Price TickSizeTable::round(SymbolId symbol_id, Price price) const {
+    return roundToTick(price, tickSize(symbol_id, price));
+}
+
+Price TickSizeTable::marketTickSize(const std::string& market, Price price) {
+    if (market == "HK") {
+        return hkTickSize(price);
+    }
+    if (market == "US") {
+        // Sub-dollar quotes trade in hundredths of a cent
+        return price.raw() < Price::fromDouble(1.0).raw() ? Price::fromDouble(0.0001) : Price::fromDouble(0.01);
+    }
+    if (market == "CN" || market == "SH" || market == "SZ") {
+        return Price::fromDouble(0.01);
+    }
+    return Price();
+}
+
+Price TickSizeTable::hkTickSize(Price price) {
+    // Upper bound (inclusive) of each price band and its tick, in raw units
+    struct Band {
+        int64_t upper;
+        int64_t tick;
+    };
+    static constexpr Band kBands[] = {
+        {   250000,     1000},   //    0.01 -    0.25 : 0.001
+        {   500000,     5000},   //    0.25 -    0.50 : 0.005
+        { 10000000,    10000},   //    0.50 -   10.00 : 0.010
+        { 20000000,    20000},   //   10.00 -   20.00 : 0.020
+        {100000000,    50000},   //   20.00 -  100.00 : 0.050
+        {200000000,   100000},   //  100.00 -  200.00 : 0.100
+        {500000000,   200000},   //  200.00 -  500.00 : 0.200
+        {1000000000,  500000},   //  500.00 - 1000.00 : 0.500
+        {2000000000, 1000000},   // 1000.00 - 2000.00 : 1.000
+        {5000000000, 2000000},   // 2000.00 - 5000.00 : 2.000
+    };
+
+    for (const auto& band : kBands) {
+        if (price.raw() <= band.upper) {
+            return Price::fromRaw(band.tick);
+        }
+    }
+    return Price::fromRaw(5000000);  // 5000.00 - 9995.00 : 5.000
+}
@@ -8,51 +8,31 @@
 #include <iomanip>
 #include <ctime>
 
-#ifdef _WIN32
-    #include <direct.h>
-    #define CREATE_DIR(path) _mkdir(path)
-#else
-    #include <sys/stat.h>
-    #define CREATE_DIR(path) mkdir(path, 0755)
-#endif
-
 Logger& Logger::getInstance() {
     static Logger instance;
     return instance;
 }
 
 Logger::Logger() {
-    // Create logs directory (if it doesn't exist)
-    // Cross-platform support: Windows (_mkdir) and Unix/macOS (mkdir)
-    try {
-        CREATE_DIR("logs");
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to create logs directory: " << e.what() << std::endl;
-    }
-    
-    // Open log file with timestamp to distinguish each run
-    auto now = std::chrono::system_clock::now();
-    std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-    std::tm tm;
-#ifdef _WIN32
-    localtime_s(&tm, &now_c);
-#else
-    localtime_r(&now_c, &tm);
-#endif
-    std::stringstream ts_ss;
-    ts_ss << std::put_time(&tm, "%Y%m%d_%H%M%S");
-    std::string timestamp = ts_ss.str();
-
-    std::string log_path = "logs/trading_system_" + timestamp + ".log";
-    log_file_.open(log_path, std::ios::app);
-    if (!log_file_.is_open()) {
-        std::cerr << "Failed to open log file: " << log_path << std::endl;
-    }
 }
 
 Logger::~Logger() {
-    if (log_file_.is_open()) {
-        log_file_.close();
+    log_file_.close();
+}
+
+void Logger::configure(LogLevel level, bool console, bool file, const RotatingLogFile::Options& file_options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    min_level_ = level;
+    console_enabled_ = console;
+    file_enabled_ = file;
+    file_options_ = file_options;
+
+    // Reopen so the new directory and segment settings take effect
+    log_file_.close();
+    if (file_enabled_ && !log_file_.open(file_options_)) {
+        std::cerr << "Failed to open log file in: " << file_options_.dir << std::endl;
+        file_enabled_ = false;
     }
 }
 
@@ -64,12 +44,18 @@ void Logger::log(LogLevel level, const std::string& message) {
     std::string log_entry = getCurrentTime() + " [" + levelToString(level) + "] " + message;
     
     // Output to console
-    PrintToConsole(log_entry);
+    if (console_enabled_) {
+        PrintToConsole(log_entry);
+    }
 
-    // Output to file
-    if (log_file_.is_open()) {
-        log_file_ << log_entry << std::endl;
-        log_file_.flush();
+    // Output to file; segments are written in bulk, no per-line flush
+    if (file_enabled_) {
+        if (!log_file_.isOpen() && !log_file_.open(file_options_)) {
+            file_enabled_ = false;
+            return;
+        }
+        log_entry.push_back('\n');
+        log_file_.write(log_entry.data(), log_entry.size());
     }
 }
 
@@ -0,0 +1,255 @@
+#include "utils/rotating_log_file.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+#endif
+
+#ifdef QTS_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace {
+
+int64_t steadySeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string localTimestamp() {
+    std::time_t now_c = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &now_c);
+#else
+    localtime_r(&now_c, &tm);
+#endif
+    std::stringstream ss;
+    ss << std::put_time(&tm, "%Y%m%d_%H%M%S");
+    return ss.str();
+}
+
+} // namespace
+
+RotatingLogFile::~RotatingLogFile() {
+    close();
+}
+
+bool RotatingLogFile::open(const Options& options) {
+    close();
+
+    options_ = options;
+    if (options_.dir.empty()) {
+        options_.dir = ".";
+    }
+    if (options_.segment_bytes < 64 * 1024) {
+        options_.segment_bytes = 64 * 1024;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(options_.dir, ec);
+    if (ec) {
+        std::cerr << "Failed to create log directory " << options_.dir << ": " << ec.message() << std::endl;
+        return false;
+    }
+
+    run_timestamp_ = localTimestamp();
+    segment_seq_ = 0;
+
+    if (options_.compress_rotated) {
+#ifdef QTS_HAVE_ZLIB
+        compress_stop_ = false;
+        compress_thread_ = std::thread(&RotatingLogFile::compressionLoop, this);
+#else
+        std::cerr << "Log segment compression requested but zlib is not available; "
+                     "rotated segments will be kept uncompressed" << std::endl;
+#endif
+    }
+
+    return openSegment(options_.segment_bytes);
+}
+
+void RotatingLogFile::close() {
+    closeSegment();
+
+    if (compress_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(compress_mutex_);
+            compress_stop_ = true;
+        }
+        compress_cv_.notify_all();
+        compress_thread_.join();
+    }
+}
+
+void RotatingLogFile::write(const char* data, size_t len) {
+    if (!segment_open_) return;
+
+    bool expired = options_.rotate_interval_seconds > 0 &&
+                   steadySeconds() - segment_opened_at_ >= options_.rotate_interval_seconds;
+    if (expired || segment_used_ + len > segment_capacity_) {
+        std::string rotated = segment_path_;
+        closeSegment();
+        enqueueCompression(rotated);
+        // A single oversized line gets a segment large enough to hold it
+        if (!openSegment(std::max(options_.segment_bytes, len))) return;
+    }
+
+#ifdef _WIN32
+    stream_.write(data, static_cast<std::streamsize>(len));
+#else
+    if (mapped_) {
+        std::memcpy(mapped_ + segment_used_, data, len);
+    } else {
+        size_t written = 0;
+        while (written < len) {
+            ssize_t n = ::write(fd_, data + written, len - written);
+            if (n <= 0) break;
+            written += static_cast<size_t>(n);
+        }
+    }
+#endif
+    segment_used_ += len;
+}
+
+std::string RotatingLogFile::nextSegmentPath() {
+    std::stringstream name;
+    name << options_.base_name << "_" << run_timestamp_ << "_"
+         << std::setfill('0') << std::setw(4) << segment_seq_++ << ".log";
+    return (std::filesystem::path(options_.dir) / name.str()).string();
+}
+
+bool RotatingLogFile::openSegment(size_t min_bytes) {
+    segment_path_ = nextSegmentPath();
+    segment_capacity_ = min_bytes;
+    segment_used_ = 0;
+    segment_opened_at_ = steadySeconds();
+
+#ifdef _WIN32
+    // No mmap on Windows: a large user-space buffer gives the same batching
+    stream_buffer_.resize(1 << 20);
+    stream_.rdbuf()->pubsetbuf(&stream_buffer_[0], static_cast<std::streamsize>(stream_buffer_.size()));
+    stream_.open(segment_path_, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream_.is_open()) {
+        std::cerr << "Failed to open log file: " << segment_path_ << std::endl;
+        return false;
+    }
+#else
+    fd_ = ::open(segment_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Failed to open log file: " << segment_path_ << std::endl;
+        return false;
+    }
+
+    // Preallocate the whole segment so the mapping never hits a hole mid-write
+#ifdef __linux__
+    bool sized = ::posix_fallocate(fd_, 0, static_cast<off_t>(segment_capacity_)) == 0;
+#else
+    bool sized = ::ftruncate(fd_, static_cast<off_t>(segment_capacity_)) == 0;
+#endif
+    if (sized) {
+        void* addr = ::mmap(nullptr, segment_capacity_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        mapped_ = addr == MAP_FAILED ? nullptr : static_cast<char*>(addr);
+    }
+    if (!mapped_) {
+        std::cerr << "mmap unavailable for " << segment_path_ << ", falling back to write()" << std::endl;
+        if (sized && ::ftruncate(fd_, 0) != 0) {
+            std::cerr << "Failed to reset log file: " << segment_path_ << std::endl;
+        }
+    }
+#endif
+
+    segment_open_ = true;
+    return true;
+}
+
+void RotatingLogFile::closeSegment() {
+    if (!segment_open_) return;
+    segment_open_ = false;
+
+#ifdef _WIN32
+    stream_.close();
+#else
+    if (mapped_) {
+        ::munmap(mapped_, segment_capacity_);
+        mapped_ = nullptr;
+        // Drop the unused preallocated tail
+        if (::ftruncate(fd_, static_cast<off_t>(segment_used_)) != 0) {
+            std::cerr << "Failed to truncate log file: " << segment_path_ << std::endl;
+        }
+    }
+    ::close(fd_);
+    fd_ = -1;
+#endif
+}
+
+void RotatingLogFile::enqueueCompression(const std::string& path) {
+    if (!compress_thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(compress_mutex_);
+        compress_queue_.push_back(path);
+    }
+    compress_cv_.notify_one();
+}
+
+void RotatingLogFile::compressionLoop() {
+    while (true) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(compress_mutex_);
+            compress_cv_.wait(lock, [this] { return compress_stop_ || !compress_queue_.empty(); });
+            // Drain pending segments before honoring stop
+            if (compress_queue_.empty()) break;
+            path = std::move(compress_queue_.front());
+            compress_queue_.pop_front();
+        }
+        if (!compressFile(path)) {
+            std::cerr << "Failed to compress log segment: " << path << std::endl;
+        }
+    }
+}
+
+bool RotatingLogFile::compressFile(const std::string& path) {
+#ifdef QTS_HAVE_ZLIB
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    std::string gz_path = path + ".gz";
+    gzFile out = gzopen(gz_path.c_str(), "wb6");
+    if (!out) return false;
+
+    std::vector<char> buffer(1 << 20);
+    bool ok = true;
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize n = in.gcount();
+        if (n > 0 && gzwrite(out, buffer.data(), static_cast<unsigned>(n)) != n) {
+            ok = false;
+            break;
+        }
+    }
+    ok = gzclose(out) == Z_OK && ok;
+    in.close();
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::remove(path, ec);
+    } else {
+        std::filesystem::remove(gz_path, ec);
+    }
+    return ok;
+#else
+    (void)path;
+    return true;
+#endif
+}